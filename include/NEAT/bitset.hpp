@@ -0,0 +1,53 @@
+// bitset.hpp
+
+#ifndef NEAT_BITSET_HPP
+#define NEAT_BITSET_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+using std::vector;
+
+// Growable bitset packed into 64-bit words. It does not store its own
+// size: it is always kept parallel to a gene vector that already does.
+class BitSet {
+    public:
+        bool test(size_t i) const {
+            return (_words[i >> 6] >> (i & 63)) & 1u;
+        }
+
+        void set(size_t i, bool value) {
+            uint64_t mask = uint64_t{1} << (i & 63);
+            if (value) {
+                _words[i >> 6] |= mask;
+            } else {
+                _words[i >> 6] &= ~mask;
+            }
+        }
+
+        // Set bit i, growing the storage if needed
+        void assign(size_t i, bool value) {
+            if ((i >> 6) >= _words.size()) {
+                _words.resize((i >> 6) + 1, 0);
+            }
+            set(i, value);
+        }
+
+        void reserve(size_t bits) {
+            _words.reserve((bits + 63) / 64);
+        }
+
+        void clear() {
+            _words.clear();
+        }
+
+        size_t memory_footprint() const {
+            return _words.capacity() * sizeof(uint64_t);
+        }
+
+    private:
+        vector<uint64_t> _words;
+};
+
+#endif // NEAT_BITSET_HPP
@@ -0,0 +1,115 @@
+// checkpoint.hpp
+
+#ifndef NEAT_CHECKPOINT_HPP
+#define NEAT_CHECKPOINT_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include "NEAT/population.hpp"
+
+using std::string;
+
+// Binary checkpoint of a whole population, to resume a run after it
+// stops or crashes. The parameters are not part of it: a run is resumed
+// with the same config file. Numbers are stored in host byte order, and
+// every section is 8-byte aligned, so the file is read in place once it
+// is mapped in memory.
+//
+// Layout:
+// - header (80): magic "NEATCKPT", version (4), byte order mark (4),
+//   inputs (4), outputs (4), next genome id (4), reserved (4),
+//   generation (8), genome, species, neuron and link counts (8 each),
+//   file size (8)
+// - RNG state of the population (48)
+// - genome table, population then species then the best genome (48
+//   each): id (4), hidden neurons (4), next neuron id (4), fitness (4),
+//   parent id (4), mate id (4), first neuron (8), first link (8), neuron
+//   count (4), link count (4)
+// - the neurons of all genomes, in table order (12 each): id (4),
+//   bias (4), activation (1), padding (3)
+// - the links of all genomes, 8-byte aligned (16 each): input (4),
+//   output (4), weight (4), enabled flag (1), padding (3)
+//
+// Removed genes are kept as tombstones, so a resumed run makes exactly
+// the same draws as one that never stopped. The state of the evaluator,
+// e.g. the novelty archive, is not saved; episode seeds only depend on
+// the generation, see SeedSchedule::seek().
+constexpr uint32_t CheckpointVersion = 3;
+
+// Write a checkpoint atomically: to a temporary file next to path,
+// flushed to disk, then renamed over path, so path always holds a whole
+// checkpoint. Throws std::runtime_error if it cannot be written.
+void write_checkpoint(const string &path, const PopulationState &state);
+
+// Writes checkpoints on a background thread, so a run only pauses for
+// Population::state(). If a checkpoint is still being written when the
+// next one comes, only the newest waiting one is written after it.
+class CheckpointWriter {
+    public:
+        explicit CheckpointWriter(const string &path);
+        // Finishes the waiting checkpoint first
+        ~CheckpointWriter();
+        CheckpointWriter(const CheckpointWriter &) = delete;
+        CheckpointWriter &operator=(const CheckpointWriter &) = delete;
+
+        // Rethrows the error of the last failed write, if any
+        void save(PopulationState state);
+        // Block until every saved checkpoint is on disk. Rethrows the
+        // error of the last failed write, if any.
+        void wait();
+        size_t num_written() const;
+
+    private:
+        string path;
+        std::optional<PopulationState> waiting;
+        bool writing = false;
+        bool stopping = false;
+        size_t _num_written = 0;
+        std::exception_ptr error;
+        mutable std::mutex mutex;
+        std::condition_variable changed;
+        std::thread thread;
+
+        void run();
+        void rethrow_error();
+};
+
+// Read-only view of a checkpoint mapped in memory. Opening it only checks
+// the header, whatever the size of the population; genomes are decoded
+// when asked for.
+class Checkpoint {
+    public:
+        // Throws std::runtime_error if the file cannot be read,
+        // std::invalid_argument if it is not a checkpoint of this version
+        explicit Checkpoint(const string &path);
+        ~Checkpoint();
+        Checkpoint(const Checkpoint &) = delete;
+        Checkpoint &operator=(const Checkpoint &) = delete;
+
+        uint64_t generation() const;
+        size_t num_genomes() const;
+        size_t num_species() const;
+
+        // Throw std::invalid_argument if the genes are malformed, or the
+        // config has other inputs or outputs than the checkpoint
+        Genome genome(size_t index, const shared_ptr<const GenomeConfig> &genome_config) const;
+        Genome species(size_t index, const shared_ptr<const GenomeConfig> &genome_config) const;
+        Genome best(const shared_ptr<const GenomeConfig> &genome_config) const;
+        // The whole state, decoded on several threads, e.g. for
+        // Population(params, checkpoint.load(genome_config))
+        PopulationState load(const shared_ptr<const GenomeConfig> &genome_config,
+            unsigned num_threads = std::thread::hardware_concurrency()) const;
+
+    private:
+        const uint8_t *data;
+        size_t size;
+
+        Genome decode(size_t record, const shared_ptr<const GenomeConfig> &genome_config) const;
+};
+
+#endif // NEAT_CHECKPOINT_HPP
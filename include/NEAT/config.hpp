@@ -8,6 +8,7 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <stdexcept>
 
 using std::string, std::unordered_map, std::ifstream,
       std::ofstream, std::stoi, std::to_string, 
@@ -16,6 +17,11 @@ using std::string, std::unordered_map, std::ifstream,
 
 class Config {
     public:
+        using Settings = unordered_map<string, unordered_map<string,string>>;
+
+        // Empty, with no file behind it, e.g. to be filled in code
+        Config() = default;
+        // Throws std::runtime_error if the file cannot be read
         Config(const string &filename);
         bool load();
         bool save(const string &filename) const;
@@ -36,9 +42,7 @@ class Config {
             const string &key, 
             const string &default_value) const;
 
-        int population_size() const { return _population_size; }
-        int max_generations() const { return _max_generations; }
-        float survival_threshold() const { return _survival_threshold; }
+        const Settings &getSettings() const;
 
         // Setters
         void setInt(
@@ -58,12 +62,7 @@ class Config {
 
     private:
         string filename;
-        unordered_map<string, unordered_map<string,string>> settings;
-
-        // NEAT parameters
-        int _population_size;
-        int _max_generations;
-        float _survival_threshold;
+        Settings settings;
 
         void parseLine(const string &line, string &current_section);
 
@@ -0,0 +1,264 @@
+// cow_vector.hpp
+
+#ifndef NEAT_COW_VECTOR_HPP
+#define NEAT_COW_VECTOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Persistent vector split into fixed size chunks. Copies share all
+// their chunks, and a chunk is only cloned when it is written while
+// still shared, so a copy costs one pointer per chunk.
+//
+// Each chunk holds its reference count in the same allocation as its
+// elements, and grows up to ChunkSize as elements are added, so a small
+// vector does not pay for a whole chunk. While there is a single chunk,
+// its pointer is stored in the vector itself instead of in a table.
+template <typename T, size_t ChunkSize = 16>
+class CowVector {
+    static_assert((ChunkSize & (ChunkSize - 1)) == 0,
+        "ChunkSize must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value,
+        "Chunks are cloned bytewise");
+
+    struct Chunk {
+        std::atomic<uint32_t> refs;
+        uint32_t capacity;
+
+        explicit Chunk(uint32_t capacity) : refs(1), capacity(capacity) {}
+
+        T *items() { return reinterpret_cast<T *>(this + 1); }
+        const T *items() const { return reinterpret_cast<const T *>(this + 1); }
+    };
+    static_assert(alignof(T) <= alignof(Chunk) && sizeof(Chunk) % alignof(T) == 0,
+        "Elements must be aligned after the chunk header");
+
+    // Capacity of a new chunk, unless more were reserved
+    static constexpr size_t MIN_CAPACITY = std::min<size_t>(4, ChunkSize);
+
+    public:
+        class const_iterator {
+            public:
+                using iterator_category = std::random_access_iterator_tag;
+                using value_type = T;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const T*;
+                using reference = const T&;
+
+                const_iterator() : vec(nullptr), i(0) {}
+                const_iterator(const CowVector *vec, size_t i) : vec(vec), i(i) {}
+
+                reference operator*() const { return (*vec)[i]; }
+                pointer operator->() const { return &(*vec)[i]; }
+                reference operator[](difference_type n) const { return (*vec)[i + n]; }
+
+                const_iterator &operator++() { i++; return *this; }
+                const_iterator &operator--() { i--; return *this; }
+                const_iterator operator++(int) { const_iterator copy = *this; i++; return copy; }
+                const_iterator operator--(int) { const_iterator copy = *this; i--; return copy; }
+                const_iterator &operator+=(difference_type n) { i += n; return *this; }
+                const_iterator &operator-=(difference_type n) { i -= n; return *this; }
+                const_iterator operator+(difference_type n) const { return {vec, i + n}; }
+                const_iterator operator-(difference_type n) const { return {vec, i - n}; }
+                friend const_iterator operator+(difference_type n, const const_iterator &it) {
+                    return it + n;
+                }
+                difference_type operator-(const const_iterator &rhs) const {
+                    return (difference_type) i - (difference_type) rhs.i;
+                }
+
+                bool operator==(const const_iterator &rhs) const { return i == rhs.i; }
+                bool operator!=(const const_iterator &rhs) const { return i != rhs.i; }
+                bool operator<(const const_iterator &rhs) const { return i < rhs.i; }
+                bool operator>(const const_iterator &rhs) const { return i > rhs.i; }
+                bool operator<=(const const_iterator &rhs) const { return i <= rhs.i; }
+                bool operator>=(const const_iterator &rhs) const { return i >= rhs.i; }
+
+            private:
+                const CowVector *vec;
+                size_t i;
+        };
+
+        CowVector() : _one(nullptr) {}
+
+        // Shares every chunk of other. The copy reserves nothing.
+        CowVector(const CowVector &other) : _one(nullptr), _size(other._size) {
+            const Chunk *const *from = other.table();
+            if (extent() > ChunkSize) {
+                _table = new Chunk *[slots(extent())];
+            }
+            Chunk **to = table();
+            for (size_t k = 0; k < num_chunks(); k++) {
+                to[k] = const_cast<Chunk *>(from[k]);
+                to[k]->refs.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        CowVector(CowVector &&other) noexcept :
+            _one(other._one), _size(other._size), _reserved(other._reserved) {
+            other._one = nullptr;
+            other._size = 0;
+            other._reserved = 0;
+        }
+
+        CowVector &operator=(CowVector other) noexcept {
+            std::swap(_one, other._one);
+            std::swap(_size, other._size);
+            std::swap(_reserved, other._reserved);
+            return *this;
+        }
+
+        ~CowVector() {
+            clear();
+        }
+
+        size_t size() const { return _size; }
+        bool empty() const { return _size == 0; }
+
+        const T &operator[](size_t i) const {
+            return table()[i / ChunkSize]->items()[i % ChunkSize];
+        }
+
+        // Writable access, cloning the chunk first if it is shared
+        T &mut(size_t i) {
+            size_t k = i / ChunkSize;
+            Chunk *&chunk = table()[k];
+            own(chunk, chunk_size(k), chunk->capacity);
+            return chunk->items()[i % ChunkSize];
+        }
+
+        void push_back(const T &value) {
+            size_t k = _size / ChunkSize, offset = _size % ChunkSize;
+            grow_table(_size + 1);
+            _size++;
+            Chunk *&chunk = table()[k];
+            // Room the reserved elements will take in this chunk
+            size_t reserved = _reserved > k * ChunkSize ? _reserved - k * ChunkSize : 0;
+            if (offset == 0) {
+                chunk = allocate(std::min(ChunkSize, std::max(MIN_CAPACITY, reserved)));
+            } else if (offset == chunk->capacity) {
+                own(chunk, offset, std::min(ChunkSize, std::max<size_t>(2 * offset, reserved)));
+            } else {
+                own(chunk, offset, chunk->capacity);
+            }
+            chunk->items()[offset] = value;
+        }
+
+        void reserve(size_t n) {
+            if (n > _reserved) {
+                grow_table(n);
+                _reserved = n;
+            }
+        }
+
+        void clear() {
+            Chunk **chunks = table();
+            for (size_t k = 0; k < num_chunks(); k++) {
+                release(chunks[k]);
+            }
+            if (extent() > ChunkSize) {
+                delete[] _table;
+            }
+            _one = nullptr;
+            _size = 0;
+            _reserved = 0;
+        }
+
+        const_iterator begin() const { return {this, 0}; }
+        const_iterator end() const { return {this, _size}; }
+
+        // Number of chunks also referenced by another vector
+        size_t shared_chunks() const {
+            const Chunk *const *chunks = table();
+            size_t count = 0;
+            for (size_t k = 0; k < num_chunks(); k++) {
+                count += chunks[k]->refs.load(std::memory_order_relaxed) > 1;
+            }
+            return count;
+        }
+
+        // Bytes used outside the vector itself, with each chunk split
+        // evenly between its owners
+        size_t memory_footprint() const {
+            size_t bytes = extent() > ChunkSize ? slots(extent()) * sizeof(Chunk *) : 0;
+            const Chunk *const *chunks = table();
+            for (size_t k = 0; k < num_chunks(); k++) {
+                bytes += (sizeof(Chunk) + chunks[k]->capacity * sizeof(T))
+                    / chunks[k]->refs.load(std::memory_order_relaxed);
+            }
+            return bytes;
+        }
+
+    private:
+        // The only chunk while extent() fits one, otherwise a table with
+        // room for slots(extent()) chunks
+        union {
+            Chunk *_one;
+            Chunk **_table;
+        };
+        uint32_t _size = 0;
+        uint32_t _reserved = 0;
+
+        size_t extent() const { return std::max(_size, _reserved); }
+        size_t num_chunks() const { return (_size + ChunkSize - 1) / ChunkSize; }
+        size_t chunk_size(size_t k) const { return std::min(ChunkSize, _size - k * ChunkSize); }
+
+        Chunk **table() { return extent() > ChunkSize ? _table : &_one; }
+        const Chunk *const *table() const { return extent() > ChunkSize ? _table : &_one; }
+
+        // Table slots for n elements, doubled as it grows
+        static size_t slots(size_t n) {
+            size_t chunks = (n + ChunkSize - 1) / ChunkSize, slots = 1;
+            while (slots < chunks) {
+                slots *= 2;
+            }
+            return slots;
+        }
+
+        // Makes room for the chunks of n elements. Called before the size
+        // or reservation grows to n.
+        void grow_table(size_t n) {
+            if (n <= extent() || n <= ChunkSize || slots(n) == slots(extent())) {
+                return;
+            }
+            Chunk **table = new Chunk *[slots(n)];
+            std::copy_n(this->table(), num_chunks(), table);
+            if (extent() > ChunkSize) {
+                delete[] _table;
+            }
+            _table = table;
+        }
+
+        static Chunk *allocate(size_t capacity) {
+            void *memory = ::operator new(sizeof(Chunk) + capacity * sizeof(T));
+            return new (memory) Chunk((uint32_t) capacity);
+        }
+
+        static void release(Chunk *chunk) {
+            if (chunk->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                chunk->~Chunk();
+                ::operator delete(chunk);
+            }
+        }
+
+        // Makes the chunk, which holds count elements, owned by this
+        // vector alone and at least capacity large
+        static void own(Chunk *&chunk, size_t count, size_t capacity) {
+            if (chunk->refs.load(std::memory_order_acquire) == 1 && chunk->capacity >= capacity) {
+                return;
+            }
+            Chunk *copy = allocate(std::max<size_t>(capacity, chunk->capacity));
+            std::memcpy(copy->items(), chunk->items(), count * sizeof(T));
+            release(chunk);
+            chunk = copy;
+        }
+};
+
+#endif // NEAT_COW_VECTOR_HPP
@@ -0,0 +1,44 @@
+// cutoff.hpp
+
+#ifndef NEAT_CUTOFF_HPP
+#define NEAT_CUTOFF_HPP
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <cstddef>
+
+using std::vector;
+
+// Fitness a genome must reach to survive truncation selection, shared
+// between a population and the threads evaluating it. An evaluation
+// whose best possible fitness is below the cutoff can stop early.
+//
+// In a generation, the cutoff is the num_survivors-th best fitness
+// reported so far. More reports can only raise it, so a genome below
+// it is below the final cutoff too.
+class SurvivalCutoff {
+    public:
+        SurvivalCutoff();
+
+        // Start a generation, without a cutoff until num_survivors
+        // genomes are reported
+        void reset(size_t num_survivors);
+        // Report the fitness of a fully evaluated genome
+        void report(float fitness);
+        // Set the cutoff directly
+        void publish(float cutoff);
+
+        // The cutoff, or FitnessNotCalculated if there is none yet. Lock
+        // free, so evaluations can check it as often as they like.
+        float value() const;
+
+    private:
+        std::atomic<float> cutoff;
+        std::mutex mutex;
+        // Min-heap of the best num_survivors reported fitness values
+        vector<float> best;
+        size_t num_survivors;
+};
+
+#endif // NEAT_CUTOFF_HPP
@@ -0,0 +1,79 @@
+// distributed.hpp
+
+#ifndef NEAT_DISTRIBUTED_HPP
+#define NEAT_DISTRIBUTED_HPP
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <functional>
+#include "NEAT/genome.hpp"
+#include "NEAT/params.hpp"
+#include "NEAT/evaluation.hpp"
+
+using std::vector, std::string;
+
+// Evaluation of one genome by a worker, from the parameters sent by the
+// master and the seed of the genome, see SeedSchedule::genome_seed
+using WorkerEvaluate = std::function<
+    EvaluationResult(const Genome &genome, const NeatParams &params, uint64_t seed)>;
+
+// Master side of evaluation over TCP. Workers connect at any time; each
+// is kept busy with up to params.pipeline_depth batches of
+// params.batch_size genomes. The batches of a worker that disconnects
+// are handed to the others.
+class DistributedEvaluator {
+    public:
+        // Listens on params.master_port, or any free port if it is 0
+        explicit DistributedEvaluator(const NeatParams &params);
+        ~DistributedEvaluator();
+        DistributedEvaluator(const DistributedEvaluator &) = delete;
+        DistributedEvaluator &operator=(const DistributedEvaluator &) = delete;
+
+        // Fitness function for Population::run. Blocks until every genome
+        // is evaluated, waiting for a worker to connect if there is none.
+        void operator()(vector<Genome>::iterator begin, vector<Genome>::iterator end);
+
+        // Play the episodes of the given generation next, e.g. to resume
+        // a run
+        void seek(uint64_t generation) { seeds.seek(generation); }
+
+        int port() const;
+        size_t num_workers() const;
+        // Results of the last evaluation, in the order of its genomes
+        const vector<EvaluationResult> &results() const;
+
+    private:
+        struct Batch {
+            size_t begin;
+            size_t end;
+            bool done;
+        };
+
+        struct Worker {
+            int socket;
+            // Received bytes not yet parsed into frames
+            vector<uint8_t> input;
+            // Batches sent and not yet answered
+            std::deque<size_t> in_flight;
+        };
+
+        NeatParams params;
+        SeedSchedule seeds;
+        int listen_socket;
+        int _port;
+        uint64_t next_batch_id;
+        vector<Worker> workers;
+        vector<EvaluationResult> _results;
+
+        void accept_worker();
+        void drop_worker(size_t index, std::deque<size_t> &pending);
+        bool receive(Worker &worker, vector<Genome>::iterator begin,
+            vector<Batch> &batches, uint64_t first_batch_id, size_t &remaining);
+};
+
+// Connect to a master and evaluate its batches until it shuts down.
+// Returns 0 on shutdown by the master, 1 if the connection fails.
+int run_worker(const string &host, int port, const WorkerEvaluate &evaluate);
+
+#endif // NEAT_DISTRIBUTED_HPP
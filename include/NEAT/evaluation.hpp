@@ -0,0 +1,57 @@
+// evaluation.hpp
+
+#ifndef NEAT_EVALUATION_HPP
+#define NEAT_EVALUATION_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "rng.hpp"
+#include "NEAT/params.hpp"
+
+using std::vector;
+
+// Outcome of the evaluation of one genome, averaged over its episodes.
+// An aborted evaluation counts what it did not play as zero, so its
+// fitness is what it measured so far, and keeps the best fitness it
+// could still have reached in upper_bound.
+struct EvaluationResult {
+    float fitness;
+    float mean_score;
+    float mean_steps;
+    bool aborted = false;
+    float upper_bound = 0.0f;
+};
+
+// Seeds of the episodes played in each generation. With common_seeds,
+// every genome of a generation plays the same episodes, so they are
+// compared on the same start positions and food sequences. With
+// rotate_seeds, each generation gets new episodes; otherwise every
+// generation replays those of the first. The seed of a generation only
+// depends on its number, so a resumed run plays the same episodes.
+class SeedSchedule {
+    public:
+        explicit SeedSchedule(const NeatParams &params);
+
+        // Seed of the next generation
+        uint64_t next();
+        // Make the given generation the next, e.g. to resume a run
+        void seek(uint64_t generation);
+
+        // Seed of the episodes of a genome, from the seed of its generation
+        static uint64_t genome_seed(uint64_t generation_seed, size_t genome,
+            const NeatParams &params);
+        // Seed of an episode, from the seed of its genome
+        static uint64_t episode_seed(uint64_t genome_seed, int episode);
+
+    private:
+        uint64_t seed;
+        bool rotate;
+        uint64_t generation;
+};
+
+// Spearman correlation between two evaluations of the same genomes, to
+// measure how stable the ranking is under evaluation noise
+double rank_correlation(const vector<float> &a, const vector<float> &b);
+
+#endif // NEAT_EVALUATION_HPP
@@ -4,11 +4,16 @@
 #define NEAT_GENES_HPP
 
 #include <vector>
+#include <cstdint>
+#include <limits>
 #include "NEAT/config.hpp"
+#include "rng.hpp"
 
 using std::vector;
 
-enum class Activation {
+struct NeatParams;
+
+enum class Activation : uint8_t {
     LINEAR,
     SIGMOID,
     TANH,
@@ -16,11 +21,33 @@ enum class Activation {
     SOFTMAX
 };
 
+// Neuron ids are 16 bits, which keeps both gene types to 8 bytes.
+// Inputs take the negative ids, outputs and hidden neurons count up from 0.
+using NeuronId = int16_t;
+constexpr int MaxNeuronId = std::numeric_limits<NeuronId>::max();
+
+// Id given to removed genes. They stay in place as tombstones
+// until the genome is rebuilt by crossover.
+constexpr int TombstoneId = std::numeric_limits<NeuronId>::min();
+
+// Whether an id read from a file fits a gene, tombstones included
+inline bool fits_neuron_id(int64_t neuron_id) {
+    return neuron_id >= TombstoneId && neuron_id <= MaxNeuronId;
+}
+
 // Neuron gene, struct is easier to work with than class
 struct NeuronGene {
-    int neuron_id;
-    double bias;
+    NeuronId neuron_id;
     Activation activation;
+    float bias;
+
+    NeuronGene() = default;
+    NeuronGene(int neuron_id, float bias, Activation activation) :
+        neuron_id((NeuronId) neuron_id), activation(activation), bias(bias) {}
+
+    bool is_removed() const {
+        return neuron_id == TombstoneId;
+    }
 
     void print() const {
         string act;
@@ -47,8 +74,12 @@ struct NeuronGene {
 
 // LinkId gene
 struct LinkId {
-    int input_id;
-    int output_id;
+    NeuronId input_id;
+    NeuronId output_id;
+
+    LinkId() = default;
+    LinkId(int input_id, int output_id) :
+        input_id((NeuronId) input_id), output_id((NeuronId) output_id) {}
 
     bool operator==(const LinkId &rhs) const {
         return input_id == rhs.input_id && output_id == rhs.output_id;
@@ -56,32 +87,41 @@ struct LinkId {
     
 };
 
-// Link gene
+// Link gene. The enabled flag is kept by the genome, packed in a bitset
 struct LinkGene {
     LinkId link_id;
-    double weight;
-    bool is_enabled;
+    float weight;
+
+    bool has_neuron(int neuron_id) const {
+        return link_id.input_id == neuron_id || link_id.output_id == neuron_id;
+    }
 
-    bool has_neuron(vector<NeuronGene>::iterator it) const {
-        return link_id.input_id == it->neuron_id || link_id.output_id == it->neuron_id;
+    bool is_removed() const {
+        return link_id.input_id == TombstoneId;
     }
 
     void print() const {
-        std::cout << "Weight: " << weight << " Enabled: ";
-        std::cout << std::boolalpha << is_enabled;
+        std::cout << "Weight: " << weight;
     }
 };
 
-// Neuron indexer and mutator
+static_assert(sizeof(NeuronGene) == 8 && sizeof(LinkGene) == 8,
+    "Genes must stay packed");
+
+// Number of uniform samples used by one gene mutation. The mutators take
+// them, with one standard normal sample, already drawn in bulk.
+constexpr int MutationUniforms = 3;
+
+// Neuron generator and mutator
 class NeuronMutator {
     public:
-        NeuronMutator(Config &config);
-        NeuronGene new_neuron();
-        int next();
-        void mutate(NeuronGene &neuron, int num_outputs);
+        NeuronMutator(const NeatParams &params);
+        NeuronGene new_neuron(int neuron_id, RNG &rng) const;
+        NeuronGene new_neuron(int neuron_id, float normal) const;
+        void mutate(NeuronGene &neuron, int num_outputs,
+            const float *uniforms, float normal) const;
     private:
         // For generating new neurons
-        int index;
         Activation activation;
         double mean;
         double std;
@@ -94,15 +134,16 @@ class NeuronMutator {
         double replace_rate;
 };
 
-// Link indexer and mutator
+// Link generator and mutator
 class LinkMutator {
     public:
-        LinkMutator(Config &config);
-        LinkGene new_link(int input_id, int output_id);
-        void mutate(LinkGene &link);
+        LinkMutator(const NeatParams &params);
+        LinkGene new_link(int input_id, int output_id, RNG &rng) const;
+        LinkGene new_link(int input_id, int output_id, float normal) const;
+        void mutate(LinkGene &link, bool &is_enabled,
+            const float *uniforms, float normal) const;
     private:
         // For generating new links
-        int index;
         double mean;
         double std;
         double min;
@@ -114,10 +155,19 @@ class LinkMutator {
         double replace_rate;
 };
 
-double new_value(double mean, double std);
+// Resolution at which weights and biases are quantised for hashing
+constexpr float HashResolution = 1.0f / 1024.0f;
+
+// Hashes of single genes. Genome hashes are their sums, so they do not
+// depend on gene order and can be updated one gene at a time.
+uint64_t structure_hash(const NeuronGene &neuron);
+uint64_t full_hash(const NeuronGene &neuron);
+uint64_t structure_hash(const LinkGene &link, bool is_enabled);
+uint64_t full_hash(const LinkGene &link, bool is_enabled);
+
 double clamp(double value, double min, double max);
 
-NeuronGene crossover_neuron(const NeuronGene &n1, const NeuronGene &n2);
-LinkGene crossover_link(const LinkGene &l1, const LinkGene &l2);
+NeuronGene crossover_neuron(const NeuronGene &n1, const NeuronGene &n2, RNG &rng);
+LinkGene crossover_link(const LinkGene &l1, const LinkGene &l2, RNG &rng);
 
 #endif // NEAT_GENES_HPP
\ No newline at end of file
@@ -5,73 +5,138 @@
 
 #include <vector>
 #include <optional>
+#include <memory>
+#include <atomic>
 #include "NEAT/genes.hpp"
-#include "NEAT/config.hpp"
+#include "NEAT/bitset.hpp"
+#include "NEAT/cow_vector.hpp"
+#include "NEAT/params.hpp"
 #include <limits>
 
 #define FitnessNotCalculated std::numeric_limits<float>::lowest()
 
-using std::vector, std::optional, std::cout, std::endl;
+using std::vector, std::optional, std::cout, std::endl, std::shared_ptr;
+
+// Gene storage, shared chunk by chunk between a genome and its copies
+using NeuronGenes = CowVector<NeuronGene>;
+using LinkGenes = CowVector<LinkGene>;
+
+// Genome settings taken from the parameters. A single instance is
+// shared by reference between all genomes built from the same parameters.
+struct GenomeConfig {
+    int num_inputs;
+    int num_outputs;
+    int num_hidden;
+    NeuronMutator neuron_mutator;
+    LinkMutator link_mutator;
+
+    // Structural mutation rates
+    double neuron_add_prob;
+    double neuron_delete_prob;
+    double link_add_prob;
+    double link_delete_prob;
+
+    GenomeConfig(const NeatParams &params);
+};
 
 class Genome {
     public:
         int genome_id;
+        // Parents by crossover: the fitter one, which the genes were
+        // copied from, and the other one. -1 for genomes built from scratch.
+        int parent_id;
+        int mate_id;
 
-        Genome(int genome_id, Config &config);
-        void config_new(Config &config);
+        Genome(int genome_id, const NeatParams &params);
+        Genome(int genome_id, shared_ptr<const GenomeConfig> genome_config);
+        void config_new(RNG &rng);
 
         // Getters
         int num_inputs() const;
         int num_outputs() const;
         int &num_hidden();
+        int num_hidden() const;
         float &fitness();
         float fitness() const;
-        vector<NeuronGene>& neurons();
-        const vector<NeuronGene>& neurons() const;
-        vector<LinkGene>& links();
-        const vector<LinkGene>& links() const;
+        // Id of the next neuron added by mutation. Neuron ids are never
+        // reused, even after the neuron is removed.
+        int &next_neuron_id();
+        int next_neuron_id() const;
+        const NeuronGenes& neurons() const;
+        const LinkGenes& links() const;
+        const shared_ptr<const GenomeConfig>& genome_config() const;
+
+        // Canonical hashes, kept up to date as genes change. The
+        // structure hash covers neuron ids, activations, link endpoints
+        // and enabled flags; the full hash adds quantised weights and biases.
+        uint64_t structure_hash() const;
+        uint64_t full_hash() const;
+        void rehash();
+        // Whether both genomes have exactly the same genes and enabled
+        // flags, in any order. Hashes quantise weights and biases, so a
+        // hash match is only a candidate until checked with this.
+        bool same_genes(const Genome &other) const;
+
+        bool is_enabled(size_t link_index) const;
+        void set_enabled(size_t link_index, bool is_enabled);
 
         void add_neuron(const NeuronGene &neuron);
         optional<NeuronGene> find_neuron(int neuron_id) const;
-        void add_link(const LinkGene &link);
+        void set_neuron(size_t neuron_index, const NeuronGene &neuron);
+        void remove_neuron(size_t neuron_index);
+        void add_link(const LinkGene &link, bool is_enabled = true);
         optional<LinkGene> find_link(const LinkId &link_id) const;
+        optional<size_t> find_link_index(const LinkId &link_id) const;
+        void set_link(size_t link_index, const LinkGene &link);
+        void remove_link(size_t link_index);
+        void compact();
 
-        void mutate(Config &config);
-        void mutate_add_neuron();
-        void mutate_remove_neuron();
-        void mutate_add_link();
-        void mutate_remove_link();
+        void mutate(RNG &rng);
+        void mutate_add_neuron(RNG &rng);
+        void mutate_remove_neuron(RNG &rng);
+        void mutate_add_link(RNG &rng);
+        void mutate_remove_link(RNG &rng);
 
         void print() const;
+        size_t memory_footprint() const;
         
 
     private:
-        int _num_inputs;
-        int _num_outputs;
         int _num_hidden;
-        NeuronMutator neuron_mutator;
-        LinkMutator link_mutator;
-        vector<NeuronGene> _neurons;
-        vector<LinkGene> _links;
+        int _next_neuron_id;
         float _fitness;
+        shared_ptr<const GenomeConfig> _genome_config;
+        NeuronGenes _neurons;
+        LinkGenes _links;
+        // One enabled flag per link in _links
+        BitSet _enabled;
+        uint64_t _structure_hash;
+        uint64_t _full_hash;
+
+        void update_hashes(const NeuronGene &neuron, bool add);
+        void update_hashes(const LinkGene &link, bool is_enabled, bool add);
 };
 
+// Hands out genome ids, safe to share between threads
 class GenomeIndexer {
     public:
-        GenomeIndexer();
+        GenomeIndexer(int first = 0);
 
         int next();
+        // The id next() would hand out, without taking it
+        int peek() const;
 
     private:
-        int index;
+        std::atomic<int> index;
 };
 
-Genome crossover(const Genome &g1, const Genome &g2, Config &config, GenomeIndexer &indexer);
+Genome crossover(const Genome &g1, const Genome &g2, GenomeIndexer &indexer, RNG &rng);
 
-int choose_random_input_or_hidden(const vector<NeuronGene> &neurons, int num_outputs);
-int choose_random_output_or_hidden(const vector<NeuronGene> &neurons);
-vector<NeuronGene>::iterator choose_random_hidden(vector<NeuronGene> &neurons, const int num_outputs);
+int choose_random_input_or_hidden(const NeuronGenes &neurons, int num_outputs, RNG &rng);
+int choose_random_output_or_hidden(const NeuronGenes &neurons, RNG &rng);
+size_t choose_random_hidden(const NeuronGenes &neurons, const int num_outputs, RNG &rng);
+optional<size_t> choose_random_link(const LinkGenes &links, RNG &rng);
 
-bool is_cyclic(const vector<LinkGene> &links, int input_id, int output_id);
+bool is_cyclic(const LinkGenes &links, int input_id, int output_id);
 
 #endif // GENOME_HPP
\ No newline at end of file
@@ -0,0 +1,101 @@
+// history.hpp
+
+#ifndef NEAT_HISTORY_HPP
+#define NEAT_HISTORY_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "NEAT/genome.hpp"
+
+using std::vector, std::string;
+
+// Append-only archive of every generation of a run, for looking back at
+// lineages long after they died out. Each genome is stored against its
+// parents in the previous generation, see Genome::parent_id: which of the
+// parent's genes it kept, which of those it took from the mate, the
+// changes to the others' weights and biases, and its new genes. Every
+// keyframe_interval generations, and for the first generation written by
+// each HistoryWriter, a keyframe stores every genome whole. Everything
+// is coded with a RangeEncoder, starting afresh for each generation.
+//
+// Layout: header (32): magic "NEATHIST", version (4), byte order mark
+// (4), inputs (4), outputs (4), keyframe interval (4), reserved (4);
+// then per generation a block header (32): magic "NHGB" (4), genome
+// count (4), generation (8), keyframe flag (1), padding (7), coded size
+// (8); followed by the coded genomes.
+//
+// Removed genes are left out, so rebuilt genomes are compacted versions
+// of the ones written, with the same genes and hashes.
+constexpr uint32_t HistoryVersion = 1;
+
+class HistoryWriter {
+    public:
+        // Appends to the history at path, or creates it. A generation
+        // left unfinished by a crash is cut off. Throws std::runtime_error
+        // if the file cannot be written, std::invalid_argument if it is
+        // not a history of genomes with the inputs and outputs of the config.
+        HistoryWriter(const string &path, const GenomeConfig &genome_config,
+            uint32_t keyframe_interval = 100);
+
+        // Throws std::runtime_error if the generation cannot be written
+        void append(uint64_t generation, const vector<Genome> &genomes);
+
+        size_t num_generations() const { return _num_generations; }
+        uint64_t bytes_written() const { return _bytes_written; }
+
+    private:
+        string path;
+        std::ofstream file;
+        uint32_t keyframe_interval;
+        size_t _num_generations;
+        uint64_t _bytes_written;
+        // The last generation appended, as the reader rebuilds it, which
+        // the next one is coded against
+        vector<Genome> previous;
+        vector<uint8_t> buffer;
+};
+
+// Random access to the generations of a history. Opening it only reads
+// the block headers; rebuilding a generation decodes from the keyframe
+// before it, so it takes time proportional to the keyframe interval.
+class HistoryReader {
+    public:
+        struct Block {
+            uint64_t generation;
+            uint32_t num_genomes;
+            bool keyframe;
+            uint64_t offset;
+            uint64_t size;
+        };
+
+        // Throws std::runtime_error if the file cannot be read,
+        // std::invalid_argument if it is not a history of this version.
+        // An unfinished last generation is ignored.
+        explicit HistoryReader(const string &path);
+
+        size_t num_generations() const { return blocks.size(); }
+        const Block &block(size_t index) const { return blocks[index]; }
+        uint32_t keyframe_interval() const { return _keyframe_interval; }
+        int num_inputs() const { return _num_inputs; }
+        int num_outputs() const { return _num_outputs; }
+        // Bytes up to the end of the last whole generation
+        uint64_t end() const;
+
+        // The genomes of the index-th generation written, in the order
+        // they were written. Throws std::invalid_argument if the history
+        // is malformed, or the config has other inputs or outputs.
+        vector<Genome> generation(size_t index,
+            const shared_ptr<const GenomeConfig> &genome_config);
+
+    private:
+        string path;
+        std::ifstream file;
+        int _num_inputs;
+        int _num_outputs;
+        uint32_t _keyframe_interval;
+        vector<Block> blocks;
+};
+
+#endif // NEAT_HISTORY_HPP
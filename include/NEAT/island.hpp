@@ -0,0 +1,94 @@
+// island.hpp
+
+#ifndef NEAT_ISLAND_HPP
+#define NEAT_ISLAND_HPP
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include "NEAT/params.hpp"
+#include "NEAT/population.hpp"
+
+using std::vector;
+
+// Single-producer single-consumer rings of fixed size slots, in memory
+// shared with every process forked after they are created. Messages are
+// byte strings up to slot_size() bytes long.
+class SharedRings {
+    public:
+        SharedRings(size_t num_rings, size_t num_slots, size_t slot_size);
+        ~SharedRings();
+        SharedRings(const SharedRings &) = delete;
+        SharedRings &operator=(const SharedRings &) = delete;
+
+        // False if the ring is full or the message is too long
+        bool push(size_t ring, const vector<uint8_t> &message);
+        // False if the ring is empty
+        bool pop(size_t ring, vector<uint8_t> &message);
+
+        size_t slot_size() const;
+
+    private:
+        // Producer and consumer positions, on their own cache lines
+        struct alignas(64) Position {
+            std::atomic<uint64_t> value;
+        };
+        struct Ring {
+            Position head;
+            Position tail;
+        };
+        static_assert(std::atomic<uint64_t>::is_always_lock_free,
+            "Shared rings need lock-free 64-bit atomics");
+
+        uint8_t *_memory;
+        size_t _bytes;
+        size_t _num_rings;
+        size_t _num_slots;
+        size_t _slot_size;
+
+        Ring &ring(size_t index);
+        uint8_t *slot(size_t index, uint64_t position);
+};
+
+vector<int> migration_targets(MigrationTopology topology, int island, int num_islands);
+vector<int> migration_sources(MigrationTopology topology, int island, int num_islands);
+
+// Send the best genomes of an island to its targets, and add the ones
+// that have arrived from its sources
+void migrate(Population &population, int island, SharedRings &rings,
+    const NeatParams &params);
+
+// Fork one process per island, run run_island in each, and return the
+// best of the genomes they return. Islands that fail are reported and
+// skipped; throws std::runtime_error if none succeeds.
+Genome run_island_processes(const NeatParams &params,
+    const std::function<Genome(int island, SharedRings &rings)> &run_island);
+
+/**
+ * Evolve params.num_islands populations in separate processes, with the
+ * best genomes of each migrating every params.migration_interval
+ * generations.
+ *
+ * @param params The parameters of the run.
+ * @param compute_fitness The fitness function, as for Population::run.
+ * @return The best genome of all islands.
+ */
+template <typename FitnessFunction>
+Genome run_islands(const NeatParams &params, FitnessFunction &&compute_fitness) {
+    return run_island_processes(params, [&](int island, SharedRings &rings) {
+        RNG rng = RNG::stream(params.seed, island);
+        Population population(params, rng);
+        for (int generation = 1; generation <= params.max_generations; generation++) {
+            population.evaluate(compute_fitness);
+            if (generation % params.migration_interval == 0) {
+                migrate(population, island, rings, params);
+            }
+            population.next_generation();
+        }
+        return population.best_genome();
+    });
+}
+
+#endif // NEAT_ISLAND_HPP
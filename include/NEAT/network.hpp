@@ -0,0 +1,46 @@
+// network.hpp
+
+#ifndef NEAT_NETWORK_HPP
+#define NEAT_NETWORK_HPP
+
+#include <vector>
+#include "NEAT/genome.hpp"
+
+using std::vector;
+
+// Feed-forward network built from a genome. Neurons are stored in
+// evaluation order with their incoming links next to each other, so
+// activating the network is a linear pass that does not allocate.
+class FeedForwardNetwork {
+    public:
+        explicit FeedForwardNetwork(const Genome &genome);
+
+        // Reads num_inputs() inputs and writes num_outputs() outputs
+        void activate(const float *inputs, float *outputs);
+
+        int num_inputs() const;
+        int num_outputs() const;
+
+    private:
+        struct Node {
+            int value_index;
+            int first_link;
+            int num_links;
+            float bias;
+            Activation activation;
+        };
+
+        int _num_inputs;
+        int _num_outputs;
+        // Inputs first, then the other neurons in evaluation order
+        vector<float> values;
+        vector<Node> nodes;
+        // Incoming links of each node, grouped by node
+        vector<int> link_sources;
+        vector<float> link_weights;
+        // Value index of each output neuron, -1 if it is missing
+        vector<int> output_indices;
+        vector<bool> softmax_outputs;
+};
+
+#endif // NEAT_NETWORK_HPP
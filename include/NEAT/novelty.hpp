@@ -0,0 +1,69 @@
+// novelty.hpp
+
+#ifndef NEAT_NOVELTY_HPP
+#define NEAT_NOVELTY_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+using std::vector;
+
+// Vantage-point tree over points of a fixed dimension, stored one after
+// the other in a flat array, for k nearest neighbour queries under the
+// Euclidean distance. Building takes O(n log n); a query visits
+// O(log n) nodes when the points are well spread.
+class VPTree {
+    public:
+        // The points must outlive the tree and stay unchanged
+        VPTree(const float *points, size_t num_points, size_t dim);
+
+        /**
+         * Distances to the k nearest points, nearest first.
+         *
+         * @param query The point to search around.
+         * @param k The number of neighbours.
+         * @param skip A point left out of the search, e.g. the query itself.
+         * @return At most k distances.
+         */
+        vector<float> nearest(const float *query, size_t k, size_t skip = SIZE_MAX) const;
+
+    private:
+        struct Node {
+            uint32_t point;
+            // Points closer to the vantage point than this go inside
+            float radius;
+            int32_t inside;
+            int32_t outside;
+        };
+
+        const float *points;
+        size_t dim;
+        vector<Node> nodes;
+
+        float distance(const float *a, size_t point) const;
+        int32_t build(vector<uint32_t> &indices, size_t begin, size_t end);
+};
+
+// Archive of the behaviours of past genomes. The novelty of a behaviour
+// is its mean distance to the k nearest behaviours among the archive and
+// the other genomes of its generation.
+class NoveltyArchive {
+    public:
+        NoveltyArchive(size_t dim, size_t k);
+
+        // Novelty of each of the behaviours of a generation, stored one
+        // after the other
+        vector<float> novelty(const vector<float> &behaviours) const;
+        void add(const float *behaviour);
+
+        size_t size() const;
+        size_t dim() const;
+
+    private:
+        size_t _dim;
+        size_t k;
+        vector<float> archive;
+};
+
+#endif // NEAT_NOVELTY_HPP
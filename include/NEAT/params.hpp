@@ -0,0 +1,118 @@
+// params.hpp
+
+#ifndef NEAT_PARAMS_HPP
+#define NEAT_PARAMS_HPP
+
+#include <cstdint>
+#include "NEAT/config.hpp"
+#include "NEAT/genes.hpp"
+
+// Which islands send their migrants to which
+enum class MigrationTopology : uint8_t {
+    RING,
+    FULL
+};
+
+// How parents are drawn from the survivors of a generation
+enum class SelectionMethod : uint8_t {
+    UNIFORM,
+    PROPORTIONAL,
+    RANK,
+    TOURNAMENT
+};
+
+// How population mode evaluates each generation
+enum class EvaluationMethod : uint8_t {
+    LOCAL,
+    DISTRIBUTED,
+    RACING,
+    STAGED,
+    NOVELTY
+};
+
+// NEAT parameters, parsed and validated once from a Config. Every key
+// of the config file is declared in the schema in params.cpp, and the
+// members hold the defaults used when a key is missing.
+struct NeatParams {
+    // [NEAT]
+    int population_size = 150;
+    int max_generations = 100;
+    double survival_threshold = 0.2;
+    uint64_t seed = 0;
+    bool deduplicate_evaluations = false;
+    SelectionMethod selection = SelectionMethod::UNIFORM;
+    int tournament_size = 3;
+
+    // [DefaultGenome]
+    int num_inputs = 1;
+    int num_outputs = 3;
+    int num_hidden = 0;
+
+    double bias_init_mean = 0.0;
+    double bias_init_stddev = 1.0;
+    double bias_max_value = 30.0;
+    double bias_min_value = -30.0;
+    Activation activation = Activation::SIGMOID;
+
+    double weight_init_mean = 0.0;
+    double weight_init_stddev = 1.0;
+    double weight_max_value = 30.0;
+    double weight_min_value = -30.0;
+
+    double neuron_add_prob = 0.03;
+    double neuron_delete_prob = 0.01;
+    double link_add_prob = 0.05;
+    double link_delete_prob = 0.01;
+
+    double mutation_rate = 0.3;
+    double mutation_power = 0.8;
+    double replace_rate = 0.05;
+
+    // [Islands]
+    int num_islands = 4;
+    int migration_interval = 5;
+    int migration_size = 2;
+    MigrationTopology migration_topology = MigrationTopology::RING;
+
+    // [Evaluation]
+    int board_width = 20;
+    int board_height = 20;
+    bool allow_teleport = false;
+    int episodes_per_genome = 3;
+    int max_steps = 100000;
+    int hunger_steps = 400;
+    bool common_seeds = true;
+    bool rotate_seeds = true;
+    EvaluationMethod evaluation_method = EvaluationMethod::LOCAL;
+
+    // [Racing]
+    int racing_min_episodes = 2;
+    int racing_max_episodes = 16;
+    double racing_z = 1.96;
+
+    // [Staging]
+    int screening_board_width = 10;
+    int screening_board_height = 10;
+    int screening_episodes = 2;
+    int screening_max_steps = 200;
+    double screening_percentile = 0.5;
+
+    // [Novelty]
+    double novelty_weight = 1.0;
+    int novelty_k = 15;
+    int novelty_grid = 4;
+    int novelty_archive_add = 2;
+
+    // [Distributed]
+    int master_port = 5555;
+    int batch_size = 8;
+    int pipeline_depth = 2;
+
+    // Defaults only
+    NeatParams() = default;
+
+    // Throws std::invalid_argument on unknown keys and invalid values
+    explicit NeatParams(const Config &config);
+};
+
+#endif // NEAT_PARAMS_HPP
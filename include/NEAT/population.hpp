@@ -3,9 +3,31 @@
 #ifndef NEAT_POPULATION_HPP
 #define NEAT_POPULATION_HPP
 
-#include "NEAT/config.hpp"
+#include "NEAT/params.hpp"
 #include "NEAT/genome.hpp"
+#include "NEAT/cutoff.hpp"
+#include "NEAT/selection.hpp"
 #include "rng.hpp"
+#include <optional>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <utility>
+
+// Everything a run needs to carry on where it stopped, e.g. from a
+// checkpoint. Copies share the gene chunks of the genomes they copy, so
+// taking one is cheap, and the population can evolve on while it is
+// written out: genes it changes are cloned first.
+struct PopulationState {
+    uint64_t generation;
+    RNG::State rng;
+    int next_genome_id;
+    vector<Genome> genomes;
+    vector<Genome> species;
+    Genome best;
+};
 
 class Population {
     public:
@@ -22,30 +44,210 @@ class Population {
          * 7. Repeat from step 2
          * 
          */
-        Population(Config &config, RNG &rng);
+        Population(const NeatParams &params, RNG &rng);
+        // Resume a run. The genomes of the state share the config the
+        // population goes on with.
+        Population(const NeatParams &params, PopulationState state);
 
+        // The fitness function is used in place, so stateful ones keep
+        // their state from one generation to the next
         template <typename FitnessFunction>
-        void run(FitnessFunction compute_fitness, int max_generations) {
+        void run(FitnessFunction &&compute_fitness, int max_generations) {
             // In each generation, calculate the fitness of each genome and
             // reproduce the next generation
             for (int i = 0; i < max_generations; i++) {
+                evaluate(compute_fitness);
+                next_generation();
+            }
+        }
+
+        // The two halves of a generation, for callers that act in between
+        template <typename FitnessFunction>
+        void evaluate(FitnessFunction &&compute_fitness) {
+            _survival_cutoff->reset(num_survivors());
+            if (_params.deduplicate_evaluations) {
+                // Only evaluate the first genome of each duplicate cluster
+                vector<size_t> originals;
+                auto first_duplicate = move_duplicates_back(originals);
+                compute_fitness(_genomes.begin(), first_duplicate);
+                copy_fitness_to_duplicates(first_duplicate, originals);
+            } else {
                 compute_fitness(_genomes.begin(), _genomes.end());
-                update_best();
-                _genomes = reproduce();
             }
         }
+        void next_generation();
+
+        // Steady-state evolution, without generations: worker threads
+        // evaluate genomes one at a time, and each finished evaluation of
+        // an offspring replaces the worst genome of the population. No
+        // worker waits for another, whatever the spread of evaluation times.
+        template <typename Evaluate>
+        void run_steady_state(Evaluate evaluate, size_t max_evaluations,
+            unsigned num_threads = std::thread::hardware_concurrency());
+
         vector<Genome> reproduce();
+        vector<vector<size_t>> duplicate_clusters() const;
+        const vector<Genome>& genomes() const { return _genomes; }
+        const Genome& best_genome() const { return best; }
+        const shared_ptr<const GenomeConfig>& genome_config() const { return _genome_config; }
+        // Number of generations reproduced so far
+        uint64_t generation() const { return _generation; }
+        PopulationState state() const;
+        // Fitness needed to survive selection, for evaluations that stop
+        // early. Fitness functions of generational runs report to it;
+        // steady-state runs publish the cutoff of the population.
+        const shared_ptr<SurvivalCutoff>& survival_cutoff() const { return _survival_cutoff; }
+
+        // Exchange of evaluated genomes with other populations
+        vector<Genome> top_genomes(size_t n) const;
+        void immigrate(const vector<Genome> &migrants);
 
     private:
-        Config _config;
+        NeatParams _params;
         RNG _rng;
         GenomeIndexer indexer;
-        Genome best = Genome(-1, _config);
+        shared_ptr<const GenomeConfig> _genome_config;
+        shared_ptr<SurvivalCutoff> _survival_cutoff;
+        Genome best = Genome(-1, _genome_config);
         vector<Genome> _genomes;
         vector<Genome> _species;
+        uint64_t _generation = 0;
         
         void update_best();
+        void update_best(const Genome &genome);
+        // Survivors steady-state evolution draws parents from, as indices
+        // into the population, and the lowest fitness among them
+        struct ParentPool {
+            vector<size_t> indices;
+            ParentSelector selector;
+            float lowest_fitness;
+        };
+        // Evaluated genomes of steady-state evolution as (fitness, index)
+        // pairs, split into the survivors and the rest, so the worst one
+        // and the survival cutoff are found in O(log N)
+        class EvaluatedIndex {
+            public:
+                explicit EvaluatedIndex(size_t num_survivors) : num_survivors(num_survivors) {}
+                void add(float fitness, size_t index);
+                void remove(float fitness, size_t index);
+                size_t size() const { return survivors.size() + rest.size(); }
+                size_t worst() const;
+                float cutoff() const { return survivors.begin()->first; }
+
+            private:
+                size_t num_survivors;
+                std::set<std::pair<float, size_t>> survivors;
+                std::set<std::pair<float, size_t>> rest;
+        };
+        ParentPool parent_pool() const;
+        size_t worst_evaluated() const;
+        size_t num_survivors() const;
+        void publish_survival_cutoff(const EvaluatedIndex &evaluated);
+        vector<Genome>::iterator move_duplicates_back(vector<size_t> &originals);
+        void copy_fitness_to_duplicates(vector<Genome>::iterator first_duplicate,
+            const vector<size_t> &originals);
         vector<Genome> sort_by_fitness(vector<Genome> &genomes);
 };
 
+/**
+ * Run steady-state evolution for a number of evaluations.
+ * 
+ * Unevaluated genomes of the population are evaluated first. After
+ * that, each evaluation is of a new offspring of the best genomes, which
+ * then takes the place of the worst one. The population is only touched
+ * under a lock; crossover, mutation and evaluation run outside of it.
+ * 
+ * @param evaluate Function returning the fitness of a genome. It is
+ * called from several threads at once.
+ * @param max_evaluations The number of evaluations to run.
+ * @param num_threads The number of worker threads. DEFAULT one per core.
+ */
+template <typename Evaluate>
+void Population::run_steady_state(Evaluate evaluate, size_t max_evaluations,
+    unsigned num_threads) {
+    std::mutex mutex;
+    std::condition_variable parents_ready;
+    size_t started = 0;
+    size_t next_initial = 0;
+    size_t num_evaluated = 0;
+    uint64_t num_births = 0;
+    uint64_t seed = _rng.next();
+    // Kept across offspring, and rebuilt once a genome joins or leaves
+    // the survivors
+    std::optional<ParentPool> pool;
+    EvaluatedIndex evaluated(num_survivors());
+
+    for (size_t i = 0; i < _genomes.size(); i++) {
+        if (_genomes[i].fitness() != FitnessNotCalculated) {
+            evaluated.add(_genomes[i].fitness(), i);
+            num_evaluated++;
+        }
+    }
+
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (started < max_evaluations) {
+            started++;
+
+            // Genomes of the population that were never evaluated go first
+            while (next_initial < _genomes.size()
+                && _genomes[next_initial].fitness() != FitnessNotCalculated) {
+                next_initial++;
+            }
+            if (next_initial < _genomes.size()) {
+                size_t index = next_initial++;
+                Genome genome = _genomes[index];
+                lock.unlock();
+                float fitness = evaluate(genome);
+                lock.lock();
+                // Unevaluated genomes are never replaced, so index still holds it
+                _genomes[index].fitness() = fitness;
+                evaluated.add(fitness, index);
+                update_best(_genomes[index]);
+                publish_survival_cutoff(evaluated);
+                pool.reset();
+                num_evaluated++;
+                parents_ready.notify_all();
+                continue;
+            }
+
+            // Offspring need at least one evaluated parent
+            parents_ready.wait(lock, [&]() { return num_evaluated > 0; });
+            RNG rng = RNG::stream(seed, num_births++);
+            if (!pool) {
+                pool = parent_pool();
+            }
+            Genome p1 = _genomes[pool->indices[pool->selector.choose(rng)]];
+            Genome p2 = _genomes[pool->indices[pool->selector.choose(rng)]];
+            lock.unlock();
+
+            Genome offspring = crossover(p1, p2, indexer, rng);
+            offspring.mutate(rng);
+            offspring.fitness() = evaluate(offspring);
+
+            lock.lock();
+            size_t worst = evaluated.worst();
+            // Only replacements that reach the survivors change the pool
+            if (pool && (offspring.fitness() >= pool->lowest_fitness
+                || std::find(pool->indices.begin(), pool->indices.end(), worst)
+                    != pool->indices.end())) {
+                pool.reset();
+            }
+            evaluated.remove(_genomes[worst].fitness(), worst);
+            _genomes[worst] = offspring;
+            evaluated.add(offspring.fitness(), worst);
+            update_best(offspring);
+            publish_survival_cutoff(evaluated);
+        }
+    };
+
+    vector<std::thread> workers;
+    for (unsigned i = 0; i < std::max(1u, num_threads); i++) {
+        workers.emplace_back(worker);
+    }
+    for (auto &thread : workers) {
+        thread.join();
+    }
+}
+
 #endif // NEAT_POPULATION_HPP
\ No newline at end of file
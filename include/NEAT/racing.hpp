@@ -0,0 +1,134 @@
+// racing.hpp
+
+#ifndef NEAT_RACING_HPP
+#define NEAT_RACING_HPP
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "NEAT/params.hpp"
+
+using std::vector;
+
+struct RacingStats {
+    // Episodes played, and the episodes a full evaluation would play
+    size_t episodes = 0;
+    size_t full_episodes = 0;
+    int rounds = 0;
+    size_t eliminated = 0;
+};
+
+// Confidence intervals of the mean fitness of a set of genomes, and
+// the genomes still in the race. A genome is eliminated once its upper
+// bound is below the lower bound of num_survivors other genomes, as it
+// can then no longer make the survival cutoff.
+class Race {
+    public:
+        Race(size_t num_genomes, size_t num_survivors, double z);
+
+        const vector<size_t> &contenders() const;
+        void record(size_t genome, double fitness);
+        // Drop the contenders that cannot survive, returns how many
+        size_t eliminate();
+
+        double mean(size_t genome) const;
+        int episodes(size_t genome) const;
+        // Mean of each genome, with the genomes eliminated in each round
+        // capped below every genome that outlasted them, so that a
+        // noisy mean over few episodes never ranks above a survivor
+        vector<float> fitness() const;
+
+    private:
+        struct Samples {
+            double sum = 0.0;
+            double sum_squares = 0.0;
+            int count = 0;
+        };
+
+        vector<Samples> samples;
+        vector<size_t> _contenders;
+        // Round each genome was eliminated in, 0 for contenders
+        vector<int> eliminated_in;
+        int rounds = 0;
+        size_t num_survivors;
+        double z;
+
+        double half_width(size_t genome) const;
+};
+
+/**
+ * Evaluate genomes by racing. All contenders play
+ * params.racing_min_episodes episodes in the first round; each later
+ * round doubles the episodes of the remaining contenders, up to
+ * params.racing_max_episodes. Episode e of every genome is played with
+ * the same seed, so genomes are compared on the same episodes.
+ *
+ * @param num_genomes The number of genomes.
+ * @param play Plays episode e of genome g, play(g, e), and returns its
+ * fitness. With several threads, it is called for different genomes at
+ * once, but never twice at once for the same genome.
+ * @param params The parameters of the run.
+ * @param stats If not null, set to the statistics of the race.
+ * @param num_threads The threads playing the episodes of each round.
+ * @return The mean fitness of each genome over the episodes it played,
+ * as Race::fitness() orders it.
+ */
+template <typename PlayEpisode>
+vector<float> race(size_t num_genomes, PlayEpisode &&play,
+    const NeatParams &params, RacingStats *stats = nullptr, unsigned num_threads = 1) {
+    size_t num_survivors = std::ceil(params.survival_threshold * num_genomes);
+    Race race(num_genomes, num_survivors, params.racing_z);
+    RacingStats round_stats;
+    round_stats.full_episodes = num_genomes * (size_t) params.racing_max_episodes;
+
+    int played = 0;
+    int round_episodes = std::min(params.racing_min_episodes, params.racing_max_episodes);
+    vector<double> round_fitness;
+    while (round_episodes > 0) {
+        // Contenders are shared between the threads, then recorded in
+        // order, so the race does not depend on the number of threads
+        const vector<size_t> &contenders = race.contenders();
+        round_fitness.assign(contenders.size() * round_episodes, 0.0);
+        std::atomic<size_t> next_contender{0};
+        auto work = [&]() {
+            for (size_t c = next_contender++; c < contenders.size(); c = next_contender++) {
+                for (int e = 0; e < round_episodes; e++) {
+                    round_fitness[c * round_episodes + e] = play(contenders[c], played + e);
+                }
+            }
+        };
+        vector<std::thread> threads;
+        for (unsigned i = 1; i < std::min<size_t>(num_threads, contenders.size()); i++) {
+            threads.emplace_back(work);
+        }
+        work();
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        for (size_t c = 0; c < contenders.size(); c++) {
+            for (int e = 0; e < round_episodes; e++) {
+                race.record(contenders[c], round_fitness[c * round_episodes + e]);
+            }
+        }
+        round_stats.episodes += race.contenders().size() * round_episodes;
+        round_stats.rounds++;
+        played += round_episodes;
+
+        // Truncation selection does not rank the survivors among themselves
+        if (race.contenders().size() <= num_survivors) {
+            break;
+        }
+        round_stats.eliminated += race.eliminate();
+        round_episodes = std::min(played, params.racing_max_episodes - played);
+    }
+
+    if (stats != nullptr) {
+        *stats = round_stats;
+    }
+    return race.fitness();
+}
+
+#endif // NEAT_RACING_HPP
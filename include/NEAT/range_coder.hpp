@@ -0,0 +1,212 @@
+// range_coder.hpp
+
+#ifndef NEAT_RANGE_CODER_HPP
+#define NEAT_RANGE_CODER_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+using std::vector;
+
+// Adaptive binary range coder, as in LZMA. Every bit is coded with the
+// probability of its context, learnt from the bits coded before in that
+// context, so fields that rarely change, e.g. weights that were not
+// mutated, cost a fraction of a bit. Bytes are coded bit by bit down a
+// tree of contexts, numbers as bytes.
+//
+// The encoder and the decoder must go through the same contexts in the
+// same order. NumContexts is the number of byte contexts; each also has
+// a context for single bits.
+template <size_t NumContexts>
+class RangeModel {
+    public:
+        RangeModel() {
+            for (auto &probs : byte_probs) {
+                probs.fill(HALF);
+            }
+            bit_probs.fill(HALF);
+        }
+
+    protected:
+        // Probabilities of a zero bit, out of 2^PROB_BITS
+        static constexpr int PROB_BITS = 11;
+        static constexpr uint16_t HALF = 1 << (PROB_BITS - 1);
+        // How fast probabilities adapt, higher is slower
+        static constexpr int ADAPT_SHIFT = 5;
+        static constexpr uint32_t TOP = 1u << 24;
+
+        std::array<std::array<uint16_t, 256>, NumContexts> byte_probs;
+        std::array<uint16_t, NumContexts> bit_probs;
+
+        static void adapt(uint16_t &prob, bool bit) {
+            if (bit) {
+                prob -= prob >> ADAPT_SHIFT;
+            } else {
+                prob += ((1 << PROB_BITS) - prob) >> ADAPT_SHIFT;
+            }
+        }
+};
+
+template <size_t NumContexts>
+class RangeEncoder : public RangeModel<NumContexts> {
+    using Model = RangeModel<NumContexts>;
+
+    public:
+        explicit RangeEncoder(vector<uint8_t> &out) : out(out) {}
+
+        void put_bit(size_t context, bool bit) {
+            encode(this->bit_probs[context], bit);
+        }
+
+        void put_byte(size_t context, uint8_t byte) {
+            auto &probs = this->byte_probs[context];
+            size_t node = 1;
+            for (int i = 7; i >= 0; i--) {
+                bool bit = (byte >> i) & 1;
+                encode(probs[node], bit);
+                node = (node << 1) | bit;
+            }
+        }
+
+        // LEB128, so small numbers take one byte
+        void put_varint(size_t context, uint64_t value) {
+            while (value >= 0x80) {
+                put_byte(context, (uint8_t) (value | 0x80));
+                value >>= 7;
+            }
+            put_byte(context, (uint8_t) value);
+        }
+
+        // Little endian, each byte in its own context from first_context
+        void put_u32(size_t first_context, uint32_t value) {
+            for (size_t i = 0; i < 4; i++) {
+                put_byte(first_context + i, (uint8_t) (value >> (8 * i)));
+            }
+        }
+
+        // Write out what is left, after the last symbol
+        void finish() {
+            for (int i = 0; i < 5; i++) {
+                shift_low();
+            }
+        }
+
+    private:
+        vector<uint8_t> &out;
+        uint64_t low = 0;
+        uint32_t range = 0xFFFFFFFF;
+        uint8_t cache = 0;
+        uint64_t cache_size = 1;
+
+        void encode(uint16_t &prob, bool bit) {
+            uint32_t bound = (range >> Model::PROB_BITS) * prob;
+            if (bit) {
+                low += bound;
+                range -= bound;
+            } else {
+                range = bound;
+            }
+            Model::adapt(prob, bit);
+            while (range < Model::TOP) {
+                range <<= 8;
+                shift_low();
+            }
+        }
+
+        // Output the top byte of low, once no carry can change it
+        void shift_low() {
+            if ((uint32_t) low < 0xFF000000u || (low >> 32) != 0) {
+                uint8_t carry = low >> 32;
+                uint8_t pending = cache;
+                do {
+                    out.push_back(pending + carry);
+                    pending = 0xFF;
+                } while (--cache_size != 0);
+                cache = (low >> 24) & 0xFF;
+            }
+            cache_size++;
+            low = (low & 0x00FFFFFF) << 8;
+        }
+};
+
+template <size_t NumContexts>
+class RangeDecoder : public RangeModel<NumContexts> {
+    using Model = RangeModel<NumContexts>;
+
+    public:
+        // Throws std::invalid_argument if the data ends before the symbols
+        RangeDecoder(const uint8_t *data, size_t size) : data(data), size(size) {
+            for (int i = 0; i < 5; i++) {
+                code = (code << 8) | next_byte();
+            }
+        }
+
+        bool get_bit(size_t context) {
+            return decode(this->bit_probs[context]);
+        }
+
+        uint8_t get_byte(size_t context) {
+            auto &probs = this->byte_probs[context];
+            size_t node = 1;
+            while (node < 256) {
+                node = (node << 1) | decode(probs[node]);
+            }
+            return node & 0xFF;
+        }
+
+        uint64_t get_varint(size_t context) {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                uint8_t byte = get_byte(context);
+                value |= (uint64_t) (byte & 0x7F) << shift;
+                if (!(byte & 0x80)) {
+                    return value;
+                }
+            }
+            throw std::invalid_argument("Malformed number in coded data");
+        }
+
+        uint32_t get_u32(size_t first_context) {
+            uint32_t value = 0;
+            for (size_t i = 0; i < 4; i++) {
+                value |= (uint32_t) get_byte(first_context + i) << (8 * i);
+            }
+            return value;
+        }
+
+    private:
+        const uint8_t *data;
+        size_t size;
+        size_t at = 0;
+        uint32_t code = 0;
+        uint32_t range = 0xFFFFFFFF;
+
+        uint8_t next_byte() {
+            if (at >= size) {
+                throw std::invalid_argument("Truncated coded data");
+            }
+            return data[at++];
+        }
+
+        bool decode(uint16_t &prob) {
+            uint32_t bound = (range >> Model::PROB_BITS) * prob;
+            bool bit = code >= bound;
+            if (bit) {
+                code -= bound;
+                range -= bound;
+            } else {
+                range = bound;
+            }
+            Model::adapt(prob, bit);
+            while (range < Model::TOP) {
+                range <<= 8;
+                code = (code << 8) | next_byte();
+            }
+            return bit;
+        }
+};
+
+#endif // NEAT_RANGE_CODER_HPP
@@ -0,0 +1,52 @@
+// selection.hpp
+
+#ifndef NEAT_SELECTION_HPP
+#define NEAT_SELECTION_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "NEAT/params.hpp"
+#include "rng.hpp"
+
+using std::vector;
+
+// Vose's alias method: after O(n) setup, draws an index with probability
+// proportional to its weight in O(1), with one random number
+class AliasTable {
+    public:
+        AliasTable() = default;
+        explicit AliasTable(const vector<double> &weights);
+
+        size_t sample(RNG &rng) const;
+        size_t size() const;
+
+    private:
+        // Chance of keeping the drawn column rather than its alias
+        vector<double> probability;
+        vector<uint32_t> alias;
+};
+
+// Draws parents from a set of candidates, e.g. the survivors of a
+// generation or of a species, with params.selection. Setup is O(n), or
+// O(n log n) for rank selection; each draw is O(1), or
+// O(tournament_size) for tournaments.
+class ParentSelector {
+    public:
+        /**
+         * @param fitness The fitness of each candidate.
+         * @param params The parameters of the run.
+         */
+        ParentSelector(const vector<float> &fitness, const NeatParams &params);
+
+        // Index of a parent among the candidates
+        size_t choose(RNG &rng) const;
+
+    private:
+        SelectionMethod method;
+        int tournament_size;
+        vector<float> fitness;
+        AliasTable table;
+};
+
+#endif // NEAT_SELECTION_HPP
@@ -0,0 +1,86 @@
+// serialize.hpp
+
+#ifndef NEAT_SERIALIZE_HPP
+#define NEAT_SERIALIZE_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include "NEAT/genome.hpp"
+
+using std::vector, std::string;
+
+// Compact binary encoding of a genome, for sending genomes to other
+// processes or machines of the same architecture. Removed genes are
+// left out, numbers are stored in host byte order.
+//
+// Layout: version (1), genome id (4), fitness (4), hidden neurons (4),
+// neuron count (4), link count (4), then per neuron its id (4), bias (4)
+// and activation (1), and per link its input (4), output (4), weight (4)
+// and enabled flag (1).
+constexpr uint8_t GenomeEncodingVersion = 1;
+
+// Appends a number to a buffer, in host byte order
+template <typename T>
+void put_value(vector<uint8_t> &out, T value) {
+    size_t at = out.size();
+    out.resize(at + sizeof(T));
+    std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+// Bounds-checked reads of numbers from a buffer
+class ByteReader {
+    public:
+        ByteReader(const uint8_t *data, size_t size) : data(data), size(size), at(0) {}
+
+        // Throws std::invalid_argument past the end of the buffer
+        template <typename T>
+        T get() {
+            if (size - at < sizeof(T)) {
+                throw std::invalid_argument("Truncated encoding");
+            }
+            T value;
+            std::memcpy(&value, data + at, sizeof(T));
+            at += sizeof(T);
+            return value;
+        }
+
+        size_t position() const { return at; }
+        size_t remaining() const { return size - at; }
+        const uint8_t *current() const { return data + at; }
+        void skip(size_t n) {
+            if (n > size - at) {
+                throw std::invalid_argument("Truncated encoding");
+            }
+            at += n;
+        }
+
+    private:
+        const uint8_t *data;
+        size_t size;
+        size_t at;
+};
+
+// Appends the encoding of the genome to out
+void encode_genome(const Genome &genome, vector<uint8_t> &out);
+
+// Size of the encoding of the genome, in bytes
+size_t encoded_size(const Genome &genome);
+
+// Decodes one genome starting at data, and returns the number of bytes
+// it used. Throws std::invalid_argument if the data is malformed.
+size_t decode_genome(const uint8_t *data, size_t size,
+    const shared_ptr<const GenomeConfig> &genome_config, Genome &genome);
+
+// Writes the encoding of the genome to a file, e.g. the champion of a
+// run to play it later. Throws std::runtime_error if it cannot be written.
+void save_genome(const string &path, const Genome &genome);
+
+// Reads a genome written by save_genome. Throws std::runtime_error if the
+// file cannot be read, std::invalid_argument if it is malformed.
+Genome load_genome(const string &path, const shared_ptr<const GenomeConfig> &genome_config);
+
+#endif // NEAT_SERIALIZE_HPP
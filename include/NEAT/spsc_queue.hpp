@@ -0,0 +1,48 @@
+// spsc_queue.hpp
+
+#ifndef NEAT_SPSC_QUEUE_HPP
+#define NEAT_SPSC_QUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free queue between one producing and one consuming
+// thread. Neither ever waits for the other: pushing to a full queue
+// fails instead. Values are copied in and out, so T should be small
+// and trivially copyable.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        // Producer only. Returns false if the queue is full.
+        bool try_push(const T &value) {
+            size_t tail = _tail.load(std::memory_order_relaxed);
+            if (tail - _head.load(std::memory_order_acquire) == Capacity) {
+                return false;
+            }
+            slots[tail & (Capacity - 1)] = value;
+            _tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer only. Returns false if the queue is empty.
+        bool try_pop(T &value) {
+            size_t head = _head.load(std::memory_order_relaxed);
+            if (head == _tail.load(std::memory_order_acquire)) {
+                return false;
+            }
+            value = slots[head & (Capacity - 1)];
+            _head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        std::array<T, Capacity> slots;
+        // On their own cache lines, so the two threads do not share one
+        alignas(64) std::atomic<size_t> _head{0};
+        alignas(64) std::atomic<size_t> _tail{0};
+};
+
+#endif // NEAT_SPSC_QUEUE_HPP
@@ -0,0 +1,122 @@
+// staging.hpp
+
+#ifndef NEAT_STAGING_HPP
+#define NEAT_STAGING_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "NEAT/params.hpp"
+
+using std::vector;
+
+// Fitness of a genome in one stage, and the steps simulated for it
+struct StageResult {
+    float fitness;
+    uint64_t steps;
+};
+
+struct StagingStats {
+    size_t screened_out = 0;
+    uint64_t screening_steps = 0;
+    uint64_t full_steps = 0;
+    // Steps the screened out genomes would have played on the full
+    // board, estimated from the genomes that passed, less the steps
+    // spent screening every genome
+    int64_t steps_saved = 0;
+};
+
+// Which genomes pass screening: those at or above the
+// params.screening_percentile percentile, and never fewer than the
+// survivors of truncation selection
+vector<bool> screening_cutoff(const vector<float> &screening, const NeatParams &params);
+
+// Fitness of the screened out genomes: their screening fitness, shifted
+// below the lowest fitness of the genomes that passed, so they rank
+// below all of those and keep their order among themselves
+void rank_screened_out(vector<float> &fitness, const vector<float> &screening,
+    const vector<bool> &passed);
+
+/**
+ * Evaluate genomes in two stages: a cheap screening of every genome,
+ * then the full evaluation of the genomes that pass.
+ *
+ * @param num_genomes The number of genomes.
+ * @param screen Screens genome g, screen(g), returning a StageResult.
+ * @param evaluate Fully evaluates genome g, evaluate(g), returning a StageResult.
+ * @param params The parameters of the run.
+ * @param stats If not null, set to the statistics of the evaluation.
+ * @param num_threads The threads screening and evaluating genomes. With
+ * several, screen and evaluate are called for different genomes at once.
+ * @return The fitness of each genome.
+ */
+template <typename Screen, typename Evaluate>
+vector<float> staged(size_t num_genomes, Screen &&screen, Evaluate &&evaluate,
+    const NeatParams &params, StagingStats *stats = nullptr, unsigned num_threads = 1) {
+    // Genomes are shared between the threads, and their results summed
+    // in order, so the evaluation does not depend on the number of threads
+    auto for_each_genome = [&](const vector<size_t> &genomes, vector<StageResult> &results,
+        auto &&stage) {
+        std::atomic<size_t> next{0};
+        auto work = [&]() {
+            for (size_t i = next++; i < genomes.size(); i = next++) {
+                results[genomes[i]] = stage(genomes[i]);
+            }
+        };
+        vector<std::thread> threads;
+        for (unsigned i = 1; i < std::min<size_t>(num_threads, genomes.size()); i++) {
+            threads.emplace_back(work);
+        }
+        work();
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    };
+
+    StagingStats stage_stats;
+    vector<size_t> everyone(num_genomes);
+    for (size_t genome = 0; genome < num_genomes; genome++) {
+        everyone[genome] = genome;
+    }
+    vector<StageResult> screening_results(num_genomes);
+    for_each_genome(everyone, screening_results, screen);
+    vector<float> screening(num_genomes);
+    for (size_t genome = 0; genome < num_genomes; genome++) {
+        screening[genome] = screening_results[genome].fitness;
+        stage_stats.screening_steps += screening_results[genome].steps;
+    }
+
+    vector<bool> passed = screening_cutoff(screening, params);
+    vector<size_t> finalists;
+    for (size_t genome = 0; genome < num_genomes; genome++) {
+        if (passed[genome]) {
+            finalists.push_back(genome);
+        } else {
+            stage_stats.screened_out++;
+        }
+    }
+    vector<StageResult> full_results(num_genomes);
+    for_each_genome(finalists, full_results, evaluate);
+    vector<float> fitness(num_genomes);
+    for (size_t genome : finalists) {
+        fitness[genome] = full_results[genome].fitness;
+        stage_stats.full_steps += full_results[genome].steps;
+    }
+    rank_screened_out(fitness, screening, passed);
+    // Nothing to estimate from if no genome passed, e.g. for no genomes
+    size_t num_passed = num_genomes - stage_stats.screened_out;
+    uint64_t full_steps_saved = num_passed > 0
+        ? stage_stats.full_steps * stage_stats.screened_out / num_passed : 0;
+    stage_stats.steps_saved = (int64_t) full_steps_saved
+        - (int64_t) stage_stats.screening_steps;
+
+    if (stats != nullptr) {
+        *stats = stage_stats;
+    }
+    return fitness;
+}
+
+#endif // NEAT_STAGING_HPP
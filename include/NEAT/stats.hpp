@@ -0,0 +1,138 @@
+// stats.hpp
+
+#ifndef NEAT_STATS_HPP
+#define NEAT_STATS_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "NEAT/genome.hpp"
+#include "NEAT/evaluation.hpp"
+#include "NEAT/spsc_queue.hpp"
+
+using std::vector, std::string;
+
+// Summary of a distribution: its quartiles, by nearest rank, and mean
+struct Distribution {
+    float min;
+    float p25;
+    float median;
+    float p75;
+    float max;
+    float mean;
+};
+
+// All zeros for no values
+Distribution describe(vector<float> values);
+
+// Metrics of one generation. It has a fixed size, so logging it does
+// not allocate.
+struct GenerationStats {
+    uint64_t generation;
+    uint64_t num_genomes;
+    uint64_t num_evaluations;
+    uint64_t num_aborted;
+    Distribution fitness;
+    // Genes per genome, removed ones left out
+    Distribution neurons;
+    Distribution links;
+    // Mean steps of the episodes of each evaluation that was not aborted
+    Distribution episode_steps;
+    double evaluations_per_second;
+    // Wall time of the phases of the generation, in seconds
+    double evaluate_seconds;
+    double reproduce_seconds;
+    double save_seconds;
+};
+
+// Metrics of an evaluated generation. The reproduce and save times are
+// left at zero, for the caller to fill in.
+GenerationStats measure_generation(uint64_t generation, const vector<Genome> &genomes,
+    const vector<EvaluationResult> &results, double evaluate_seconds);
+
+enum class ColumnType : uint8_t {
+    U64,
+    F32,
+    F64
+};
+
+// A field of GenerationStats, as a column of the outputs
+struct StatsColumn {
+    string name;
+    ColumnType type;
+    size_t offset;
+
+    double value(const GenerationStats &stats) const;
+};
+
+// Columns of the outputs, in order
+const vector<StatsColumn> &stats_columns();
+
+// Writes generation stats on a background thread, as CSV and in a
+// compact binary columnar format, so the training thread never waits on
+// the disk. Records go through a lock-free queue; if the writer falls
+// so far behind that it is full, they are dropped and counted.
+//
+// Binary layout: magic "NEATSTAT", version (4), column count (4), then
+// per column its type (1), name length (1) and name. Then row groups:
+// row count (4), followed by the values of each column in turn, 8 bytes
+// for U64 and F64 columns, 4 for F32 ones. Host byte order.
+constexpr uint32_t StatsVersion = 1;
+
+class StatsLogger {
+    public:
+        // Either path may be empty, to skip that output. Throws
+        // std::runtime_error if a file cannot be created.
+        StatsLogger(const string &csv_path, const string &binary_path);
+        // Writes what is still queued first
+        ~StatsLogger();
+        StatsLogger(const StatsLogger &) = delete;
+        StatsLogger &operator=(const StatsLogger &) = delete;
+
+        // From one thread only. Never blocks; returns false if the
+        // record was dropped.
+        bool log(const GenerationStats &stats);
+
+        // Block until every record logged so far is written
+        void flush();
+
+        size_t num_dropped() const { return _num_dropped; }
+        // False once a write failed; nothing is written after that
+        bool ok() const { return !failed; }
+
+    private:
+        static constexpr size_t QUEUE_SIZE = 256;
+
+        SpscQueue<GenerationStats, QUEUE_SIZE> queue;
+        std::ofstream csv;
+        std::ofstream binary;
+        std::atomic<bool> stopping{false};
+        std::atomic<bool> failed{false};
+        std::atomic<size_t> _num_dropped{0};
+        // Records logged, and records the writer took off the queue
+        size_t num_logged = 0;
+        std::atomic<size_t> num_taken{0};
+        std::thread thread;
+
+        void run();
+        void write(const vector<GenerationStats> &rows);
+};
+
+// Columns of a binary stats file, e.g. to plot a run
+struct StatsTable {
+    vector<string> names;
+    vector<vector<double>> columns;
+
+    // Throws std::out_of_range for an unknown name
+    const vector<double> &column(const string &name) const;
+};
+
+// Read a binary stats file. A row group cut short by a crash is left
+// out. Throws std::runtime_error if the file cannot be read,
+// std::invalid_argument if it is not a stats file.
+StatsTable read_stats(const string &path);
+
+#endif // NEAT_STATS_HPP
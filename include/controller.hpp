@@ -5,13 +5,25 @@
 
 #include <SFML/Graphics.hpp>
 #include "snakeEngine.hpp"
+#include "snakeEvaluator.hpp"
+#include "latencyHistogram.hpp"
+#include "lookahead.hpp"
+#include "NEAT/serialize.hpp"
 #include <memory>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
 
+// Key presses come from the window thread and actions are taken on the
+// simulation thread, so controllers must be safe to use from both
 class Controller {
     public:
         virtual ~Controller() = default;
         virtual void on_key_pressed(sf::Event &) {}
-        virtual Action get_action() = 0;
+        virtual Action get_action(const SnakeEngine &engine) = 0;
+        // Time of each tick of controllers that compute their actions,
+        // null for the others. Read it once the simulation has stopped.
+        virtual const LatencyHistogram *latency_histogram() const { return nullptr; }
 };
 
 class KeyboardController : public Controller {
@@ -31,20 +43,85 @@ class KeyboardController : public Controller {
             }
         }
 
-        Action get_action() override {
-            auto action = next_action;
-            next_action = Action::DoNothing;
+        Action get_action(const SnakeEngine &) override {
+            return next_action.exchange(Action::DoNothing);
+        }
+
+    private:
+        std::atomic<Action> next_action{Action::DoNothing};
+};
+
+// Plays a trained genome. The network is built once, and each tick
+// observes the game and runs it without allocating. The time of every
+// tick is recorded, to check inference fits the frame budget.
+class NeuralController : public Controller {
+    public:
+        explicit NeuralController(const Genome &genome) : policy(genome) {}
+
+        Action get_action(const SnakeEngine &engine) override {
+            auto start = std::chrono::steady_clock::now();
+            Action action = policy(engine);
+            latency.record(std::chrono::steady_clock::now() - start);
             return action;
         }
 
+        const LatencyHistogram *latency_histogram() const override {
+            return &latency;
+        }
+
     private:
-        Action next_action;
+        NetworkPolicy policy;
+        LatencyHistogram latency;
 };
 
-std::unique_ptr<Controller> make_controller(const std::string &input) {
+// Plays a trained genome, searching a few steps ahead before each action,
+// see LookaheadSearch
+class SearchController : public Controller {
+    public:
+        SearchController(const Genome &genome, const LookaheadParams &params) :
+            search(genome, params) {}
+
+        Action get_action(const SnakeEngine &engine) override {
+            auto start = std::chrono::steady_clock::now();
+            Action action = search.choose(engine);
+            latency.record(std::chrono::steady_clock::now() - start);
+            return action;
+        }
+
+        const LatencyHistogram *latency_histogram() const override {
+            return &latency;
+        }
+
+    private:
+        LookaheadSearch search;
+        LatencyHistogram latency;
+};
+
+/**
+ * Make the controller of a game mode.
+ *
+ * @param input "player" for the keyboard, "ai" for a trained genome,
+ * "search" for a trained genome searching ahead.
+ * @param genome_file The genome played in "ai" and "search" modes, see
+ * save_genome.
+ * @param search_params The parameters of the search in "search" mode.
+ * @return The controller.
+ */
+std::unique_ptr<Controller> make_controller(const std::string &input,
+    const std::string &genome_file = "best.genome",
+    const LookaheadParams &search_params = LookaheadParams()) {
     if (input == "player") {
         return std::make_unique<KeyboardController>();
     }
+    if (input == "ai" || input == "search") {
+        auto genome_config = std::make_shared<const GenomeConfig>(
+            NeatParams(Config("config.cfg")));
+        Genome genome = load_genome(genome_file, genome_config);
+        if (input == "search") {
+            return std::make_unique<SearchController>(genome, search_params);
+        }
+        return std::make_unique<NeuralController>(genome);
+    }
     throw std::invalid_argument("Unknown controller type: " + input);
 }
 
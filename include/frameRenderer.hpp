@@ -0,0 +1,125 @@
+// frameRenderer.hpp
+
+#ifndef FRAMERENDERER_HPP
+#define FRAMERENDERER_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "gameSnapshot.hpp"
+#include "palette.hpp"
+
+// An image in memory, 3 bytes per pixel in RGB order, row by row from
+// the top
+class Framebuffer {
+    public:
+        Framebuffer(int width, int height) :
+            _width(width), _height(height), _pixels(3 * (size_t) width * height) {
+            if (width <= 0 || height <= 0) {
+                throw std::invalid_argument("Framebuffer size must be greater than 0");
+            }
+        }
+
+        int width() const { return _width; }
+        int height() const { return _height; }
+        const std::vector<uint8_t> &pixels() const { return _pixels; }
+
+        Rgb pixel(int x, int y) const {
+            const uint8_t *p = &_pixels[3 * ((size_t) y * _width + x)];
+            return {p[0], p[1], p[2]};
+        }
+
+        void clear(Rgb color) {
+            fill_rect(0, 0, _width, _height, color);
+        }
+
+        // Fill the pixels whose centre is inside the rectangle, like the
+        // rasteriser of a graphics card
+        void fill_rect(float x, float y, float w, float h, Rgb color) {
+            int x0 = std::max(0, (int) std::ceil(x - 0.5f));
+            int x1 = std::min(_width, (int) std::ceil(x + w - 0.5f));
+            int y0 = std::max(0, (int) std::ceil(y - 0.5f));
+            int y1 = std::min(_height, (int) std::ceil(y + h - 0.5f));
+            for (int row = y0; row < y1; row++) {
+                uint8_t *p = &_pixels[3 * ((size_t) row * _width + x0)];
+                for (int col = x0; col < x1; col++) {
+                    *p++ = color.r;
+                    *p++ = color.g;
+                    *p++ = color.b;
+                }
+            }
+        }
+
+    private:
+        int _width;
+        int _height;
+        std::vector<uint8_t> _pixels;
+};
+
+// Draws snapshots of a game into a Framebuffer, without a window, with
+// the layout and colours of GameRenderer: the grid takes 80% of the
+// image, and every field is framed by a stroke. Text is not drawn.
+class FrameRenderer {
+    public:
+        FrameRenderer(int image_width, int image_height, int width, int height) :
+            image_width(image_width), image_height(image_height),
+            width(width), height(height) {
+            if (width <= 0 || height <= 0) {
+                throw std::invalid_argument("Board size must be greater than 0");
+            }
+            grid_size = {image_width * 0.8f, image_height * 0.8f};
+            grid_offset = {image_width * 0.1f, image_height * 0.1f};
+            field_size = {grid_size[0] / width - 2, grid_size[1] / height - 2};
+        }
+
+        Framebuffer make_framebuffer() const {
+            return Framebuffer(image_width, image_height);
+        }
+
+        void draw(const GameSnapshot &game, Framebuffer &frame) const {
+            frame.clear(Palette::BACKGROUND);
+            frame.fill_rect(grid_offset[0], grid_offset[1], grid_size[0], grid_size[1],
+                Palette::STROKE);
+            for (int i = 0; i < height; i++) {
+                for (int j = 0; j < width; j++) {
+                    fill_field(frame, {i, j}, Palette::BACKGROUND);
+                }
+            }
+
+            const auto &body = game.body;
+            for (size_t i = 0; i < body.size(); i++) {
+                fill_field(frame, body[i], gradient(i, body.size()));
+            }
+            if (!body.empty()) {
+                fill_field(frame, game.food, Palette::FOOD);
+            }
+        }
+
+        // Top left corner of a field, in pixels
+        std::array<float, 2> to_position(Coordinates c) const {
+            return {
+                grid_offset[0] + c.col * (field_size[0] + 2) + 1,
+                grid_offset[1] + c.row * (field_size[1] + 2) + 1
+            };
+        }
+
+    private:
+        int image_width;
+        int image_height;
+        int width;
+        int height;
+        std::array<float, 2> grid_size;
+        std::array<float, 2> grid_offset;
+        std::array<float, 2> field_size;
+        SnakeGradient<Rgb> gradient;
+
+        void fill_field(Framebuffer &frame, Coordinates c, Rgb color) const {
+            auto position = to_position(c);
+            frame.fill_rect(position[0], position[1], field_size[0], field_size[1], color);
+        }
+};
+
+#endif // FRAMERENDERER_HPP
@@ -0,0 +1,307 @@
+// frameWriter.hpp
+
+#ifndef FRAMEWRITER_HPP
+#define FRAMEWRITER_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "frameRenderer.hpp"
+
+// Image and video output of framebuffers, with no external encoder: PNG
+// images with uncompressed (stored) deflate blocks, and YUV4MPEG2 (Y4M)
+// video, which most players and ffmpeg read.
+
+inline uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0) {
+    static const std::array<uint32_t, 256> table = []() {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) {
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[n] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+inline uint32_t adler32(const uint8_t *data, size_t size) {
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < size; i++) {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+/**
+ * Encode a framebuffer as a PNG image, 8-bit RGB, without compression.
+ *
+ * @param frame The image.
+ * @return The bytes of the PNG file.
+ */
+inline std::vector<uint8_t> encode_png(const Framebuffer &frame) {
+    auto put32 = [](std::vector<uint8_t> &out, uint32_t value) {
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            out.push_back((value >> shift) & 0xFF);
+        }
+    };
+    std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    auto chunk = [&](const char *type, const std::vector<uint8_t> &data) {
+        put32(png, data.size());
+        size_t start = png.size();
+        png.insert(png.end(), type, type + 4);
+        png.insert(png.end(), data.begin(), data.end());
+        put32(png, crc32(&png[start], png.size() - start));
+    };
+
+    std::vector<uint8_t> header;
+    put32(header, frame.width());
+    put32(header, frame.height());
+    // 8 bits per channel, RGB, deflate, adaptive filters, no interlace
+    header.insert(header.end(), {8, 2, 0, 0, 0});
+    chunk("IHDR", header);
+
+    // Every row starts with its filter type, 0 for none
+    const size_t row_bytes = 3 * (size_t) frame.width();
+    std::vector<uint8_t> raw;
+    raw.reserve((row_bytes + 1) * frame.height());
+    for (int row = 0; row < frame.height(); row++) {
+        raw.push_back(0);
+        auto begin = frame.pixels().begin() + row * row_bytes;
+        raw.insert(raw.end(), begin, begin + row_bytes);
+    }
+
+    // A zlib stream of stored deflate blocks, up to 65535 bytes each
+    std::vector<uint8_t> zlib = {0x78, 0x01};
+    bool last = false;
+    for (size_t offset = 0; !last; ) {
+        size_t size = std::min<size_t>(65535, raw.size() - offset);
+        last = offset + size == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(size & 0xFF);
+        zlib.push_back(size >> 8);
+        zlib.push_back(~size & 0xFF);
+        zlib.push_back((~size >> 8) & 0xFF);
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + size);
+        offset += size;
+    }
+    put32(zlib, adler32(raw.data(), raw.size()));
+    chunk("IDAT", zlib);
+    chunk("IEND", {});
+    return png;
+}
+
+inline void write_file(const std::string &path, const std::vector<uint8_t> &bytes) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+    if (!file) {
+        throw std::runtime_error("Could not write " + path);
+    }
+}
+
+// YUV4MPEG2 video with 4:2:0 chroma and full-range BT.601 colours, the
+// layout of JPEG. Frames have a fixed size, so they can be written in
+// any order.
+class Y4mFormat {
+    public:
+        Y4mFormat(int width, int height, int fps) : width(width), height(height) {
+            if (width % 2 != 0 || height % 2 != 0) {
+                throw std::invalid_argument("Y4M frames need an even width and height");
+            }
+            header = "YUV4MPEG2 W" + std::to_string(width) + " H" + std::to_string(height)
+                + " F" + std::to_string(fps) + ":1 Ip A1:1 C420jpeg\n";
+        }
+
+        const std::string &file_header() const {
+            return header;
+        }
+
+        size_t frame_size() const {
+            return FRAME_HEADER.size() + (size_t) width * height * 3 / 2;
+        }
+
+        // Offset of a frame in the file
+        size_t frame_offset(size_t index) const {
+            return header.size() + index * frame_size();
+        }
+
+        // Convert a framebuffer to a frame, frame_size() bytes
+        void encode(const Framebuffer &frame, std::vector<uint8_t> &out) const {
+            out.resize(frame_size());
+            std::copy(FRAME_HEADER.begin(), FRAME_HEADER.end(), out.begin());
+            uint8_t *y_plane = &out[FRAME_HEADER.size()];
+            uint8_t *u_plane = y_plane + (size_t) width * height;
+            uint8_t *v_plane = u_plane + (size_t) width * height / 4;
+            for (int row = 0; row < height; row++) {
+                for (int col = 0; col < width; col++) {
+                    Rgb p = frame.pixel(col, row);
+                    y_plane[(size_t) row * width + col] = clamp(
+                        0.299 * p.r + 0.587 * p.g + 0.114 * p.b);
+                }
+            }
+            // Chroma of each 2x2 block of pixels
+            for (int row = 0; row < height / 2; row++) {
+                for (int col = 0; col < width / 2; col++) {
+                    double r = 0, g = 0, b = 0;
+                    for (int k = 0; k < 4; k++) {
+                        Rgb p = frame.pixel(2 * col + k % 2, 2 * row + k / 2);
+                        r += p.r / 4.0;
+                        g += p.g / 4.0;
+                        b += p.b / 4.0;
+                    }
+                    size_t i = (size_t) row * (width / 2) + col;
+                    u_plane[i] = clamp(128 - 0.168736 * r - 0.331264 * g + 0.5 * b);
+                    v_plane[i] = clamp(128 + 0.5 * r - 0.418688 * g - 0.081312 * b);
+                }
+            }
+        }
+
+    private:
+        inline static const std::string FRAME_HEADER = "FRAME\n";
+
+        int width;
+        int height;
+        std::string header;
+
+        static uint8_t clamp(double value) {
+            return static_cast<uint8_t>(std::min(255.0, std::max(0.0, value + 0.5)));
+        }
+};
+
+/**
+ * Render frames [first, last) of a recording on num_threads threads, each
+ * taking a contiguous range of frames with its own framebuffer.
+ *
+ * @param first The first frame.
+ * @param last One past the last frame.
+ * @param num_threads The number of threads.
+ * @param render_range Called with a range of frames on each thread.
+ */
+template <typename RenderRange>
+void render_in_parallel(size_t first, size_t last, unsigned num_threads,
+    RenderRange &&render_range) {
+    size_t count = last > first ? last - first : 0;
+    num_threads = std::max(1u, (unsigned) std::min<size_t>(num_threads, count));
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors(num_threads);
+    for (unsigned t = 0; t < num_threads; t++) {
+        size_t begin = first + count * t / num_threads;
+        size_t end = first + count * (t + 1) / num_threads;
+        threads.emplace_back([&, t, begin, end]() {
+            try {
+                render_range(begin, end);
+            } catch (...) {
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+/**
+ * Write snapshots as PNG images, path_prefix followed by the frame
+ * number with six digits and ".png".
+ *
+ * @param states The snapshots.
+ * @param renderer The renderer.
+ * @param path_prefix The start of the file names, e.g. "frames/snake_".
+ * @param first The first snapshot to write.
+ * @param last One past the last snapshot to write.
+ * @param num_threads The number of threads.
+ */
+inline void export_png(const std::vector<GameSnapshot> &states,
+    const FrameRenderer &renderer, const std::string &path_prefix,
+    size_t first, size_t last, unsigned num_threads) {
+    last = std::min(last, states.size());
+    render_in_parallel(first, last, num_threads, [&](size_t begin, size_t end) {
+        Framebuffer frame = renderer.make_framebuffer();
+        char number[32];
+        for (size_t i = begin; i < end; i++) {
+            renderer.draw(states[i], frame);
+            snprintf(number, sizeof(number), "%06zu", i);
+            write_file(path_prefix + number + ".png", encode_png(frame));
+        }
+    });
+}
+
+/**
+ * Write snapshots as one Y4M video. Each thread writes its frames
+ * straight to their place in the file.
+ *
+ * @param states The snapshots.
+ * @param renderer The renderer; its image size must be even.
+ * @param path The video file.
+ * @param fps The frame rate of the video.
+ * @param first The first snapshot to write.
+ * @param last One past the last snapshot to write.
+ * @param num_threads The number of threads.
+ */
+inline void export_y4m(const std::vector<GameSnapshot> &states,
+    const FrameRenderer &renderer, const std::string &path, int fps,
+    size_t first, size_t last, unsigned num_threads) {
+    last = std::min(last, states.size());
+    Framebuffer probe = renderer.make_framebuffer();
+    Y4mFormat format(probe.width(), probe.height(), fps);
+
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open " + path);
+    }
+    auto write_at = [&](const void *data, size_t size, size_t offset) {
+        const char *bytes = static_cast<const char *>(data);
+        while (size > 0) {
+            ssize_t written = pwrite(fd, bytes, size, offset);
+            if (written <= 0) {
+                throw std::runtime_error("Could not write " + path);
+            }
+            bytes += written;
+            size -= written;
+            offset += written;
+        }
+    };
+
+    try {
+        const std::string &header = format.file_header();
+        write_at(header.data(), header.size(), 0);
+        render_in_parallel(first, last, num_threads, [&](size_t begin, size_t end) {
+            Framebuffer frame = renderer.make_framebuffer();
+            std::vector<uint8_t> bytes;
+            for (size_t i = begin; i < end; i++) {
+                renderer.draw(states[i], frame);
+                format.encode(frame, bytes);
+                write_at(bytes.data(), bytes.size(), format.frame_offset(i - first));
+            }
+        });
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    if (close(fd) != 0) {
+        throw std::runtime_error("Could not write " + path);
+    }
+}
+
+#endif // FRAMEWRITER_HPP
@@ -0,0 +1,166 @@
+// gameRenderer.hpp
+
+#ifndef GAMERENDERER_HPP
+#define GAMERENDERER_HPP
+
+#include <SFML/Graphics.hpp>
+#include <cmath>
+#include <string>
+#include "gameSnapshot.hpp"
+#include "palette.hpp"
+
+// Define the GameRendererConfig class
+class GameRendererConfig {
+    public:
+        GameRendererConfig() {}
+
+        sf::Vector2f grid_size;
+        sf::Vector2f grid_offset;
+        sf::Vector2f field_size;
+        sf::Vector2f field_offset;
+        sf::Color background_color = to_color(Palette::BACKGROUND);
+        sf::Color stroke_color = to_color(Palette::STROKE);
+        sf::Color snake_color = to_color(Palette::SNAKE);
+        sf::Color food_color = to_color(Palette::FOOD);
+
+        static sf::Color to_color(Rgb rgb) {
+            return {rgb.r, rgb.g, rgb.b};
+        }
+};
+
+// Set the four corners of a quad of a sf::Quads vertex array
+inline void set_quad(sf::VertexArray &vertices, size_t quad,
+    sf::Vector2f position, sf::Vector2f size, sf::Color color) {
+    sf::Vertex *corner = &vertices[4 * quad];
+    corner[0].position = position;
+    corner[1].position = {position.x + size.x, position.y};
+    corner[2].position = {position.x + size.x, position.y + size.y};
+    corner[3].position = {position.x, position.y + size.y};
+    for (int k = 0; k < 4; k++) {
+        corner[k].color = color;
+    }
+}
+
+// Top left corner of a cell of a board whose first cell is at origin,
+// with pitch between the corners of neighbouring cells
+inline sf::Vector2f cell_position(sf::Vector2f origin, sf::Vector2f pitch, Coordinates c) {
+    return {origin.x + c.col * pitch.x, origin.y + c.row * pitch.y};
+}
+
+// Draws snapshots of a game in a few draw calls. The grid never changes,
+// so its vertices are built once; the snake and the food share a second
+// vertex array that is rewritten in place each frame, and the score
+// text is only updated when the score changes.
+class GameRenderer {
+    public:
+        GameRenderer(sf::RenderWindow &window, int width, int height,
+            bool show_score = false) :
+            window(window), width(width), height(height), show_score(show_score),
+            grid(sf::Quads), pieces(sf::Quads), shown_score(-1) {
+            set_config();
+            build_grid();
+            has_font = font.loadFromFile("assets/Arial.ttf");
+            score_text.setFont(font);
+            score_text.setCharacterSize(24);
+            score_text.setFillColor(sf::Color::White);
+            score_text.setPosition(10, 10);
+            message_text = score_text;
+        }
+
+        // Set config values from window size and board dimensions
+        void set_config() {
+            // Grid size is 80% of the window size, with a 10% offset
+            // on each side
+            config.grid_size = {window.getSize().x * 0.8f,
+                            window.getSize().y * 0.8f};
+            config.grid_offset = {window.getSize().x * 0.1f,
+                            window.getSize().y * 0.1f};
+            // Field size is the grid size divided by the number of
+            // rows and columns, minus the stroke width
+            config.field_size = {
+                config.grid_size.x / width - 2,
+                config.grid_size.y / height - 2
+            };
+            config.field_offset = {1, 1};
+        }
+
+        void draw(const GameSnapshot &game) {
+            window.clear(config.background_color);
+            window.draw(grid);
+            update_pieces(game);
+            window.draw(pieces);
+            if (show_score) {
+                draw_score(game.score);
+            }
+        }
+
+        // Text in the middle of the window, e.g. at the end of a game
+        void draw_message(const std::string &message) {
+            if (!has_font) {
+                return;
+            }
+            message_text.setString(message);
+            message_text.setPosition(window.getSize().x * 0.5f,
+                window.getSize().y * 0.5f);
+            window.draw(message_text);
+        }
+
+    private:
+        sf::RenderWindow &window;
+        int width;
+        int height;
+        bool show_score;
+        GameRendererConfig config;
+        SnakeGradient<sf::Color> gradient;
+        sf::VertexArray grid;
+        sf::VertexArray pieces;
+        sf::Font font;
+        bool has_font;
+        sf::Text score_text;
+        sf::Text message_text;
+        int shown_score;
+
+        // The stroke behind the whole grid, and a field for every cell
+        void build_grid() {
+            grid.resize(4 * (1 + width * height));
+            set_quad(grid, 0, config.grid_offset, config.grid_size, config.stroke_color);
+            size_t quad = 1;
+            for (int i = 0; i < height; i++) {
+                for (int j = 0; j < width; j++) {
+                    set_quad(grid, quad++, to_position({i, j}), config.field_size,
+                        config.background_color);
+                }
+            }
+        }
+
+        void update_pieces(const GameSnapshot &game) {
+            const auto &body = game.body;
+            pieces.resize(4 * (body.size() + 1));
+            for (size_t i = 0; i < body.size(); i++) {
+                set_quad(pieces, i, to_position(body[i]), config.field_size,
+                    gradient(i, body.size()));
+            }
+            set_quad(pieces, body.size(), to_position(game.food), config.field_size,
+                config.food_color);
+        }
+
+        void draw_score(int score) {
+            if (!has_font) {
+                return;
+            }
+            if (score != shown_score) {
+                shown_score = score;
+                score_text.setString("Score: " + std::to_string(shown_score));
+            }
+            window.draw(score_text);
+        }
+
+        sf::Vector2f to_position(Coordinates c) const {
+            // Calculate the position of the field, such that
+            // the offset of the field is what makes the stroke
+            return cell_position(config.grid_offset + config.field_offset,
+                config.field_size + sf::Vector2f(2, 2), c);
+        }
+};
+
+#endif // GAMERENDERER_HPP
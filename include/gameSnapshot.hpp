@@ -0,0 +1,37 @@
+// gameSnapshot.hpp
+
+#ifndef GAMESNAPSHOT_HPP
+#define GAMESNAPSHOT_HPP
+
+#include <cstdint>
+#include <vector>
+#include "snakeEngine.hpp"
+
+// What is needed to draw a game at one step, copied out of the engine
+// so another thread can draw it while the game goes on
+struct GameSnapshot {
+    int width = 0;
+    int height = 0;
+    // Head first
+    std::vector<Coordinates> body;
+    Coordinates food = {0, 0};
+    int score = 0;
+    GameState state = GameState::Running;
+    uint64_t step = 0;
+
+    // Copy the state of a game. The body reuses the memory of the
+    // previous snapshot, so a snapshot taken every step does not allocate
+    // once the snake stops growing.
+    void capture(const SnakeEngine &engine, GameState state, uint64_t step) {
+        width = engine._width();
+        height = engine._height();
+        const auto &snake = engine._snake().body;
+        body.assign(snake.begin(), snake.end());
+        food = engine._food();
+        score = engine._score();
+        this->state = state;
+        this->step = step;
+    }
+};
+
+#endif // GAMESNAPSHOT_HPP
@@ -3,8 +3,9 @@
 #ifndef HSV_COLOR_HPP
 #define HSV_COLOR_HPP
 
+#include <algorithm>
 #include <cmath>
-#include <SFML/Graphics.hpp>
+#include <cstdint>
 
 struct HsvColor {
     double h; // Hue
@@ -14,8 +15,10 @@ struct HsvColor {
     HsvColor(double hue, double saturation, double value)
         : h(hue), s(saturation), v(value) {}
 
-    // Convert HSV to RGB and return an sf::Color
-    sf::Color to_rgb() const {
+    // Convert HSV to RGB, as any colour type with 8-bit r, g and b,
+    // e.g. sf::Color
+    template <typename Color>
+    Color to_rgb() const {
         double r = 0, g = 0, b = 0;
 
         int i = static_cast<int>(h / 60.0) % 6;
@@ -33,15 +36,16 @@ struct HsvColor {
             case 5: r = v, g = p, b = q; break;
         }
 
-        return sf::Color(
-            static_cast<sf::Uint8>(r * 255),
-            static_cast<sf::Uint8>(g * 255),
-            static_cast<sf::Uint8>(b * 255)
-        );
+        return Color{
+            static_cast<uint8_t>(r * 255),
+            static_cast<uint8_t>(g * 255),
+            static_cast<uint8_t>(b * 255)
+        };
     }
 
-    // Static function to create an HsvColor from an sf::Color (RGB)
-    static HsvColor from_rgb(const sf::Color& color) {
+    // Static function to create an HsvColor from an RGB colour
+    template <typename Color>
+    static HsvColor from_rgb(const Color& color) {
         double r = color.r / 255.0;
         double g = color.g / 255.0;
         double b = color.b / 255.0;
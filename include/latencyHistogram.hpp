@@ -0,0 +1,118 @@
+// latencyHistogram.hpp
+
+#ifndef LATENCYHISTOGRAM_HPP
+#define LATENCYHISTOGRAM_HPP
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Histogram of durations, in nanoseconds, in a fixed array of buckets:
+// below 16 ns every value has a bucket, and above, every power of two is
+// split in 8 equal buckets, so percentiles are within 12.5% of the true
+// value. Recording is a few instructions and never allocates.
+class LatencyHistogram {
+    public:
+        static constexpr int LINEAR_BUCKETS = 16;
+        static constexpr int BUCKETS_PER_POWER = 8;
+        // Longer durations go to the last bucket; 2^40 ns is about 18 minutes
+        static constexpr int MAX_POWER = 40;
+
+        LatencyHistogram() : buckets{}, _count(0), _max(0) {}
+
+        void record(std::chrono::nanoseconds duration) {
+            uint64_t ns = std::max<int64_t>(0, duration.count());
+            buckets[bucket(ns)]++;
+            _count++;
+            _max = std::max(_max, ns);
+        }
+
+        uint64_t count() const {
+            return _count;
+        }
+
+        uint64_t max() const {
+            return _max;
+        }
+
+        // Upper end of the bucket holding the p-th percentile, p from 0
+        // to 100, capped at the maximum
+        uint64_t percentile(double p) const {
+            if (_count == 0) {
+                return 0;
+            }
+            uint64_t rank = std::max<uint64_t>(1, std::ceil(p / 100.0 * _count));
+            uint64_t seen = 0;
+            for (size_t i = 0; i < buckets.size(); i++) {
+                seen += buckets[i];
+                if (seen >= rank) {
+                    // The last bucket has no upper end
+                    return i + 1 == buckets.size() ? _max : std::min(upper_bound(i), _max);
+                }
+            }
+            return _max;
+        }
+
+        // e.g. "p50 1.2us, p99 3.4us, max 20.1us over 1000 ticks"
+        std::string summary() const {
+            return "p50 " + format(percentile(50)) + ", p99 " + format(percentile(99))
+                + ", max " + format(_max) + " over " + std::to_string(_count) + " ticks";
+        }
+
+    private:
+        // The first power of two split in buckets, 2^4 = LINEAR_BUCKETS
+        static constexpr int MIN_POWER = 4;
+        static constexpr size_t NUM_BUCKETS =
+            LINEAR_BUCKETS + (MAX_POWER - MIN_POWER) * BUCKETS_PER_POWER;
+
+        std::array<uint64_t, NUM_BUCKETS> buckets;
+        uint64_t _count;
+        uint64_t _max;
+
+        static int log2(uint64_t value) {
+            int power = 0;
+            while (value >>= 1) {
+                power++;
+            }
+            return power;
+        }
+
+        static size_t bucket(uint64_t ns) {
+            if (ns < LINEAR_BUCKETS) {
+                return ns;
+            }
+            int power = log2(ns);
+            // The three bits below the top one pick the bucket of the power
+            size_t sub = (ns >> (power - 3)) & (BUCKETS_PER_POWER - 1);
+            size_t index = LINEAR_BUCKETS + (power - MIN_POWER) * BUCKETS_PER_POWER + sub;
+            return std::min(index, NUM_BUCKETS - 1);
+        }
+
+        static uint64_t upper_bound(size_t index) {
+            if (index < LINEAR_BUCKETS) {
+                return index;
+            }
+            int power = MIN_POWER + (index - LINEAR_BUCKETS) / BUCKETS_PER_POWER;
+            size_t sub = (index - LINEAR_BUCKETS) % BUCKETS_PER_POWER;
+            uint64_t width = uint64_t(1) << (power - 3);
+            return (uint64_t(1) << power) + (sub + 1) * width - 1;
+        }
+
+        static std::string format(uint64_t ns) {
+            char text[32];
+            if (ns < 1000) {
+                snprintf(text, sizeof(text), "%lluns", (unsigned long long) ns);
+            } else if (ns < 1000000) {
+                snprintf(text, sizeof(text), "%.1fus", ns / 1e3);
+            } else {
+                snprintf(text, sizeof(text), "%.1fms", ns / 1e6);
+            }
+            return text;
+        }
+};
+
+#endif // LATENCYHISTOGRAM_HPP
@@ -0,0 +1,361 @@
+// lookahead.hpp
+
+#ifndef LOOKAHEAD_HPP
+#define LOOKAHEAD_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "snakeEngine.hpp"
+#include "snakeEvaluator.hpp"
+
+struct LookaheadParams {
+    // Steps searched after the first one
+    int depth = 4;
+    // Actions tried at each searched step, the network's favourites first
+    int beam_width = 3;
+    // Steps the network plays alone from each leaf, to value it
+    int rollout_steps = 20;
+    // Steps simulated per tick, shared equally by the three first actions
+    size_t max_nodes = 100000;
+    // Hard cap on the time of a tick
+    std::chrono::microseconds time_budget{2000};
+    unsigned num_threads = 3;
+    // Board of the searched games. A searched line, depth + 1 +
+    // rollout_steps steps, must fit in the steps an engine can be
+    // restored after, width * height, see SnakeEngine::save_state.
+    int board_width = 20;
+    int board_height = 20;
+};
+
+// Chooses actions by searching the game ahead, with the network of a
+// genome valuing the leaves by playing on from them. The subtrees of the
+// three first actions are searched on up to three threads, each deeper
+// and deeper until it runs out of its share of the node budget; the
+// decision is made at the deepest depth all three finished. The states
+// of the search are saved and restored in place, see
+// SnakeEngine::save_state, so searching does not allocate. Each thread
+// follows the game by playing the chosen action on its own engine, and
+// only copies the game when it went elsewhere, e.g. after a restart.
+//
+// The action only depends on the game, the genome and the parameters, so
+// it is the same for any number of threads, unless the time budget runs
+// out first; the time budget is only a cap for slow machines.
+class LookaheadSearch {
+    public:
+        static constexpr int MAX_DEPTH = 16;
+
+        LookaheadSearch(const Genome &genome, const LookaheadParams &params) :
+            params(params), policy(genome), _last_depth(0) {
+            if (params.depth < 0 || params.depth > MAX_DEPTH) {
+                throw std::invalid_argument("Search depth must be between 0 and 16");
+            }
+            if (params.beam_width < 1 || params.beam_width > SnakeOutputs) {
+                throw std::invalid_argument("Beam width must be between 1 and 3");
+            }
+            if (params.board_width < 1 || params.board_height < 1
+                || params.depth + 1 + params.rollout_steps
+                    > (int64_t) params.board_width * params.board_height) {
+                throw std::invalid_argument(
+                    "Search depth and rollout steps must fit in the cells of the board");
+            }
+            unsigned num_threads = std::clamp(params.num_threads, 1u, (unsigned) SnakeOutputs);
+            for (unsigned i = 0; i < num_threads; i++) {
+                scratch.push_back({SnakeEngine{}, NetworkPolicy(genome), {}, false});
+            }
+            for (unsigned i = 1; i < num_threads; i++) {
+                workers.emplace_back([this, i]() { work(scratch[i]); });
+            }
+        }
+
+        ~LookaheadSearch() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            start.notify_all();
+            for (auto &worker : workers) {
+                worker.join();
+            }
+        }
+
+        LookaheadSearch(const LookaheadSearch &) = delete;
+        LookaheadSearch &operator=(const LookaheadSearch &) = delete;
+
+        // Throws std::invalid_argument for a board other than that of
+        // the parameters
+        Action choose(const SnakeEngine &engine) {
+            if (engine._width() != params.board_width
+                || engine._height() != params.board_height) {
+                throw std::invalid_argument("The board is not the one searched");
+            }
+            root = &engine;
+            deadline = std::chrono::steady_clock::now() + params.time_budget;
+            next_subtree = 0;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                generation++;
+                pending = workers.size();
+            }
+            start.notify_all();
+            run_subtrees(scratch[0]);
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                done.wait(lock, [this]() { return pending == 0; });
+            }
+
+            int depth = params.depth;
+            for (const Subtree &subtree : subtrees) {
+                depth = std::min(depth, subtree.completed);
+            }
+            _last_depth = depth;
+
+            // Ties go to the action the network prefers
+            std::array<int, SnakeOutputs> order = ranked(policy.scores(engine));
+            int best = order[0];
+            for (int action : order) {
+                if (subtrees[action].values[depth] > subtrees[best].values[depth]) {
+                    best = action;
+                }
+            }
+            last_action = best;
+            return static_cast<Action>(best);
+        }
+
+        // Depth the last action was chosen at
+        int last_depth() const {
+            return _last_depth;
+        }
+
+    private:
+        // Values of game ends: dying costs more than any amount of
+        // survival, and winning is worth more than any score
+        static constexpr float DEATH_PENALTY = 2.0f;
+        static constexpr float WIN_BONUS = 1e6f;
+        // Steps between checks of the clock
+        static constexpr size_t CLOCK_INTERVAL = 64;
+
+        // What a thread searches with
+        struct Scratch {
+            SnakeEngine engine;
+            NetworkPolicy policy;
+            // The root of the last tick searched, in engine
+            SnakeEngine::State root;
+            bool has_root;
+        };
+
+        // Search of the game after one first action
+        struct Subtree {
+            // Value at each depth, up to completed
+            std::array<float, MAX_DEPTH + 1> values;
+            int completed;
+            size_t nodes;
+            bool stopped;
+        };
+
+        LookaheadParams params;
+        NetworkPolicy policy;
+        std::vector<Scratch> scratch;
+        std::array<Subtree, SnakeOutputs> subtrees;
+        int _last_depth;
+
+        // The tick being searched, and the action chosen at the last one
+        const SnakeEngine *root = nullptr;
+        int last_action = -1;
+        std::chrono::steady_clock::time_point deadline;
+        std::atomic<int> next_subtree{0};
+
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable start;
+        std::condition_variable done;
+        uint64_t generation = 0;
+        size_t pending = 0;
+        bool stopping = false;
+
+        void work(Scratch &own) {
+            uint64_t seen = 0;
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    start.wait(lock, [&]() { return stopping || generation != seen; });
+                    if (stopping) {
+                        return;
+                    }
+                    seen = generation;
+                }
+                run_subtrees(own);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    pending--;
+                }
+                done.notify_one();
+            }
+        }
+
+        void run_subtrees(Scratch &own) {
+            follow_root(own);
+            for (int action = next_subtree++; action < SnakeOutputs; action = next_subtree++) {
+                search_subtree(action, own);
+            }
+        }
+
+        // Actions by score, highest first, ties by index
+        static std::array<int, SnakeOutputs> ranked(const float *scores) {
+            // Insertion sort, which keeps ties in order and does not allocate
+            std::array<int, SnakeOutputs> order;
+            for (int i = 0; i < SnakeOutputs; i++) {
+                int j = i;
+                for (; j > 0 && scores[order[j - 1]] < scores[i]; j--) {
+                    order[j] = order[j - 1];
+                }
+                order[j] = i;
+            }
+            return order;
+        }
+
+        // Bring the engine of a scratch to the root and save it there:
+        // by playing the last chosen action from the last root, if that
+        // is where the game went, otherwise by copying the game
+        void follow_root(Scratch &own) {
+            if (own.has_root && last_action >= 0) {
+                own.engine.restore_state(own.root);
+                own.engine.process(static_cast<Action>(last_action));
+                if (same_game(own.engine, *root)) {
+                    own.root = own.engine.save_state();
+                    return;
+                }
+            }
+            own.engine = *root;
+            own.root = own.engine.save_state();
+            own.has_root = true;
+        }
+
+        static bool same_game(const SnakeEngine &a, const SnakeEngine &b) {
+            const SnakeBody &body_a = a._snake().body, &body_b = b._snake().body;
+            RNG::State rng_a = a.save_state().rng.state(), rng_b = b.save_state().rng.state();
+            return a._width() == b._width() && a._height() == b._height()
+                && a._allow_teleport() == b._allow_teleport()
+                && a._snake().grow == b._snake().grow && a._food() == b._food()
+                && a._score() == b._score() && a._direction() == b._direction()
+                && std::equal(std::begin(rng_a.s), std::end(rng_a.s), std::begin(rng_b.s))
+                && body_a.size() == body_b.size()
+                && std::equal(body_a.begin(), body_a.end(), body_b.begin());
+        }
+
+        float horizon() const {
+            return params.depth + 1 + params.rollout_steps;
+        }
+
+        // Value of a game that ended after steps steps from the root
+        float end_value(const SnakeEngine &engine, GameState state, int steps) const {
+            if (state == GameState::Win) {
+                return engine._score() + 1 + WIN_BONUS;
+            }
+            return engine._score() + steps / horizon() - DEATH_PENALTY;
+        }
+
+        void search_subtree(int action, Scratch &own) {
+            Subtree &subtree = subtrees[action];
+            subtree.completed = -1;
+            subtree.nodes = 1;
+            own.engine.restore_state(own.root);
+            GameState state = own.engine.process(static_cast<Action>(action));
+            if (state != GameState::Running) {
+                float value = end_value(own.engine, state, 1);
+                subtree.values.fill(value);
+                subtree.completed = params.depth;
+                return;
+            }
+
+            // Deeper and deeper, while the budget lasts. Depth 0 is
+            // always finished, so there is always a decision.
+            const SnakeEngine::State after = own.engine.save_state();
+            const size_t budget = params.max_nodes / SnakeOutputs;
+            for (int depth = 0; depth <= params.depth; depth++) {
+                subtree.stopped = false;
+                float value = search(own, subtree, depth, 1,
+                    depth == 0 ? std::numeric_limits<size_t>::max() : budget);
+                own.engine.restore_state(after);
+                if (subtree.stopped) {
+                    break;
+                }
+                subtree.values[depth] = value;
+                subtree.completed = depth;
+            }
+        }
+
+        // Count a simulated step, and stop the search if it is over budget
+        bool spend(Subtree &subtree, size_t budget) {
+            subtree.nodes++;
+            if (subtree.nodes > budget || (subtree.nodes % CLOCK_INTERVAL == 0
+                && budget != std::numeric_limits<size_t>::max()
+                && std::chrono::steady_clock::now() > deadline)) {
+                subtree.stopped = true;
+            }
+            return !subtree.stopped;
+        }
+
+        /**
+         * Best value reachable from the game of a scratch.
+         *
+         * @param own The scratch, restored before returning.
+         * @param subtree The subtree, counting the nodes.
+         * @param depth The steps left to search.
+         * @param steps The steps from the root.
+         * @param budget The nodes the subtree may use.
+         * @return The value, meaningless if the subtree was stopped.
+         */
+        float search(Scratch &own, Subtree &subtree, int depth, int steps, size_t budget) {
+            if (depth == 0) {
+                return rollout(own, subtree, steps, budget);
+            }
+            std::array<int, SnakeOutputs> order = ranked(own.policy.scores(own.engine));
+            const SnakeEngine::State saved = own.engine.save_state();
+            float best = -std::numeric_limits<float>::infinity();
+            for (int k = 0; k < params.beam_width; k++) {
+                if (!spend(subtree, budget)) {
+                    return best;
+                }
+                GameState state = own.engine.process(static_cast<Action>(order[k]));
+                float value = state == GameState::Running
+                    ? search(own, subtree, depth - 1, steps + 1, budget)
+                    : end_value(own.engine, state, steps + 1);
+                own.engine.restore_state(saved);
+                if (subtree.stopped) {
+                    return best;
+                }
+                best = std::max(best, value);
+            }
+            return best;
+        }
+
+        // Value of a leaf: the network plays on alone for a few steps
+        float rollout(Scratch &own, Subtree &subtree, int steps, size_t budget) {
+            const SnakeEngine::State saved = own.engine.save_state();
+            float value = own.engine._score() + 1.0f;
+            for (int i = 0; i < params.rollout_steps; i++) {
+                if (!spend(subtree, budget)) {
+                    break;
+                }
+                GameState state = own.engine.process(own.policy(own.engine));
+                if (state != GameState::Running) {
+                    value = end_value(own.engine, state, steps + i + 1);
+                    break;
+                }
+                value = own.engine._score() + 1.0f;
+            }
+            own.engine.restore_state(saved);
+            return value;
+        }
+};
+
+#endif // LOOKAHEAD_HPP
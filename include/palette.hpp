@@ -0,0 +1,63 @@
+// palette.hpp
+
+#ifndef PALETTE_HPP
+#define PALETTE_HPP
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include "hsv_color.hpp"
+
+struct Rgb {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+
+    bool operator==(const Rgb &other) const {
+        return r == other.r && g == other.g && b == other.b;
+    }
+};
+
+// Colours of the game, shared by the window and the offscreen renderers
+struct Palette {
+    static constexpr Rgb BACKGROUND = { 23, 23, 33 };
+    static constexpr Rgb STROKE = { 57, 57, 67 };
+    static constexpr Rgb SNAKE = { 228, 63, 63 };
+    static constexpr Rgb FOOD = { 72, 201, 176 };
+
+    // The base colour with its hue turned by position, from 0 to 1, of
+    // the colour wheel
+    static Rgb color_wheel(Rgb base, double position) {
+        auto hsv = HsvColor::from_rgb(base);
+        hsv.h = fmod(hsv.h + 360 * position, 360);
+        return hsv.to_rgb<Rgb>();
+    }
+};
+
+// Colours along a snake, as any colour type built from 8-bit r, g and b,
+// e.g. sf::Color. They are computed once, in SIZE steps of the wheel.
+template <typename Color>
+class SnakeGradient {
+    public:
+        static constexpr size_t SIZE = 256;
+
+        explicit SnakeGradient(Rgb base = Palette::SNAKE) {
+            for (size_t i = 0; i < SIZE; i++) {
+                Rgb rgb = Palette::color_wheel(base, (double) i / (SIZE - 1));
+                colors[i] = Color{rgb.r, rgb.g, rgb.b};
+            }
+        }
+
+        // Colour of piece i of a body of the given length, the head first
+        const Color &operator()(size_t i, size_t length) const {
+            // The head has position 1, like the first colour of the wheel
+            double position = 1.0 - (double) i / length;
+            return colors[std::lround(position * (SIZE - 1))];
+        }
+
+    private:
+        std::array<Color, SIZE> colors;
+};
+
+#endif // PALETTE_HPP
@@ -0,0 +1,116 @@
+// populationWall.hpp
+
+#ifndef POPULATIONWALL_HPP
+#define POPULATIONWALL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "gameSnapshot.hpp"
+#include "tripleBuffer.hpp"
+
+// Live view of many games at once, one tile per genome of a generation.
+// Evaluation threads feed the tiles of the genomes they play, and the
+// window asks for new frames of a few tiles at a time. A game is only
+// copied when its tile was asked for a frame, so feeding a tile costs
+// the evaluation thread one relaxed atomic load per step.
+class PopulationWall {
+    public:
+        // Passed as on_step to play_episode: offers the game to a tile
+        // after each step
+        class Feed {
+            public:
+                Feed(PopulationWall &wall, size_t tile) :
+                    wall(&wall), tile(tile), step(0) {}
+
+                void operator()(const SnakeEngine &engine) {
+                    wall->offer(tile, engine, ++step);
+                }
+
+            private:
+                PopulationWall *wall;
+                size_t tile;
+                uint64_t step;
+        };
+
+        explicit PopulationWall(size_t num_tiles) : tiles(num_tiles), next_request(0) {}
+
+        size_t size() const {
+            return tiles.size();
+        }
+
+        // Evaluation side: the feed of a tile, e.g. of a genome index.
+        // Only one thread at a time may play the games of a tile.
+        Feed feed(size_t tile) {
+            return Feed(*this, tile % tiles.size());
+        }
+
+        // Evaluation side: copy the game into the tile, if the window
+        // asked for a frame of it
+        void offer(size_t tile, const SnakeEngine &engine, uint64_t step) {
+            Tile &t = tiles[tile];
+            if (t.request.load(std::memory_order_relaxed) != WANTED) {
+                return;
+            }
+            uint8_t wanted = WANTED;
+            if (!t.request.compare_exchange_strong(wanted, WRITING,
+                std::memory_order_acquire)) {
+                return;
+            }
+            t.frames.write_buffer().capture(engine, GameState::Running, step);
+            t.frames.publish();
+            t.request.store(IDLE, std::memory_order_release);
+        }
+
+        /**
+         * Window side: ask for new frames of up to budget tiles, taking
+         * turns over all tiles, so a wall larger than the render budget
+         * is refreshed round-robin. Tiles still waiting for their last
+         * frame, e.g. of genomes not being played, are skipped.
+         *
+         * @param budget The number of tiles to ask.
+         * @return The number of tiles asked.
+         */
+        size_t request(size_t budget) {
+            size_t asked = 0;
+            for (size_t i = 0; i < tiles.size() && asked < budget; i++) {
+                Tile &t = tiles[next_request];
+                next_request = (next_request + 1) % tiles.size();
+                uint8_t idle = IDLE;
+                asked += t.request.compare_exchange_strong(idle, WANTED,
+                    std::memory_order_relaxed);
+            }
+            return asked;
+        }
+
+        // Window side: take the latest frame of a tile. Returns false if
+        // there is no new one.
+        bool update(size_t tile) {
+            return tiles[tile].frames.update();
+        }
+
+        // Window side: the frame taken by the last update(). Tiles never
+        // fed have an empty body.
+        const GameSnapshot &snapshot(size_t tile) const {
+            return tiles[tile].frames.read_buffer();
+        }
+
+    private:
+        // Window writes IDLE -> WANTED, evaluation WANTED -> WRITING -> IDLE,
+        // so only one thread at a time writes the frames of a tile
+        static constexpr uint8_t IDLE = 0;
+        static constexpr uint8_t WANTED = 1;
+        static constexpr uint8_t WRITING = 2;
+
+        struct Tile {
+            alignas(64) std::atomic<uint8_t> request{IDLE};
+            TripleBuffer<GameSnapshot> frames;
+        };
+
+        std::vector<Tile> tiles;
+        // Only touched by the window
+        size_t next_request;
+};
+
+#endif // POPULATIONWALL_HPP
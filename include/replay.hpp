@@ -0,0 +1,156 @@
+// replay.hpp
+
+#ifndef REPLAY_HPP
+#define REPLAY_HPP
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "gameSnapshot.hpp"
+#include "snakeEngine.hpp"
+
+// Recordings of games, to watch them again. An action log holds what is
+// needed to play a game again: the options and seed of the engine and
+// the action of every step. A state log holds the snapshots themselves,
+// for games that cannot be played again.
+//
+// Both are text files. An action log is
+//
+//     snake-actions 1
+//     <width> <height> <allow teleport> <seed>
+//     <one character per step: '.' DoNothing, 'L' TurnLeft, 'R' TurnRight>
+//
+// and a state log is
+//
+//     snake-states 1
+//     <width> <height> <number of snapshots>
+//     <step> <score> <state> <food row> <food col> <length> <row> <col> ...
+//
+// with one line per snapshot and the body from the head.
+
+struct ActionLog {
+    int width = 20;
+    int height = 20;
+    bool allow_teleport = false;
+    uint64_t seed = 0;
+    std::vector<Action> actions;
+};
+
+inline void write_action_log(std::ostream &out, const ActionLog &log) {
+    static const char codes[] = {'.', 'L', 'R'};
+    out << "snake-actions 1\n"
+        << log.width << ' ' << log.height << ' ' << log.allow_teleport << ' '
+        << log.seed << '\n';
+    for (size_t i = 0; i < log.actions.size(); i++) {
+        out << codes[static_cast<int>(log.actions[i])];
+        if (i % 80 == 79) {
+            out << '\n';
+        }
+    }
+    out << '\n';
+}
+
+inline void write_states(std::ostream &out, const std::vector<GameSnapshot> &states) {
+    out << "snake-states 1\n";
+    int width = states.empty() ? 0 : states.front().width;
+    int height = states.empty() ? 0 : states.front().height;
+    out << width << ' ' << height << ' ' << states.size() << '\n';
+    for (const GameSnapshot &game : states) {
+        out << game.step << ' ' << game.score << ' ' << static_cast<int>(game.state)
+            << ' ' << game.food.row << ' ' << game.food.col << ' ' << game.body.size();
+        for (const Coordinates &c : game.body) {
+            out << ' ' << c.row << ' ' << c.col;
+        }
+        out << '\n';
+    }
+}
+
+// Read the header of a recording. Returns "snake-actions" or
+// "snake-states"; throws std::runtime_error for anything else.
+inline std::string read_replay_kind(std::istream &in) {
+    std::string kind;
+    int version = 0;
+    if (!(in >> kind >> version) || version != 1
+        || (kind != "snake-actions" && kind != "snake-states")) {
+        throw std::runtime_error("Not a snake recording");
+    }
+    return kind;
+}
+
+// Read an action log, after its header
+inline ActionLog read_action_log(std::istream &in) {
+    ActionLog log;
+    if (!(in >> log.width >> log.height >> log.allow_teleport >> log.seed)) {
+        throw std::runtime_error("Bad action log options");
+    }
+    char code;
+    while (in >> code) {
+        switch (code) {
+            case '.':
+                log.actions.push_back(Action::DoNothing);
+                break;
+            case 'L':
+                log.actions.push_back(Action::TurnLeft);
+                break;
+            case 'R':
+                log.actions.push_back(Action::TurnRight);
+                break;
+            default:
+                throw std::runtime_error(std::string("Bad action in log: ") + code);
+        }
+    }
+    return log;
+}
+
+// Read a state log, after its header
+inline std::vector<GameSnapshot> read_states(std::istream &in) {
+    int width, height;
+    size_t count;
+    if (!(in >> width >> height >> count)) {
+        throw std::runtime_error("Bad state log size");
+    }
+    std::vector<GameSnapshot> states(count);
+    for (GameSnapshot &game : states) {
+        int state;
+        size_t length;
+        game.width = width;
+        game.height = height;
+        if (!(in >> game.step >> game.score >> state >> game.food.row >> game.food.col
+            >> length) || state < 0 || state > static_cast<int>(GameState::Win)) {
+            throw std::runtime_error("Bad state log entry");
+        }
+        game.state = static_cast<GameState>(state);
+        game.body.resize(length);
+        for (Coordinates &c : game.body) {
+            if (!(in >> c.row >> c.col)) {
+                throw std::runtime_error("Bad state log entry");
+            }
+        }
+    }
+    return states;
+}
+
+/**
+ * Play an action log again.
+ *
+ * @param log The action log.
+ * @return The snapshot of the game before the first action and after
+ * every action, until the game ends.
+ */
+inline std::vector<GameSnapshot> replay(const ActionLog &log) {
+    SnakeEngine engine{log.width, log.height, log.allow_teleport, log.seed};
+    std::vector<GameSnapshot> states(1);
+    states.back().capture(engine, GameState::Running, 0);
+    GameState state = GameState::Running;
+    for (size_t i = 0; i < log.actions.size() && state == GameState::Running; i++) {
+        state = engine.process(log.actions[i]);
+        states.emplace_back();
+        states.back().capture(engine, state, i + 1);
+    }
+    return states;
+}
+
+#endif // REPLAY_HPP
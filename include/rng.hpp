@@ -4,12 +4,41 @@
 #define RNG_HPP
 
 #include <random>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
 
 using std::vector;
 
+// xoshiro256++ generator. It is small enough to be copied and passed
+// around freely, and independent streams can be derived from a single
+// master seed, either by stream ids or by jumping ahead.
 class RNG {
     public:
-        RNG(unsigned seed = std::random_device()());
+        using result_type = uint64_t;
+
+        // Everything that determines the draws to come, e.g. to save a
+        // generator in a checkpoint and resume it later
+        struct State {
+            uint64_t s[4];
+            double spare_gaussian;
+            bool has_spare_gaussian;
+        };
+
+        // Seeded from std::random_device, for non-reproducible use
+        RNG();
+        explicit RNG(uint64_t seed);
+        explicit RNG(const State &state);
+
+        State state() const;
+
+        // Independent stream for the given ids, e.g. (generation, genome)
+        static RNG stream(uint64_t seed, uint64_t id, uint64_t sub_id = 0);
+
+        // Advance by 2^128 draws, to split one stream into many
+        void jump();
+
+        uint64_t next();
 
         int next_int(int max, int min = 0);
 
@@ -17,10 +46,14 @@ class RNG {
 
         double gaussian(double mean, double std);
 
+        // Bulk sampling, much cheaper per value than the calls above
+        void fill_uniform(float *out, size_t n, float min = 0.0f, float max = 1.0f);
+        void fill_gaussian(float *out, size_t n, float mean = 0.0f, float std = 1.0f);
+        void fill_bernoulli_mask(uint8_t *out, size_t n, double p);
+
         template <typename T>
         T choose(double p, const T& a, const T& b) {
-            std::bernoulli_distribution dist(p);
-            return dist(gen) ? a : b;
+            return uniform() < p ? a : b;
         }
 
         template <typename T>
@@ -33,9 +66,16 @@ class RNG {
             return vec.begin() + next_int(vec.size() - 1);
         }
 
-    private: 
-        // Mersenne Twister engine
-        std::mt19937 gen;
+        // UniformRandomBitGenerator interface, for <random> and <algorithm>
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return UINT64_MAX; }
+        result_type operator()() { return next(); }
+
+    private:
+        uint64_t s[4];
+        // Second value of the last Box-Muller pair
+        double spare_gaussian;
+        bool has_spare_gaussian;
 };
 
-#endif // RNG_HPP
\ No newline at end of file
+#endif // RNG_HPP
@@ -4,7 +4,9 @@
 #define SNAKEENGINE_HPP
 
 #include <algorithm>
-#include <deque>
+#include <cstddef>
+#include <iterator>
+#include <vector>
 #include "rng.hpp"
 
 // Define the Direction enum class
@@ -40,9 +42,89 @@ struct Coordinates {
     }
 };
 
+// The cells of a snake from the head, in a ring of fixed capacity. A
+// step only moves the ends of the ring and writes the new head in front
+// of the old one, so the cells of an earlier state stay in place for as
+// many steps as the ring has free cells.
+class SnakeBody {
+    public:
+        class const_iterator {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = Coordinates;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const Coordinates *;
+                using reference = const Coordinates &;
+
+                const_iterator(const SnakeBody *body, size_t index) :
+                    body(body), index(index) {}
+
+                reference operator*() const { return (*body)[index]; }
+                pointer operator->() const { return &(*body)[index]; }
+                const_iterator &operator++() {
+                    index++;
+                    return *this;
+                }
+                const_iterator operator++(int) {
+                    const_iterator copy = *this;
+                    index++;
+                    return copy;
+                }
+                bool operator==(const const_iterator &other) const { return index == other.index; }
+                bool operator!=(const const_iterator &other) const { return index != other.index; }
+
+            private:
+                const SnakeBody *body;
+                size_t index;
+        };
+
+        // Room for at least capacity cells, and no cells
+        void reset(size_t capacity) {
+            size_t size = 1;
+            while (size < capacity) {
+                size *= 2;
+            }
+            cells.assign(size, {0, 0});
+            mask = size - 1;
+            first = 0;
+            count = 0;
+        }
+
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        size_t capacity() const { return cells.size(); }
+
+        const Coordinates &operator[](size_t i) const { return cells[(first + i) & mask]; }
+        const Coordinates &front() const { return cells[first]; }
+        const Coordinates &back() const { return (*this)[count - 1]; }
+        const_iterator begin() const { return {this, 0}; }
+        const_iterator end() const { return {this, count}; }
+
+        void push_front(Coordinates c) {
+            first = (first - 1) & mask;
+            cells[first] = c;
+            count++;
+        }
+        void push_back(Coordinates c) {
+            cells[(first + count) & mask] = c;
+            count++;
+        }
+        void pop_back() {
+            count--;
+        }
+
+    private:
+        std::vector<Coordinates> cells;
+        size_t mask = 0;
+        size_t first = 0;
+        size_t count = 0;
+
+        friend class SnakeEngine;
+};
+
 // Define the Snake struct
 struct Snake {
-    std::deque<Coordinates> body;
+    SnakeBody body;
     short grow;
 
     // Returns the head of the snake
@@ -54,18 +136,25 @@ struct Snake {
 // Define the SnakeEngine class
 class SnakeEngine {
     public:
-        // Constructor with default values
-        SnakeEngine(int width = 20, int height = 20, bool allow_teleport = false)
-            : width(width), height(height), allow_teleport(allow_teleport), score(0) {
+        // Constructor with default values. The seed fixes the start
+        // position, direction and food sequence of the episode
+        SnakeEngine(int width = 20, int height = 20, bool allow_teleport = false,
+            uint64_t seed = RNG{}.next())
+            : width(width), height(height), allow_teleport(allow_teleport), score(0),
+              rng(seed) {
+            // Twice the board, so an earlier state can be restored after
+            // as many steps as there are cells, see save_state()
+            snake.body.reset(2 * (size_t) width * height);
+
             // Initialize the snake with 3 segments at
             // a random position in the middle of the board
-            int row = RNG{}.next_int(height - 1);
-            int col = RNG{}.next_int(width - 1);
+            int row = rng.next_int(height - 1);
+            int col = rng.next_int(width - 1);
             snake.body.push_back({row, col});
             snake.grow = 2;
 
             // Random direction for the snake
-            current_direction = static_cast<Direction>(RNG{}.next_int(3));
+            current_direction = static_cast<Direction>(rng.next_int(3));
 
             // Generate the initial food
             generate_food();
@@ -96,6 +185,47 @@ class SnakeEngine {
             return score;
         }
 
+        // Returns the direction the snake is heading in
+        Direction _direction() const {
+            return current_direction;
+        }
+
+        // Returns whether the snake can cross the borders
+        bool _allow_teleport() const {
+            return allow_teleport;
+        }
+
+        // What changes from one step to the next. The cells of the snake
+        // are not copied: they are still in place when the state is
+        // restored, if the engine took at most width * height steps since.
+        struct State {
+            size_t first;
+            size_t length;
+            short grow;
+            Coordinates food;
+            int score;
+            Direction direction;
+            RNG rng;
+        };
+
+        // Save the state of the game, in constant time and without allocating
+        State save_state() const {
+            return {snake.body.first, snake.body.count, snake.grow, food, score,
+                current_direction, rng};
+        }
+
+        // Go back to a state saved by this engine, at most width * height
+        // steps ago. Also valid after a step that ended the game.
+        void restore_state(const State &state) {
+            snake.body.first = state.first;
+            snake.body.count = state.length;
+            snake.grow = state.grow;
+            food = state.food;
+            score = state.score;
+            current_direction = state.direction;
+            rng = state.rng;
+        }
+
         // Process the action and update the game state
         GameState process(Action action) {
             // Update the direction of the snake
@@ -158,6 +288,8 @@ class SnakeEngine {
         int height;
         int score;
         Direction current_direction;
+        // Random stream of the episode
+        RNG rng;
 
         // Update the direction of the snake
         Direction update_direction(Direction current_direction, Action action) {
@@ -205,7 +337,6 @@ class SnakeEngine {
         }
 
         void generate_food() {
-            RNG rng;
             do {
                 food.col = rng.next_int(width - 1);
                 food.row = rng.next_int(height - 1);
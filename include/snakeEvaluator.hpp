@@ -0,0 +1,631 @@
+// snakeEvaluator.hpp
+
+#ifndef SNAKEEVALUATOR_HPP
+#define SNAKEEVALUATOR_HPP
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "snakeEngine.hpp"
+#include "populationWall.hpp"
+#include "NEAT/network.hpp"
+#include "NEAT/params.hpp"
+#include "NEAT/evaluation.hpp"
+#include "NEAT/racing.hpp"
+#include "NEAT/staging.hpp"
+#include "NEAT/cutoff.hpp"
+#include "NEAT/novelty.hpp"
+
+// Networks see the danger ahead, to the left and to the right of the
+// head, and the angle to the food, all relative to the heading. Their
+// outputs are the scores of DoNothing, TurnLeft and TurnRight.
+constexpr int SnakeInputs = 4;
+constexpr int SnakeOutputs = 3;
+
+inline Coordinates step(Coordinates c, Direction direction) {
+    switch (direction) {
+        case Direction::Up:
+            return {c.row - 1, c.col};
+        case Direction::Down:
+            return {c.row + 1, c.col};
+        case Direction::Left:
+            return {c.row, c.col - 1};
+        case Direction::Right:
+        default:
+            return {c.row, c.col + 1};
+    }
+}
+
+inline Direction turn_left(Direction direction) {
+    switch (direction) {
+        case Direction::Up:
+            return Direction::Left;
+        case Direction::Left:
+            return Direction::Down;
+        case Direction::Down:
+            return Direction::Right;
+        case Direction::Right:
+        default:
+            return Direction::Up;
+    }
+}
+
+inline Direction turn_right(Direction direction) {
+    return turn_left(turn_left(turn_left(direction)));
+}
+
+// Whether moving the head one cell in the direction ends the episode
+inline bool is_danger(const SnakeEngine &engine, Direction direction) {
+    Coordinates next = step(engine._snake().head(), direction);
+    if (engine._allow_teleport()) {
+        next.row = (next.row + engine._height()) % engine._height();
+        next.col = (next.col + engine._width()) % engine._width();
+    } else if (next.row < 0 || next.row >= engine._height()
+        || next.col < 0 || next.col >= engine._width()) {
+        return true;
+    }
+    const auto &body = engine._snake().body;
+    return std::find(body.begin(), body.end(), next) != body.end();
+}
+
+/**
+ * Fill the network inputs from the state of a game.
+ *
+ * @param engine The game.
+ * @param inputs Set to the SnakeInputs inputs.
+ */
+inline void observe(const SnakeEngine &engine, float *inputs) {
+    Direction heading = engine._direction();
+    inputs[0] = is_danger(engine, heading);
+    inputs[1] = is_danger(engine, turn_left(heading));
+    inputs[2] = is_danger(engine, turn_right(heading));
+
+    // Food position in the frame of the head: forward and to the right
+    Coordinates head = engine._snake().head();
+    Coordinates ahead = step({0, 0}, heading);
+    Coordinates right = step({0, 0}, turn_right(heading));
+    int d_row = engine._food().row - head.row;
+    int d_col = engine._food().col - head.col;
+    float forward = d_row * ahead.row + d_col * ahead.col;
+    float sideways = d_row * right.row + d_col * right.col;
+    inputs[3] = std::atan2(sideways, forward) / (float) M_PI;
+}
+
+// Action with the highest output
+inline Action choose_action(const float *outputs) {
+    int best = 0;
+    for (int i = 1; i < SnakeOutputs; i++) {
+        if (outputs[i] > outputs[best]) {
+            best = i;
+        }
+    }
+    return static_cast<Action>(best);
+}
+
+// Distance from the head to the food, in steps
+inline int food_distance(const SnakeEngine &engine) {
+    Coordinates head = engine._snake().head();
+    int d_row = std::abs(engine._food().row - head.row);
+    int d_col = std::abs(engine._food().col - head.col);
+    if (engine._allow_teleport()) {
+        d_row = std::min(d_row, engine._height() - d_row);
+        d_col = std::min(d_col, engine._width() - d_col);
+    }
+    return d_row + d_col;
+}
+
+/**
+ * Best fitness an episode in progress can still reach. The snake eats
+ * on every remaining step once it reaches the current food, unless it
+ * starves first, and the episode lasts as long as it is allowed to.
+ *
+ * @param engine The game.
+ * @param steps The steps played.
+ * @param hungry The steps since the snake last ate.
+ * @param params The parameters of the run.
+ * @return An upper bound of the fitness of the episode.
+ */
+inline float episode_upper_bound(const SnakeEngine &engine, int steps, int hungry,
+    const NeatParams &params) {
+    int remaining = params.max_steps - steps;
+    int reachable = std::min(remaining, params.hunger_steps - hungry);
+    int distance = food_distance(engine);
+    int more_food = 0;
+    int last_step = steps + reachable;
+    if (distance <= reachable) {
+        const Snake &snake = engine._snake();
+        int free_cells = engine._width() * engine._height()
+            - (int) snake.body.size() - snake.grow;
+        more_food = std::min(1 + remaining - distance, std::max(free_cells, 1));
+        last_step = params.max_steps;
+    }
+    return engine._score() + more_food + last_step / (params.max_steps + 1.0f);
+}
+
+// Best fitness of an episode not yet started
+inline float max_episode_fitness(const NeatParams &params) {
+    return std::min(params.board_width * params.board_height, params.max_steps)
+        + params.max_steps / (params.max_steps + 1.0f);
+}
+
+// A network playing one step at a time, e.g. for a controller. Choosing
+// an action does not allocate.
+class NetworkPolicy {
+    public:
+        explicit NetworkPolicy(const Genome &genome) : network(genome) {
+            if (genome.num_inputs() != SnakeInputs || genome.num_outputs() != SnakeOutputs) {
+                throw std::invalid_argument("Snake genomes need 4 inputs and 3 outputs");
+            }
+        }
+
+        Action operator()(const SnakeEngine &engine) {
+            return choose_action(scores(engine));
+        }
+
+        // The SnakeOutputs scores of the actions, valid until the next call
+        const float *scores(const SnakeEngine &engine) {
+            observe(engine, inputs);
+            network.activate(inputs, outputs);
+            return outputs;
+        }
+
+    private:
+        FeedForwardNetwork network;
+        float inputs[SnakeInputs];
+        float outputs[SnakeOutputs];
+};
+
+struct EpisodeResult {
+    int score;
+    int steps;
+    bool aborted;
+};
+
+// Default on_step of play_episode, which does nothing
+struct IgnoreStep {
+    void operator()(const SnakeEngine &) const {}
+};
+
+/**
+ * Play one episode. It ends when the game does, after params.max_steps
+ * steps, or after params.hunger_steps steps without food.
+ *
+ * @param network The network playing.
+ * @param params The parameters of the run.
+ * @param seed The seed of the episode.
+ * @param should_abort Called before each step with the upper bound of
+ * the fitness of the episode; the episode stops if it returns true.
+ * @param on_step Called with the game after each step.
+ * @return The score and length of the episode.
+ */
+template <typename ShouldAbort, typename OnStep = IgnoreStep>
+EpisodeResult play_episode(FeedForwardNetwork &network, const NeatParams &params,
+    uint64_t seed, ShouldAbort &&should_abort, OnStep &&on_step = OnStep()) {
+    SnakeEngine engine{params.board_width, params.board_height,
+        params.allow_teleport, seed};
+    float inputs[SnakeInputs], outputs[SnakeOutputs];
+    int steps = 0, hungry = 0;
+    GameState state = GameState::Running;
+    while (state == GameState::Running && steps < params.max_steps
+        && hungry < params.hunger_steps) {
+        if (should_abort(episode_upper_bound(engine, steps, hungry, params))) {
+            return {engine._score(), steps, true};
+        }
+        observe(engine, inputs);
+        network.activate(inputs, outputs);
+        int score = engine._score();
+        state = engine.process(choose_action(outputs));
+        steps++;
+        hungry = engine._score() > score ? 0 : hungry + 1;
+        if (state == GameState::Running) {
+            on_step(engine);
+        }
+    }
+    return {engine._score(), steps, false};
+}
+
+inline EpisodeResult play_episode(FeedForwardNetwork &network,
+    const NeatParams &params, uint64_t seed) {
+    return play_episode(network, params, seed, [](float) { return false; });
+}
+
+// Fitness of an episode: the score, with the survival time as a tie-break
+inline float episode_fitness(const EpisodeResult &result, const NeatParams &params) {
+    return result.score + result.steps / (params.max_steps + 1.0f);
+}
+
+/**
+ * Evaluate a genome on params.episodes_per_genome episodes. The fitness
+ * is the mean fitness of the episodes.
+ *
+ * @param genome The genome.
+ * @param params The parameters of the run.
+ * @param seed The seed of the genome, see SeedSchedule::genome_seed.
+ * @param cutoff If not null, the evaluation stops as soon as the genome
+ * can no longer reach the cutoff.
+ * @param on_step Called with the game after each step of every episode.
+ * @return The fitness and episode statistics. An aborted evaluation
+ * keeps the fitness it measured, below the cutoff.
+ */
+template <typename OnStep = IgnoreStep>
+EvaluationResult evaluate_genome(const Genome &genome, const NeatParams &params,
+    uint64_t seed, const SurvivalCutoff *cutoff = nullptr, OnStep &&on_step = OnStep()) {
+    if (genome.num_inputs() != SnakeInputs || genome.num_outputs() != SnakeOutputs) {
+        throw std::invalid_argument("Snake genomes need 4 inputs and 3 outputs");
+    }
+    FeedForwardNetwork network(genome);
+    const int episodes = params.episodes_per_genome;
+    double score = 0.0, steps = 0.0;
+    float bound = 0.0f;
+    for (int episode = 0; episode < episodes; episode++) {
+        // The played episodes, the best case of this one and of the rest
+        float rest = (episodes - episode - 1) * max_episode_fitness(params);
+        auto should_abort = [&](float episode_bound) {
+            if (cutoff == nullptr) {
+                return false;
+            }
+            float threshold = cutoff->value();
+            bound = (score + steps / (params.max_steps + 1.0) + episode_bound + rest)
+                / episodes;
+            return threshold != FitnessNotCalculated && bound < threshold;
+        };
+        EpisodeResult result = play_episode(network, params,
+            SeedSchedule::episode_seed(seed, episode), should_abort, on_step);
+        score += result.score;
+        steps += result.steps;
+        if (result.aborted) {
+            score /= episodes;
+            steps /= episodes;
+            return {(float) (score + steps / (params.max_steps + 1.0)),
+                (float) score, (float) steps, true, bound};
+        }
+    }
+    score /= episodes;
+    steps /= episodes;
+    float fitness = score + steps / (params.max_steps + 1.0);
+    return {fitness, (float) score, (float) steps, false, fitness};
+}
+
+// Fitness function for Population::run, evaluating in this process on
+// num_threads threads
+class SnakeFitness {
+    public:
+        explicit SnakeFitness(const NeatParams &params, unsigned num_threads = 1) :
+            params(params), seeds(params), num_threads(std::max(1u, num_threads)),
+            _num_aborted(0) {}
+
+        // Stop evaluations that cannot reach the survival cutoff of a
+        // population, see Population::survival_cutoff
+        void abort_below(std::shared_ptr<SurvivalCutoff> cutoff) {
+            this->cutoff = std::move(cutoff);
+        }
+
+        // Show the games of each genome on the tile of its index
+        void watch(std::shared_ptr<PopulationWall> wall) {
+            this->wall = std::move(wall);
+        }
+
+        // Play the episodes of the given generation next, e.g. to resume
+        // a run
+        void seek(uint64_t generation) { seeds.seek(generation); }
+
+        void operator()(vector<Genome>::iterator begin, vector<Genome>::iterator end) {
+            uint64_t seed = seeds.next();
+            const size_t num_genomes = end - begin;
+            _results.assign(num_genomes, EvaluationResult{});
+            std::atomic<size_t> next_genome{0};
+            auto work = [&]() {
+                for (size_t i = next_genome++; i < num_genomes; i = next_genome++) {
+                    evaluate(*(begin + i), SeedSchedule::genome_seed(seed, i, params), i);
+                }
+            };
+
+            vector<std::thread> threads;
+            for (unsigned i = 1; i < std::min<size_t>(num_threads, num_genomes); i++) {
+                threads.emplace_back(work);
+            }
+            work();
+            for (auto &thread : threads) {
+                thread.join();
+            }
+        }
+
+        // Evaluations stopped early so far
+        size_t num_aborted() const { return _num_aborted; }
+
+        // Results of the last evaluation, in the order of its genomes
+        const vector<EvaluationResult> &results() const { return _results; }
+
+    private:
+        NeatParams params;
+        SeedSchedule seeds;
+        unsigned num_threads;
+        std::shared_ptr<SurvivalCutoff> cutoff;
+        std::shared_ptr<PopulationWall> wall;
+        std::atomic<size_t> _num_aborted;
+        vector<EvaluationResult> _results;
+
+        void evaluate(Genome &genome, uint64_t genome_seed, size_t index) {
+            EvaluationResult result = wall
+                ? evaluate_genome(genome, params, genome_seed, cutoff.get(), wall->feed(index))
+                : evaluate_genome(genome, params, genome_seed, cutoff.get());
+            genome.fitness() = result.fitness;
+            _results[index] = result;
+            if (result.aborted) {
+                _num_aborted++;
+            } else if (cutoff) {
+                cutoff->report(result.fitness);
+            }
+        }
+};
+
+// Fitness function for Population::run, evaluating by racing on
+// num_threads threads: genomes that are clearly below the survival
+// cutoff stop playing early
+class SnakeRacingFitness {
+    public:
+        explicit SnakeRacingFitness(const NeatParams &params, unsigned num_threads = 1) :
+            params(params), seeds(params), num_threads(std::max(1u, num_threads)) {}
+
+        // Play the episodes of the given generation next, e.g. to resume
+        // a run
+        void seek(uint64_t generation) { seeds.seek(generation); }
+
+        void operator()(vector<Genome>::iterator begin, vector<Genome>::iterator end) {
+            uint64_t seed = seeds.next();
+            vector<FeedForwardNetwork> networks;
+            networks.reserve(end - begin);
+            for (auto it = begin; it != end; it++) {
+                if (it->num_inputs() != SnakeInputs || it->num_outputs() != SnakeOutputs) {
+                    throw std::invalid_argument("Snake genomes need 4 inputs and 3 outputs");
+                }
+                networks.emplace_back(*it);
+            }
+
+            auto play = [&](size_t genome, int episode) {
+                EpisodeResult result = play_episode(networks[genome], params,
+                    SeedSchedule::episode_seed(
+                        SeedSchedule::genome_seed(seed, genome, params), episode));
+                return episode_fitness(result, params);
+            };
+            vector<float> fitness = race(networks.size(), play, params, &_stats, num_threads);
+            for (size_t i = 0; i < fitness.size(); i++) {
+                (begin + i)->fitness() = fitness[i];
+            }
+        }
+
+        // Statistics of the last evaluation
+        const RacingStats &stats() const { return _stats; }
+
+    private:
+        NeatParams params;
+        SeedSchedule seeds;
+        unsigned num_threads;
+        RacingStats _stats;
+};
+
+// Fitness function for Population::run, evaluating in two stages on
+// num_threads threads: every genome plays short episodes on a small
+// board, and only those above params.screening_percentile play the full
+// episodes
+class SnakeStagedFitness {
+    public:
+        explicit SnakeStagedFitness(const NeatParams &params, unsigned num_threads = 1) :
+            params(params), screening_params(params), seeds(params),
+            num_threads(std::max(1u, num_threads)), _num_aborted(0) {
+            screening_params.board_width = params.screening_board_width;
+            screening_params.board_height = params.screening_board_height;
+            screening_params.max_steps = params.screening_max_steps;
+        }
+
+        // Stop full evaluations that cannot reach the survival cutoff of
+        // a population, see Population::survival_cutoff
+        void abort_below(std::shared_ptr<SurvivalCutoff> cutoff) {
+            this->cutoff = std::move(cutoff);
+        }
+
+        // Show the full games of each genome on the tile of its index
+        void watch(std::shared_ptr<PopulationWall> wall) {
+            this->wall = std::move(wall);
+        }
+
+        // Play the episodes of the given generation next, e.g. to resume
+        // a run
+        void seek(uint64_t generation) { seeds.seek(generation); }
+
+        void operator()(vector<Genome>::iterator begin, vector<Genome>::iterator end) {
+            for (auto it = begin; it != end; it++) {
+                if (it->num_inputs() != SnakeInputs || it->num_outputs() != SnakeOutputs) {
+                    throw std::invalid_argument("Snake genomes need 4 inputs and 3 outputs");
+                }
+            }
+            uint64_t seed = seeds.next();
+            auto genome_seed = [&](size_t genome) {
+                return SeedSchedule::genome_seed(seed, genome, params);
+            };
+            const size_t num_genomes = end - begin;
+            _results.assign(num_genomes, EvaluationResult{});
+            // Set for the genomes that pass screening, one byte each so
+            // that threads can write their own
+            vector<uint8_t> finalist(num_genomes, 0);
+
+            auto screen = [&](size_t genome) {
+                FeedForwardNetwork network(*(begin + genome));
+                StageResult screening{0.0f, 0};
+                for (int episode = 0; episode < params.screening_episodes; episode++) {
+                    EpisodeResult result = play_episode(network, screening_params,
+                        SeedSchedule::episode_seed(genome_seed(genome), episode));
+                    screening.fitness += episode_fitness(result, screening_params);
+                    screening.steps += result.steps;
+                }
+                screening.fitness /= params.screening_episodes;
+                return screening;
+            };
+            auto evaluate = [&](size_t genome) {
+                Genome &evaluated = *(begin + genome);
+                EvaluationResult result = wall
+                    ? evaluate_genome(evaluated, params, genome_seed(genome), cutoff.get(),
+                        wall->feed(genome))
+                    : evaluate_genome(evaluated, params, genome_seed(genome), cutoff.get());
+                _results[genome] = result;
+                finalist[genome] = 1;
+                if (result.aborted) {
+                    _num_aborted++;
+                } else if (cutoff) {
+                    cutoff->report(result.fitness);
+                }
+                return StageResult{result.fitness, (uint64_t) std::llround(
+                    result.mean_steps * params.episodes_per_genome)};
+            };
+            vector<float> fitness = staged(num_genomes, screen, evaluate, params, &_stats,
+                num_threads);
+            for (size_t i = 0; i < num_genomes; i++) {
+                (begin + i)->fitness() = fitness[i];
+                // Screened out genomes did not play the full episodes,
+                // so they count as aborted
+                if (!finalist[i]) {
+                    _results[i] = {fitness[i], 0.0f, 0.0f, true, max_episode_fitness(params)};
+                }
+            }
+        }
+
+        // Statistics of the last evaluation
+        const StagingStats &stats() const { return _stats; }
+
+        // Full evaluations stopped early so far
+        size_t num_aborted() const { return _num_aborted; }
+
+        // Results of the last evaluation, in the order of its genomes
+        const vector<EvaluationResult> &results() const { return _results; }
+
+    private:
+        NeatParams params;
+        NeatParams screening_params;
+        SeedSchedule seeds;
+        unsigned num_threads;
+        std::shared_ptr<SurvivalCutoff> cutoff;
+        std::shared_ptr<PopulationWall> wall;
+        std::atomic<size_t> _num_aborted;
+        StagingStats _stats;
+        vector<EvaluationResult> _results;
+};
+
+// Fitness function for Population::run, rewarding novel behaviour as
+// well as score, so snakes that circle safely without eating do not
+// take over the population. The behaviour of a genome is the share of
+// its steps spent in each cell of a coarse grid over the board. The
+// episodes are played on num_threads threads.
+class SnakeNoveltyFitness {
+    public:
+        explicit SnakeNoveltyFitness(const NeatParams &params, unsigned num_threads = 1) :
+            params(params), seeds(params), num_threads(std::max(1u, num_threads)),
+            archive(params.novelty_grid * params.novelty_grid, params.novelty_k) {}
+
+        // Play the episodes of the given generation next, e.g. to resume
+        // a run
+        void seek(uint64_t generation) { seeds.seek(generation); }
+
+        void operator()(vector<Genome>::iterator begin, vector<Genome>::iterator end) {
+            for (auto it = begin; it != end; it++) {
+                if (it->num_inputs() != SnakeInputs || it->num_outputs() != SnakeOutputs) {
+                    throw std::invalid_argument("Snake genomes need 4 inputs and 3 outputs");
+                }
+            }
+            uint64_t seed = seeds.next();
+            const size_t dim = archive.dim();
+            const size_t num_genomes = end - begin;
+            _results.assign(num_genomes, EvaluationResult{});
+            _behaviours.assign(num_genomes * dim, 0.0f);
+            // Each genome fills in its own result and behaviour
+            std::atomic<size_t> next_genome{0};
+            auto work = [&]() {
+                for (size_t i = next_genome++; i < num_genomes; i = next_genome++) {
+                    _results[i] = play(*(begin + i), SeedSchedule::genome_seed(seed, i, params),
+                        &_behaviours[i * dim]);
+                }
+            };
+            vector<std::thread> threads;
+            for (unsigned i = 1; i < std::min<size_t>(num_threads, num_genomes); i++) {
+                threads.emplace_back(work);
+            }
+            work();
+            for (auto &thread : threads) {
+                thread.join();
+            }
+
+            // The archive is only read and grown on this thread
+            vector<float> novelty = archive.novelty(_behaviours);
+            for (size_t i = 0; i < num_genomes; i++) {
+                EvaluationResult &result = _results[i];
+                result.fitness += params.novelty_weight * novelty[i];
+                result.upper_bound = result.fitness;
+                (begin + i)->fitness() = result.fitness;
+            }
+
+            // The most novel behaviours of the generation join the archive
+            vector<size_t> order(novelty.size());
+            for (size_t i = 0; i < order.size(); i++) {
+                order[i] = i;
+            }
+            size_t num_added = std::min<size_t>(params.novelty_archive_add, order.size());
+            std::partial_sort(order.begin(), order.begin() + num_added, order.end(),
+                [&](size_t a, size_t b) { return novelty[a] > novelty[b]; });
+            for (size_t i = 0; i < num_added; i++) {
+                archive.add(&_behaviours[order[i] * dim]);
+            }
+        }
+
+        // Behaviours of the last generation, archive().dim() floats each
+        const vector<float> &behaviours() const { return _behaviours; }
+        const NoveltyArchive &novelty_archive() const { return archive; }
+
+        // Results of the last evaluation, in the order of its genomes,
+        // novelty included in their fitness
+        const vector<EvaluationResult> &results() const { return _results; }
+
+    private:
+        NeatParams params;
+        SeedSchedule seeds;
+        unsigned num_threads;
+        NoveltyArchive archive;
+        vector<float> _behaviours;
+        vector<EvaluationResult> _results;
+
+        // Play the episodes of a genome, returning the means of its
+        // episodes and filling in its behaviour
+        EvaluationResult play(const Genome &genome, uint64_t seed, float *behaviour) const {
+            FeedForwardNetwork network(genome);
+            const int grid = params.novelty_grid;
+            int visits = 0;
+            auto visit = [&](const SnakeEngine &engine) {
+                Coordinates head = engine._snake().head();
+                int row = head.row * grid / engine._height();
+                int col = head.col * grid / engine._width();
+                behaviour[row * grid + col] += 1.0f;
+                visits++;
+            };
+
+            const int episodes = params.episodes_per_genome;
+            float fitness = 0.0f, score = 0.0f, steps = 0.0f;
+            for (int episode = 0; episode < episodes; episode++) {
+                EpisodeResult result = play_episode(network, params,
+                    SeedSchedule::episode_seed(seed, episode),
+                    [](float) { return false; }, visit);
+                fitness += episode_fitness(result, params);
+                score += result.score;
+                steps += result.steps;
+            }
+            if (visits > 0) {
+                for (int cell = 0; cell < grid * grid; cell++) {
+                    behaviour[cell] /= visits;
+                }
+            }
+            return {fitness / episodes, score / episodes, steps / episodes};
+        }
+};
+
+#endif // SNAKEEVALUATOR_HPP
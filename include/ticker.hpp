@@ -1,38 +1,97 @@
-#include <iostream>
+// ticker.hpp
+
+#ifndef TICKER_HPP
+#define TICKER_HPP
+
+#include <algorithm>
 #include <chrono>
+#include <stdexcept>
+#include <thread>
 
+// Fixed-timestep pacing of the game. The simulation runs target_fps
+// steps per second of real time, times the speed multiplier, and frames
+// are shown at most max_render_fps times per second. Between frames the
+// thread sleeps; when a frame is late, the steps it missed run before
+// it is drawn, so the game keeps its pace.
 class Ticker {
 public:
-    Ticker(double target_fps) {
+    using Clock = std::chrono::steady_clock;
+    using Seconds = std::chrono::duration<double>;
+
+    static constexpr double MIN_SPEED = 1.0;
+    static constexpr double MAX_SPEED = 1000.0;
+    // Steps owed beyond this much time are dropped rather than run in
+    // one burst, e.g. after the window was dragged
+    static constexpr double MAX_BACKLOG = 0.25;
+
+    Ticker(double target_fps, double max_render_fps = 60.0)
+        : speed(MIN_SPEED), accumulator(0.0) {
         setFrameRate(target_fps);
-        last_tick = std::chrono::high_resolution_clock::now();
+        if (max_render_fps <= 0) {
+            throw std::invalid_argument("Render FPS must be greater than 0");
+        }
+        this->max_render_fps = max_render_fps;
+        last_tick = Clock::now();
+        next_frame = last_tick;
     }
 
     void setFrameRate(double target_fps) {
         if (target_fps <= 0) {
             throw std::invalid_argument("FPS must be greater than 0");
         }
-        target_frame_duration = std::chrono::duration<double>(1.0 / target_fps);
+        step_rate = target_fps;
+    }
+
+    // Fast-forward, clamped to [MIN_SPEED, MAX_SPEED]
+    void setSpeed(double multiplier) {
+        speed = std::clamp(multiplier, MIN_SPEED, MAX_SPEED);
     }
 
-    bool tick() {
-        auto now = std::chrono::high_resolution_clock::now();
-        auto elapsed = now - last_tick;
-
-        if (elapsed >= target_frame_duration) {
-            last_tick = now;
-            return true;
-        } else {
-            auto ticks_passed = static_cast<int>(elapsed / target_frame_duration);
-            if (ticks_passed > 0) {
-                last_tick = now;
-                return ticks_passed;
-            }
-            return false;
+    double getSpeed() const {
+        return speed;
+    }
+
+    // Sleep until the next frame is due, and return the number of
+    // simulation steps to run before drawing it
+    int wait() {
+        std::this_thread::sleep_until(next_frame);
+        auto now = Clock::now();
+        int steps = advance(now - last_tick);
+        last_tick = now;
+
+        // Deadlines are kept on a fixed grid, unless a frame was missed
+        next_frame += std::chrono::duration_cast<Clock::duration>(frame_duration());
+        if (next_frame < now) {
+            next_frame = now + std::chrono::duration_cast<Clock::duration>(frame_duration());
         }
+        return steps;
+    }
+
+    // Simulation steps due after some time passed. The fraction of a
+    // step left over is carried to the next call.
+    int advance(Seconds elapsed) {
+        double steps_per_second = step_rate * speed;
+        accumulator += elapsed.count() * steps_per_second;
+        accumulator = std::min(accumulator,
+            std::max(1.0, MAX_BACKLOG * steps_per_second));
+        int steps = static_cast<int>(accumulator);
+        accumulator -= steps;
+        return steps;
+    }
+
+    // Time between frames: one step, or the render rate cap when fast
+    // forwarding runs several steps per frame
+    Seconds frame_duration() const {
+        return Seconds(std::max(1.0 / (step_rate * speed), 1.0 / max_render_fps));
     }
 
 private:
-    std::chrono::time_point<std::chrono::high_resolution_clock> last_tick;
-    std::chrono::duration<double> target_frame_duration;
-};
\ No newline at end of file
+    double step_rate;
+    double max_render_fps;
+    double speed;
+    double accumulator;
+    Clock::time_point last_tick;
+    Clock::time_point next_frame;
+};
+
+#endif // TICKER_HPP
@@ -0,0 +1,60 @@
+// tripleBuffer.hpp
+
+#ifndef TRIPLEBUFFER_HPP
+#define TRIPLEBUFFER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free hand-over of values from one writer thread to one reader
+// thread. The writer fills its own slot and publishes it; the reader
+// takes the latest published slot. Neither ever waits for the other,
+// and a value is never changed while the reader holds it. Values the
+// reader did not take in time are overwritten.
+template <typename T>
+class TripleBuffer {
+    public:
+        TripleBuffer() : back(0), middle(1), front(2) {}
+
+        // Writer side: the slot to fill
+        T &write_buffer() {
+            return slots[back];
+        }
+
+        // Writer side: hand the filled slot over, and get a free one
+        void publish() {
+            uint8_t previous = middle.exchange(back | FRESH, std::memory_order_acq_rel);
+            back = previous & INDEX;
+        }
+
+        // Reader side: take the latest published slot. Returns false,
+        // and keeps the current one, if nothing new was published.
+        bool update() {
+            if (!(middle.load(std::memory_order_relaxed) & FRESH)) {
+                return false;
+            }
+            uint8_t previous = middle.exchange(front, std::memory_order_acq_rel);
+            front = previous & INDEX;
+            return true;
+        }
+
+        // Reader side: the slot taken by the last update()
+        const T &read_buffer() const {
+            return slots[front];
+        }
+
+    private:
+        static constexpr uint8_t INDEX = 3;
+        static constexpr uint8_t FRESH = 4;
+
+        std::array<T, 3> slots;
+        // Only touched by the writer
+        uint8_t back;
+        // Shared, the slot between them, with FRESH if not yet taken
+        alignas(64) std::atomic<uint8_t> middle;
+        // Only touched by the reader
+        alignas(64) uint8_t front;
+};
+
+#endif // TRIPLEBUFFER_HPP
@@ -0,0 +1,73 @@
+// wallRenderer.hpp
+
+#ifndef WALLRENDERER_HPP
+#define WALLRENDERER_HPP
+
+#include <SFML/Graphics.hpp>
+#include <cmath>
+#include "gameRenderer.hpp"
+#include "populationWall.hpp"
+
+// Draws every tile of a PopulationWall in a grid filling the window, in
+// one draw call: the boards, snakes and food of all tiles share a
+// single vertex array. Each frame asks the wall for new frames of at
+// most frames_per_draw tiles; the others keep their last frame.
+class WallRenderer {
+    public:
+        WallRenderer(sf::RenderWindow &window, PopulationWall &wall,
+            size_t frames_per_draw = 64) :
+            window(window), wall(wall), frames_per_draw(frames_per_draw),
+            vertices(sf::Quads) {
+            columns = std::max<size_t>(1, std::ceil(std::sqrt((double) wall.size())));
+            rows = std::max<size_t>(1, (wall.size() + columns - 1) / columns);
+        }
+
+        void draw() {
+            wall.request(frames_per_draw);
+            size_t num_quads = 0;
+            for (size_t tile = 0; tile < wall.size(); tile++) {
+                wall.update(tile);
+                const GameSnapshot &game = wall.snapshot(tile);
+                num_quads += 1 + (game.body.empty() ? 0 : game.body.size() + 1);
+            }
+
+            vertices.resize(4 * num_quads);
+            size_t quad = 0;
+            sf::Vector2f tile_size = {(float) window.getSize().x / columns,
+                (float) window.getSize().y / rows};
+            for (size_t tile = 0; tile < wall.size(); tile++) {
+                // A one pixel stroke around each board
+                sf::Vector2f origin = {(tile % columns) * tile_size.x + 1,
+                    (tile / columns) * tile_size.y + 1};
+                sf::Vector2f board = {tile_size.x - 2, tile_size.y - 2};
+                set_quad(vertices, quad++, origin, board, config.background_color);
+
+                const GameSnapshot &game = wall.snapshot(tile);
+                if (game.body.empty()) {
+                    continue;
+                }
+                sf::Vector2f cell = {board.x / game.width, board.y / game.height};
+                for (size_t i = 0; i < game.body.size(); i++) {
+                    set_quad(vertices, quad++, cell_position(origin, cell, game.body[i]), cell,
+                        gradient(i, game.body.size()));
+                }
+                set_quad(vertices, quad++, cell_position(origin, cell, game.food), cell,
+                    config.food_color);
+            }
+
+            window.clear(config.stroke_color);
+            window.draw(vertices);
+        }
+
+    private:
+        sf::RenderWindow &window;
+        PopulationWall &wall;
+        size_t frames_per_draw;
+        size_t columns;
+        size_t rows;
+        GameRendererConfig config;
+        SnakeGradient<sf::Color> gradient;
+        sf::VertexArray vertices;
+};
+
+#endif // WALLRENDERER_HPP
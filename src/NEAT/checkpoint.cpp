@@ -0,0 +1,521 @@
+// checkpoint.cpp
+
+#include "NEAT/checkpoint.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static constexpr char MAGIC[8] = {'N', 'E', 'A', 'T', 'C', 'K', 'P', 'T'};
+static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+// Bytes buffered before each write to the file
+static constexpr size_t WRITE_BUFFER_SIZE = 1 << 20;
+
+struct HeaderRecord {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    int32_t num_inputs;
+    int32_t num_outputs;
+    int32_t next_genome_id;
+    uint32_t reserved;
+    uint64_t generation;
+    uint64_t num_genomes;
+    uint64_t num_species;
+    uint64_t num_neurons;
+    uint64_t num_links;
+    uint64_t file_size;
+};
+
+struct RngRecord {
+    uint64_t s[4];
+    double spare_gaussian;
+    uint8_t has_spare_gaussian;
+    uint8_t padding[7];
+};
+
+struct GenomeRecord {
+    int32_t genome_id;
+    int32_t num_hidden;
+    int32_t next_neuron_id;
+    float fitness;
+    int32_t parent_id;
+    int32_t mate_id;
+    uint64_t first_neuron;
+    uint64_t first_link;
+    uint32_t num_neurons;
+    uint32_t num_links;
+};
+
+struct NeuronRecord {
+    int32_t neuron_id;
+    float bias;
+    uint8_t activation;
+    uint8_t padding[3];
+};
+
+struct LinkRecord {
+    int32_t input_id;
+    int32_t output_id;
+    float weight;
+    uint8_t enabled;
+    uint8_t padding[3];
+};
+
+static_assert(sizeof(HeaderRecord) == 80 && sizeof(RngRecord) == 48
+    && sizeof(GenomeRecord) == 48 && sizeof(NeuronRecord) == 12
+    && sizeof(LinkRecord) == 16, "Checkpoint records must not be padded");
+
+// Offsets of the sections of a checkpoint, from its counts
+struct Sections {
+    uint64_t rng = sizeof(HeaderRecord);
+    uint64_t table = rng + sizeof(RngRecord);
+    uint64_t neurons;
+    uint64_t links;
+    uint64_t end;
+
+    Sections(uint64_t num_records, uint64_t num_neurons, uint64_t num_links) {
+        neurons = table + num_records * sizeof(GenomeRecord);
+        links = (neurons + num_neurons * sizeof(NeuronRecord) + 7) & ~uint64_t{7};
+        end = links + num_links * sizeof(LinkRecord);
+    }
+};
+
+// Appends records to a file through a buffer
+class RecordWriter {
+    public:
+        RecordWriter(int fd, const string &path) : fd(fd), path(path) {
+            buffer.reserve(WRITE_BUFFER_SIZE);
+        }
+
+        template <typename T>
+        void put(const T &record) {
+            if (buffer.size() + sizeof(T) > WRITE_BUFFER_SIZE) {
+                flush();
+            }
+            const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&record);
+            buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+        }
+
+        void pad_to(uint64_t offset) {
+            while (written + buffer.size() < offset) {
+                buffer.push_back(0);
+            }
+        }
+
+        void flush() {
+            size_t done = 0;
+            while (done < buffer.size()) {
+                ssize_t n = ::write(fd, buffer.data() + done, buffer.size() - done);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n < 0) {
+                    throw std::runtime_error("Could not write checkpoint to " + path
+                        + ": " + strerror(errno));
+                }
+                done += n;
+            }
+            written += buffer.size();
+            buffer.clear();
+        }
+
+    private:
+        int fd;
+        const string &path;
+        vector<uint8_t> buffer;
+        uint64_t written = 0;
+};
+
+/**
+ * Write the checkpoint of a population.
+ *
+ * @param path The file, replaced atomically.
+ * @param state The state of the population.
+ */
+void write_checkpoint(const string &path, const PopulationState &state) {
+    // The best genome is always there, and carries the config
+    const GenomeConfig &genome_config = *state.best.genome_config();
+    vector<const Genome *> genomes;
+    for (const auto &genome : state.genomes) {
+        genomes.push_back(&genome);
+    }
+    for (const auto &genome : state.species) {
+        genomes.push_back(&genome);
+    }
+    genomes.push_back(&state.best);
+
+    HeaderRecord header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = CheckpointVersion;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.num_inputs = genome_config.num_inputs;
+    header.num_outputs = genome_config.num_outputs;
+    header.next_genome_id = state.next_genome_id;
+    header.generation = state.generation;
+    header.num_genomes = state.genomes.size();
+    header.num_species = state.species.size();
+    for (const Genome *genome : genomes) {
+        header.num_neurons += genome->neurons().size();
+        header.num_links += genome->links().size();
+    }
+    Sections sections(genomes.size(), header.num_neurons, header.num_links);
+    header.file_size = sections.end;
+
+    string temporary = path + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Could not create " + temporary + ": " + strerror(errno));
+    }
+    try {
+        RecordWriter writer(fd, temporary);
+        writer.put(header);
+
+        RngRecord rng{};
+        std::copy(state.rng.s, state.rng.s + 4, rng.s);
+        rng.spare_gaussian = state.rng.spare_gaussian;
+        rng.has_spare_gaussian = state.rng.has_spare_gaussian;
+        writer.put(rng);
+
+        uint64_t first_neuron = 0, first_link = 0;
+        for (const Genome *genome : genomes) {
+            GenomeRecord record{};
+            record.genome_id = genome->genome_id;
+            record.num_hidden = genome->num_hidden();
+            record.next_neuron_id = genome->next_neuron_id();
+            record.fitness = genome->fitness();
+            record.parent_id = genome->parent_id;
+            record.mate_id = genome->mate_id;
+            record.first_neuron = first_neuron;
+            record.first_link = first_link;
+            record.num_neurons = genome->neurons().size();
+            record.num_links = genome->links().size();
+            writer.put(record);
+            first_neuron += record.num_neurons;
+            first_link += record.num_links;
+        }
+
+        for (const Genome *genome : genomes) {
+            for (const auto &neuron : genome->neurons()) {
+                NeuronRecord record{};
+                record.neuron_id = neuron.neuron_id;
+                record.bias = neuron.bias;
+                record.activation = (uint8_t) neuron.activation;
+                writer.put(record);
+            }
+        }
+        writer.pad_to(sections.links);
+
+        for (const Genome *genome : genomes) {
+            const auto &links = genome->links();
+            for (size_t i = 0; i < links.size(); i++) {
+                LinkRecord record{};
+                record.input_id = links[i].link_id.input_id;
+                record.output_id = links[i].link_id.output_id;
+                record.weight = links[i].weight;
+                record.enabled = genome->is_enabled(i);
+                writer.put(record);
+            }
+        }
+        writer.flush();
+
+        if (::fsync(fd) != 0) {
+            throw std::runtime_error("Could not flush " + temporary + ": " + strerror(errno));
+        }
+    } catch (...) {
+        ::close(fd);
+        ::unlink(temporary.c_str());
+        throw;
+    }
+    ::close(fd);
+
+    if (::rename(temporary.c_str(), path.c_str()) != 0) {
+        string error = strerror(errno);
+        ::unlink(temporary.c_str());
+        throw std::runtime_error("Could not replace " + path + ": " + error);
+    }
+    // Make the rename itself durable
+    size_t slash = path.rfind('/');
+    string directory = slash == string::npos ? "." : path.substr(0, slash + 1);
+    int directory_fd = ::open(directory.c_str(), O_RDONLY);
+    if (directory_fd >= 0) {
+        ::fsync(directory_fd);
+        ::close(directory_fd);
+    }
+}
+
+CheckpointWriter::CheckpointWriter(const string &path) : path(path) {
+    thread = std::thread([this]() { run(); });
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    thread.join();
+}
+
+/**
+ * Queue a checkpoint, replacing the one still waiting, if any.
+ *
+ * @param state The state to write, see Population::state().
+ */
+void CheckpointWriter::save(PopulationState state) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        rethrow_error();
+        waiting = std::move(state);
+    }
+    changed.notify_all();
+}
+
+/**
+ * Wait for the queued checkpoints to be written.
+ */
+void CheckpointWriter::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this]() { return !waiting && !writing; });
+    rethrow_error();
+}
+
+size_t CheckpointWriter::num_written() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return _num_written;
+}
+
+void CheckpointWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        changed.wait(lock, [this]() { return stopping || waiting; });
+        if (!waiting) {
+            return;
+        }
+        PopulationState state = std::move(*waiting);
+        waiting.reset();
+        writing = true;
+        lock.unlock();
+
+        std::exception_ptr failure;
+        try {
+            write_checkpoint(path, state);
+        } catch (...) {
+            failure = std::current_exception();
+        }
+
+        lock.lock();
+        writing = false;
+        if (failure) {
+            error = failure;
+        } else {
+            _num_written++;
+        }
+        changed.notify_all();
+    }
+}
+
+// Called under the lock. The error is only reported once.
+void CheckpointWriter::rethrow_error() {
+    if (error) {
+        std::exception_ptr failure = error;
+        error = nullptr;
+        std::rethrow_exception(failure);
+    }
+}
+
+template <typename T>
+static T record_at(const uint8_t *data, uint64_t offset) {
+    T record;
+    std::memcpy(&record, data + offset, sizeof(T));
+    return record;
+}
+
+Checkpoint::Checkpoint(const string &path) : data(nullptr), size(0) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open " + path + ": " + strerror(errno));
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        string error = strerror(errno);
+        ::close(fd);
+        throw std::runtime_error("Could not read " + path + ": " + error);
+    }
+    size = info.st_size;
+    if (size < sizeof(HeaderRecord)) {
+        ::close(fd);
+        throw std::invalid_argument(path + " is not a checkpoint");
+    }
+    void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Could not map " + path + ": " + strerror(errno));
+    }
+    data = static_cast<const uint8_t *>(mapping);
+
+    HeaderRecord header = record_at<HeaderRecord>(data, 0);
+    string problem;
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        problem = " is not a checkpoint";
+    } else if (header.version != CheckpointVersion) {
+        problem = " has an unsupported checkpoint version";
+    } else if (header.byte_order != BYTE_ORDER_MARK) {
+        problem = " was written on a machine of another byte order";
+    } else if (header.file_size != size
+        || header.num_genomes > size / sizeof(GenomeRecord)
+        || header.num_species > size / sizeof(GenomeRecord)
+        || header.num_neurons > size / sizeof(NeuronRecord)
+        || header.num_links > size / sizeof(LinkRecord)
+        || Sections(header.num_genomes + header.num_species + 1,
+            header.num_neurons, header.num_links).end != size) {
+        problem = " is truncated";
+    }
+    if (!problem.empty()) {
+        ::munmap(const_cast<uint8_t *>(data), size);
+        throw std::invalid_argument(path + problem);
+    }
+}
+
+Checkpoint::~Checkpoint() {
+    ::munmap(const_cast<uint8_t *>(data), size);
+}
+
+uint64_t Checkpoint::generation() const {
+    return record_at<HeaderRecord>(data, 0).generation;
+}
+
+size_t Checkpoint::num_genomes() const {
+    return record_at<HeaderRecord>(data, 0).num_genomes;
+}
+
+size_t Checkpoint::num_species() const {
+    return record_at<HeaderRecord>(data, 0).num_species;
+}
+
+Genome Checkpoint::genome(size_t index, const shared_ptr<const GenomeConfig> &genome_config) const {
+    if (index >= num_genomes()) {
+        throw std::out_of_range("No genome " + std::to_string(index) + " in the checkpoint");
+    }
+    return decode(index, genome_config);
+}
+
+Genome Checkpoint::species(size_t index, const shared_ptr<const GenomeConfig> &genome_config) const {
+    if (index >= num_species()) {
+        throw std::out_of_range("No species " + std::to_string(index) + " in the checkpoint");
+    }
+    return decode(num_genomes() + index, genome_config);
+}
+
+Genome Checkpoint::best(const shared_ptr<const GenomeConfig> &genome_config) const {
+    return decode(num_genomes() + num_species(), genome_config);
+}
+
+/**
+ * Decode the state of the population.
+ *
+ * @param genome_config The shared config of the decoded genomes.
+ * @param num_threads The number of decoding threads. DEFAULT one per core.
+ * @return The state.
+ */
+PopulationState Checkpoint::load(const shared_ptr<const GenomeConfig> &genome_config,
+    unsigned num_threads) const {
+    HeaderRecord header = record_at<HeaderRecord>(data, 0);
+    RngRecord rng = record_at<RngRecord>(data, Sections(0, 0, 0).rng);
+    RNG::State rng_state;
+    std::copy(rng.s, rng.s + 4, rng_state.s);
+    rng_state.spare_gaussian = rng.spare_gaussian;
+    rng_state.has_spare_gaussian = rng.has_spare_gaussian;
+
+    PopulationState state{header.generation, rng_state, header.next_genome_id,
+        {}, {}, best(genome_config)};
+    state.genomes.assign(header.num_genomes, Genome(-1, genome_config));
+
+    // Each thread decodes every num_threads-th genome; the first error
+    // is rethrown once they are all done
+    num_threads = std::max(1u, std::min<unsigned>(num_threads,
+        (header.num_genomes + 1023) / 1024));
+    vector<std::exception_ptr> errors(num_threads);
+    auto decode_some = [&](unsigned first) {
+        try {
+            for (size_t i = first; i < header.num_genomes; i += num_threads) {
+                state.genomes[i] = decode(i, genome_config);
+            }
+        } catch (...) {
+            errors[first] = std::current_exception();
+        }
+    };
+    vector<std::thread> threads;
+    for (unsigned i = 1; i < num_threads; i++) {
+        threads.emplace_back(decode_some, i);
+    }
+    decode_some(0);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (const auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    for (size_t i = 0; i < header.num_species; i++) {
+        state.species.push_back(species(i, genome_config));
+    }
+    return state;
+}
+
+/**
+ * Decode one genome of the table.
+ *
+ * @param record The index of the genome in the table.
+ * @param genome_config The shared config of the decoded genome.
+ * @return The genome.
+ */
+Genome Checkpoint::decode(size_t record, const shared_ptr<const GenomeConfig> &genome_config) const {
+    HeaderRecord header = record_at<HeaderRecord>(data, 0);
+    if (header.num_inputs != genome_config->num_inputs
+        || header.num_outputs != genome_config->num_outputs) {
+        throw std::invalid_argument("The checkpoint has other inputs or outputs than the config");
+    }
+    Sections sections(header.num_genomes + header.num_species + 1,
+        header.num_neurons, header.num_links);
+    GenomeRecord entry = record_at<GenomeRecord>(data,
+        sections.table + record * sizeof(GenomeRecord));
+    if (entry.first_neuron > header.num_neurons
+        || entry.num_neurons > header.num_neurons - entry.first_neuron
+        || entry.first_link > header.num_links
+        || entry.num_links > header.num_links - entry.first_link) {
+        throw std::invalid_argument("Genome genes out of the checkpoint");
+    }
+
+    Genome genome(entry.genome_id, genome_config);
+    genome.num_hidden() = entry.num_hidden;
+    for (uint64_t i = entry.first_neuron; i < entry.first_neuron + entry.num_neurons; i++) {
+        NeuronRecord neuron = record_at<NeuronRecord>(data,
+            sections.neurons + i * sizeof(NeuronRecord));
+        if (neuron.activation > (uint8_t) Activation::SOFTMAX) {
+            throw std::invalid_argument("Invalid activation in checkpoint");
+        }
+        if (!fits_neuron_id(neuron.neuron_id)) {
+            throw std::invalid_argument("Neuron id out of range in checkpoint");
+        }
+        genome.add_neuron({neuron.neuron_id, neuron.bias, (Activation) neuron.activation});
+    }
+    for (uint64_t i = entry.first_link; i < entry.first_link + entry.num_links; i++) {
+        LinkRecord link = record_at<LinkRecord>(data, sections.links + i * sizeof(LinkRecord));
+        if (!fits_neuron_id(link.input_id) || !fits_neuron_id(link.output_id)) {
+            throw std::invalid_argument("Neuron id out of range in checkpoint");
+        }
+        genome.add_link({{link.input_id, link.output_id}, link.weight}, link.enabled != 0);
+    }
+    // After the neurons, which move it past their ids
+    genome.next_neuron_id() = entry.next_neuron_id;
+    genome.fitness() = entry.fitness;
+    genome.parent_id = entry.parent_id;
+    genome.mate_id = entry.mate_id;
+    return genome;
+}
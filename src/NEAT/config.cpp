@@ -3,10 +3,10 @@
 #include "NEAT/config.hpp"
 
 Config::Config(const string &filename) : filename(filename) {
-    // load();
-    _population_size = getInt("NEAT", "population_size", 150);
-    _max_generations = getInt("NEAT", "max_generations", 100);
-    _survival_threshold = getDouble("NEAT", "survival_threshold", 0.2);
+    // Running on the defaults instead would train the wrong genomes
+    if (!load()) {
+        throw std::runtime_error("Could not read the config " + filename);
+    }
 }
 
 /**
@@ -104,6 +104,15 @@ string Config::getString(const string &section, const string &key, const string
     return default_value;
 }
 
+/**
+ * Get every setting of the configuration, by section and key.
+ * 
+ * @return The settings.
+ */
+const Config::Settings &Config::getSettings() const {
+    return settings;
+}
+
 /**
  * Set a value in the configuration.
  * 
@@ -0,0 +1,45 @@
+// cutoff.cpp
+
+#include "NEAT/cutoff.hpp"
+#include "NEAT/genome.hpp"
+#include <algorithm>
+#include <functional>
+
+SurvivalCutoff::SurvivalCutoff() : cutoff(FitnessNotCalculated), num_survivors(1) {}
+
+void SurvivalCutoff::reset(size_t num_survivors) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->num_survivors = std::max<size_t>(num_survivors, 1);
+    best.clear();
+    cutoff.store(FitnessNotCalculated, std::memory_order_relaxed);
+}
+
+/**
+ * Report the fitness of a genome. Safe to call from several threads.
+ *
+ * @param fitness The fitness of a genome whose evaluation ran to the end.
+ */
+void SurvivalCutoff::report(float fitness) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (best.size() < num_survivors) {
+        best.push_back(fitness);
+        std::push_heap(best.begin(), best.end(), std::greater<float>());
+    } else if (fitness > best.front()) {
+        std::pop_heap(best.begin(), best.end(), std::greater<float>());
+        best.back() = fitness;
+        std::push_heap(best.begin(), best.end(), std::greater<float>());
+    } else {
+        return;
+    }
+    if (best.size() == num_survivors) {
+        cutoff.store(best.front(), std::memory_order_relaxed);
+    }
+}
+
+void SurvivalCutoff::publish(float cutoff) {
+    this->cutoff.store(cutoff, std::memory_order_relaxed);
+}
+
+float SurvivalCutoff::value() const {
+    return cutoff.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,481 @@
+// distributed.cpp
+
+#include "NEAT/distributed.hpp"
+#include "NEAT/serialize.hpp"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+// Frames are a length, counting the type and the payload, a type and
+// a payload. The master sends the settings once per worker, then
+// batches, and shuts the worker down when it is destroyed.
+enum FrameType : uint8_t {
+    SETTINGS_FRAME = 1,
+    BATCH_FRAME,
+    RESULTS_FRAME,
+    SHUTDOWN_FRAME
+};
+
+static constexpr size_t LENGTH_SIZE = sizeof(uint32_t);
+// Larger frames can only come from a corrupt stream
+static constexpr uint32_t MAX_FRAME = 256u << 20;
+// A worker started before its master keeps trying for this long
+static constexpr int CONNECT_ATTEMPTS = 100;
+static constexpr auto CONNECT_RETRY_DELAY = std::chrono::milliseconds(100);
+
+static void begin_frame(vector<uint8_t> &frame, FrameType type) {
+    frame.clear();
+    put_value<uint32_t>(frame, 0);
+    put_value<uint8_t>(frame, type);
+}
+
+static void end_frame(vector<uint8_t> &frame) {
+    uint32_t length = frame.size() - LENGTH_SIZE;
+    std::memcpy(frame.data(), &length, LENGTH_SIZE);
+}
+
+static bool send_all(int socket, const vector<uint8_t> &data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(socket, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+static bool recv_all(int socket, uint8_t *data, size_t size) {
+    size_t received = 0;
+    while (received < size) {
+        ssize_t n = recv(socket, data + received, size - received, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        received += n;
+    }
+    return true;
+}
+
+static void set_no_delay(int socket) {
+    int one = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+/**
+ * Encode the parameters a worker needs: the genome shape and the
+ * evaluation settings.
+ *
+ * @param params The parameters of the run.
+ * @param frame Set to the settings frame.
+ */
+static void encode_settings(const NeatParams &params, vector<uint8_t> &frame) {
+    begin_frame(frame, SETTINGS_FRAME);
+    for (int value : {params.num_inputs, params.num_outputs,
+        params.board_width, params.board_height, (int) params.allow_teleport,
+        params.episodes_per_genome, params.max_steps, params.hunger_steps,
+        (int) params.common_seeds}) {
+        put_value<int32_t>(frame, value);
+    }
+    end_frame(frame);
+}
+
+static NeatParams decode_settings(ByteReader &reader) {
+    NeatParams params;
+    params.num_inputs = reader.get<int32_t>();
+    params.num_outputs = reader.get<int32_t>();
+    params.board_width = reader.get<int32_t>();
+    params.board_height = reader.get<int32_t>();
+    params.allow_teleport = reader.get<int32_t>() != 0;
+    params.episodes_per_genome = reader.get<int32_t>();
+    params.max_steps = reader.get<int32_t>();
+    params.hunger_steps = reader.get<int32_t>();
+    params.common_seeds = reader.get<int32_t>() != 0;
+    return params;
+}
+
+// A batch carries the seed of the generation and the index of its first
+// genome, from which workers derive the seed of each genome
+static void encode_batch(vector<uint8_t> &frame, uint64_t batch_id, uint64_t seed,
+    size_t first_genome, vector<Genome>::const_iterator begin,
+    vector<Genome>::const_iterator end) {
+    begin_frame(frame, BATCH_FRAME);
+    put_value<uint64_t>(frame, batch_id);
+    put_value<uint64_t>(frame, seed);
+    put_value<uint32_t>(frame, first_genome);
+    put_value<uint32_t>(frame, end - begin);
+    for (auto it = begin; it != end; it++) {
+        encode_genome(*it, frame);
+    }
+    end_frame(frame);
+}
+
+DistributedEvaluator::DistributedEvaluator(const NeatParams &params) :
+    params(params), seeds(params), next_batch_id(0) {
+    listen_socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_socket < 0) {
+        throw std::runtime_error(string("Could not create socket: ") + strerror(errno));
+    }
+    int one = 1;
+    setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(params.master_port);
+    socklen_t length = sizeof(address);
+    if (bind(listen_socket, (sockaddr *) &address, length) < 0
+        || listen(listen_socket, SOMAXCONN) < 0
+        || getsockname(listen_socket, (sockaddr *) &address, &length) < 0) {
+        string error = strerror(errno);
+        close(listen_socket);
+        throw std::runtime_error("Could not listen on port "
+            + std::to_string(params.master_port) + ": " + error);
+    }
+    _port = ntohs(address.sin_port);
+}
+
+DistributedEvaluator::~DistributedEvaluator() {
+    vector<uint8_t> frame;
+    begin_frame(frame, SHUTDOWN_FRAME);
+    end_frame(frame);
+    for (auto &worker : workers) {
+        send_all(worker.socket, frame);
+        close(worker.socket);
+    }
+    close(listen_socket);
+}
+
+int DistributedEvaluator::port() const {
+    return _port;
+}
+
+size_t DistributedEvaluator::num_workers() const {
+    return workers.size();
+}
+
+const vector<EvaluationResult> &DistributedEvaluator::results() const {
+    return _results;
+}
+
+/**
+ * Evaluate genomes on the connected workers, with the seeds of the same
+ * SeedSchedule as SnakeFitness.
+ *
+ * @param begin The first genome.
+ * @param end The end of the genomes.
+ */
+void DistributedEvaluator::operator()(vector<Genome>::iterator begin,
+    vector<Genome>::iterator end) {
+    const size_t num_genomes = end - begin;
+    const uint64_t seed = seeds.next();
+    _results.assign(num_genomes, {FitnessNotCalculated, 0.0f, 0.0f});
+
+    // Batch ids are unique across calls, so late answers cannot be
+    // mistaken for answers of this call
+    vector<Batch> batches;
+    std::deque<size_t> pending;
+    for (size_t i = 0; i < num_genomes; i += params.batch_size) {
+        pending.push_back(batches.size());
+        batches.push_back({i, std::min(num_genomes, i + params.batch_size), false});
+    }
+    const uint64_t first_batch_id = next_batch_id;
+    next_batch_id += batches.size();
+
+    size_t remaining = batches.size();
+    vector<uint8_t> frame;
+    bool reported_waiting = false;
+    while (remaining > 0) {
+        // Keep the pipeline of every worker full
+        for (size_t w = workers.size(); w-- > 0;) {
+            Worker &worker = workers[w];
+            bool sent = true;
+            while (sent && !pending.empty()
+                && worker.in_flight.size() < (size_t) params.pipeline_depth) {
+                size_t b = pending.front();
+                encode_batch(frame, first_batch_id + b, seed, batches[b].begin,
+                    begin + batches[b].begin, begin + batches[b].end);
+                sent = send_all(worker.socket, frame);
+                if (sent) {
+                    pending.pop_front();
+                    worker.in_flight.push_back(b);
+                }
+            }
+            if (!sent) {
+                drop_worker(w, pending);
+            }
+        }
+
+        if (workers.empty() && !reported_waiting) {
+            std::cerr << "Waiting for workers on port " << _port << std::endl;
+            reported_waiting = true;
+        }
+
+        // Wait for results or for a new worker
+        vector<pollfd> fds;
+        fds.push_back({listen_socket, POLLIN, 0});
+        for (const auto &worker : workers) {
+            fds.push_back({worker.socket, POLLIN, 0});
+        }
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(string("Could not poll workers: ") + strerror(errno));
+        }
+        // In reverse, so dropping a worker keeps the others' indices
+        for (size_t w = workers.size(); w-- > 0;) {
+            if (fds[w + 1].revents
+                && !receive(workers[w], begin, batches, first_batch_id, remaining)) {
+                drop_worker(w, pending);
+            }
+        }
+        if (fds[0].revents & POLLIN) {
+            accept_worker();
+        }
+    }
+}
+
+/**
+ * Accept a worker and send it the settings.
+ */
+void DistributedEvaluator::accept_worker() {
+    int socket = accept(listen_socket, nullptr, nullptr);
+    if (socket < 0) {
+        return;
+    }
+    set_no_delay(socket);
+    vector<uint8_t> frame;
+    encode_settings(params, frame);
+    if (!send_all(socket, frame)) {
+        close(socket);
+        return;
+    }
+    workers.push_back({socket, {}, {}});
+}
+
+/**
+ * Disconnect a worker, and put its unanswered batches back in front of
+ * the pending ones.
+ *
+ * @param index The index of the worker.
+ * @param pending The batches waiting for a worker.
+ */
+void DistributedEvaluator::drop_worker(size_t index, std::deque<size_t> &pending) {
+    Worker &worker = workers[index];
+    std::cerr << "Lost a worker, resending its " << worker.in_flight.size()
+        << " batches" << std::endl;
+    for (auto it = worker.in_flight.rbegin(); it != worker.in_flight.rend(); it++) {
+        pending.push_front(*it);
+    }
+    close(worker.socket);
+    workers.erase(workers.begin() + index);
+}
+
+/**
+ * Read what a worker sent, and record the results of every complete
+ * frame.
+ *
+ * @param worker The worker.
+ * @param begin The first genome of the evaluation.
+ * @param batches The batches of the evaluation.
+ * @param first_batch_id The id of the first batch.
+ * @param remaining The number of batches without results, updated.
+ * @return false if the worker disconnected or broke the protocol.
+ */
+bool DistributedEvaluator::receive(Worker &worker, vector<Genome>::iterator begin,
+    vector<Batch> &batches, uint64_t first_batch_id, size_t &remaining) {
+    uint8_t buffer[64 * 1024];
+    ssize_t n = recv(worker.socket, buffer, sizeof(buffer), 0);
+    if (n < 0 && errno == EINTR) {
+        return true;
+    }
+    if (n <= 0) {
+        return false;
+    }
+    worker.input.insert(worker.input.end(), buffer, buffer + n);
+
+    size_t at = 0;
+    vector<EvaluationResult> results;
+    try {
+        while (worker.input.size() - at >= LENGTH_SIZE) {
+            uint32_t length;
+            std::memcpy(&length, worker.input.data() + at, LENGTH_SIZE);
+            if (length == 0 || length > MAX_FRAME) {
+                return false;
+            }
+            if (worker.input.size() - at - LENGTH_SIZE < length) {
+                break;
+            }
+            ByteReader reader(worker.input.data() + at + LENGTH_SIZE, length);
+            at += LENGTH_SIZE + length;
+
+            if (reader.get<uint8_t>() != RESULTS_FRAME) {
+                return false;
+            }
+            uint64_t batch_id = reader.get<uint64_t>();
+            uint32_t count = reader.get<uint32_t>();
+            size_t b = batch_id - first_batch_id;
+            auto in_flight = std::find(worker.in_flight.begin(), worker.in_flight.end(), b);
+            if (batch_id < first_batch_id || in_flight == worker.in_flight.end()
+                || count != batches[b].end - batches[b].begin) {
+                return false;
+            }
+
+            // Read the whole frame before recording any of it
+            results.clear();
+            for (uint32_t i = 0; i < count; i++) {
+                EvaluationResult result;
+                result.fitness = reader.get<float>();
+                result.mean_score = reader.get<float>();
+                result.mean_steps = reader.get<float>();
+                results.push_back(result);
+            }
+            worker.in_flight.erase(in_flight);
+            for (uint32_t i = 0; i < count; i++) {
+                size_t genome = batches[b].begin + i;
+                _results[genome] = results[i];
+                (begin + genome)->fitness() = results[i].fitness;
+            }
+            batches[b].done = true;
+            remaining--;
+        }
+    } catch (const std::invalid_argument &) {
+        return false;
+    }
+    worker.input.erase(worker.input.begin(), worker.input.begin() + at);
+    return true;
+}
+
+/**
+ * Connect to a master, retrying while it is not listening yet.
+ *
+ * @param host The host name or address of the master.
+ * @param port The port of the master.
+ * @return The connected socket, or -1.
+ */
+static int connect_to(const string &host, int port) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    for (int attempt = 0; attempt < CONNECT_ATTEMPTS; attempt++) {
+        addrinfo *addresses;
+        if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) == 0) {
+            for (addrinfo *a = addresses; a != nullptr; a = a->ai_next) {
+                int s = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+                if (s < 0) {
+                    continue;
+                }
+                if (connect(s, a->ai_addr, a->ai_addrlen) == 0) {
+                    freeaddrinfo(addresses);
+                    set_no_delay(s);
+                    return s;
+                }
+                close(s);
+            }
+            freeaddrinfo(addresses);
+        }
+        std::this_thread::sleep_for(CONNECT_RETRY_DELAY);
+    }
+    return -1;
+}
+
+/**
+ * Run a worker: evaluate every batch the master sends, in order.
+ *
+ * @param host The host name or address of the master.
+ * @param port The port of the master.
+ * @param evaluate Evaluates one genome.
+ * @return 0 once the master shuts the worker down, 1 on errors.
+ */
+int run_worker(const string &host, int port, const WorkerEvaluate &evaluate) {
+    int socket = connect_to(host, port);
+    if (socket < 0) {
+        std::cerr << "Could not connect to " << host << ":" << port << std::endl;
+        return 1;
+    }
+
+    NeatParams params;
+    shared_ptr<const GenomeConfig> genome_config;
+    vector<uint8_t> payload, frame;
+    while (true) {
+        uint32_t length;
+        if (!recv_all(socket, (uint8_t *) &length, LENGTH_SIZE)
+            || length == 0 || length > MAX_FRAME) {
+            break;
+        }
+        payload.resize(length);
+        if (!recv_all(socket, payload.data(), length)) {
+            break;
+        }
+
+        ByteReader reader(payload.data(), length);
+        try {
+            uint8_t type = reader.get<uint8_t>();
+            if (type == SHUTDOWN_FRAME) {
+                close(socket);
+                return 0;
+            }
+            if (type == SETTINGS_FRAME) {
+                params = decode_settings(reader);
+                genome_config = std::make_shared<const GenomeConfig>(params);
+                continue;
+            }
+            if (type != BATCH_FRAME || !genome_config) {
+                throw std::invalid_argument("Unexpected frame");
+            }
+
+            uint64_t batch_id = reader.get<uint64_t>();
+            uint64_t seed = reader.get<uint64_t>();
+            uint32_t first_genome = reader.get<uint32_t>();
+            uint32_t count = reader.get<uint32_t>();
+            begin_frame(frame, RESULTS_FRAME);
+            put_value<uint64_t>(frame, batch_id);
+            put_value<uint32_t>(frame, count);
+            Genome genome(-1, genome_config);
+            for (uint32_t i = 0; i < count; i++) {
+                reader.skip(decode_genome(reader.current(), reader.remaining(),
+                    genome_config, genome));
+                // Errors of the evaluation itself are not the master's
+                EvaluationResult result;
+                try {
+                    result = evaluate(genome, params,
+                        SeedSchedule::genome_seed(seed, first_genome + i, params));
+                } catch (const std::exception &e) {
+                    std::cerr << "Could not evaluate genome " << first_genome + i
+                        << ": " << e.what() << std::endl;
+                    close(socket);
+                    return 1;
+                }
+                put_value<float>(frame, result.fitness);
+                put_value<float>(frame, result.mean_score);
+                put_value<float>(frame, result.mean_steps);
+            }
+            end_frame(frame);
+            if (!send_all(socket, frame)) {
+                break;
+            }
+        } catch (const std::invalid_argument &e) {
+            std::cerr << "Bad frame from master: " << e.what() << std::endl;
+            break;
+        }
+    }
+    close(socket);
+    return 1;
+}
@@ -0,0 +1,91 @@
+// evaluation.cpp
+
+#include "NEAT/evaluation.hpp"
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <stdexcept>
+
+// Id of the stream of generation seeds. The population draws from
+// params.seed itself and islands from the streams of their index, so
+// episodes do not follow the draws of selection and mutation.
+static constexpr uint64_t SEED_STREAM = 0x5eed5eed;
+
+SeedSchedule::SeedSchedule(const NeatParams &params) :
+    seed(params.seed), rotate(params.rotate_seeds), generation(0) {}
+
+uint64_t SeedSchedule::next() {
+    uint64_t number = generation++;
+    return RNG::stream(seed, SEED_STREAM, rotate ? number : 0).next();
+}
+
+void SeedSchedule::seek(uint64_t generation) {
+    this->generation = generation;
+}
+
+/**
+ * Seed of the episodes of a genome. With common seeds it is the seed of
+ * the generation, otherwise each genome gets its own.
+ *
+ * @param generation_seed The seed of the generation.
+ * @param genome The index of the genome in its generation.
+ * @param params The parameters of the run.
+ * @return The seed to derive the episodes of the genome from.
+ */
+uint64_t SeedSchedule::genome_seed(uint64_t generation_seed, size_t genome,
+    const NeatParams &params) {
+    if (params.common_seeds) {
+        return generation_seed;
+    }
+    return RNG::stream(generation_seed, genome, 1).next();
+}
+
+uint64_t SeedSchedule::episode_seed(uint64_t genome_seed, int episode) {
+    return RNG::stream(genome_seed, episode).next();
+}
+
+// Ranks from 0, ties get the mean of their ranks
+static vector<double> ranks(const vector<float> &values) {
+    vector<size_t> order(values.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+        [&](size_t a, size_t b) { return values[a] < values[b]; });
+
+    vector<double> result(values.size());
+    for (size_t i = 0; i < order.size();) {
+        size_t j = i;
+        while (j < order.size() && values[order[j]] == values[order[i]]) {
+            j++;
+        }
+        for (size_t k = i; k < j; k++) {
+            result[order[k]] = (i + j - 1) / 2.0;
+        }
+        i = j;
+    }
+    return result;
+}
+
+/**
+ * Spearman rank correlation: the Pearson correlation of the ranks.
+ *
+ * @param a The fitness of the genomes in one evaluation.
+ * @param b The fitness of the same genomes in another.
+ * @return The correlation, 1 for the same ranking, 0 if either is constant.
+ */
+double rank_correlation(const vector<float> &a, const vector<float> &b) {
+    if (a.size() != b.size()) {
+        throw std::invalid_argument("Rank correlation of different sizes");
+    }
+    vector<double> ra = ranks(a), rb = ranks(b);
+    double mean = (a.size() - 1) / 2.0;
+    double covariance = 0.0, variance_a = 0.0, variance_b = 0.0;
+    for (size_t i = 0; i < a.size(); i++) {
+        covariance += (ra[i] - mean) * (rb[i] - mean);
+        variance_a += (ra[i] - mean) * (ra[i] - mean);
+        variance_b += (rb[i] - mean) * (rb[i] - mean);
+    }
+    if (variance_a == 0.0 || variance_b == 0.0) {
+        return 0.0;
+    }
+    return covariance / std::sqrt(variance_a * variance_b);
+}
@@ -1,135 +1,176 @@
 // neuron_gene.cpp
 
 #include "NEAT/genes.hpp"
+#include "NEAT/params.hpp"
 #include "rng.hpp"
 #include <cassert>
+#include <cmath>
+#include <algorithm>
 
 
-NeuronMutator::NeuronMutator(Config &config) : index(0) {
-    std::string section = "DefaultGenome";
-    activation = (Activation) config.getInt(
-        section,
-        "activation",
-        (int) Activation::SIGMOID);
-    mean = config.getDouble(
-        section,
-        "bias_init_mean",
-        0.0);
-    std = config.getDouble(
-        section,
-        "bias_init_stddev",
-        1.0);
-    min = config.getDouble(
-        section,
-        "bias_min",
-        -30.0);
-    max = config.getDouble(
-        section,
-        "bias_max",
-        30.0);
-    mutation_rate = config.getDouble(
-        section,
-        "mutation_rate",
-        0.3);
-    mutation_power = config.getDouble(
-        section,
-        "mutation_power",
-        0.8);
-    replace_rate = config.getDouble(
-        section,
-        "replace_rate",
-        0.05);
+NeuronMutator::NeuronMutator(const NeatParams &params) :
+    activation(params.activation),
+    mean(params.bias_init_mean), std(params.bias_init_stddev),
+    min(params.bias_min_value), max(params.bias_max_value),
+    mutation_rate(params.mutation_rate), mutation_power(params.mutation_power),
+    replace_rate(params.replace_rate) {}
+
+NeuronGene NeuronMutator::new_neuron(int neuron_id, RNG &rng) const {
+    return new_neuron(neuron_id, (float) rng.gaussian(0.0, 1.0));
 }
 
-NeuronGene NeuronMutator::new_neuron() {
+/**
+ * Create a neuron from a pre-drawn sample.
+ * 
+ * @param neuron_id The id of the new neuron.
+ * @param normal A standard normal sample.
+ * @return The new neuron gene.
+ */
+NeuronGene NeuronMutator::new_neuron(int neuron_id, float normal) const {
     // Random bias in Gaussian distribution
-    double bias = clamp(new_value(mean, std), min, max);
-
-    return {index++, bias, activation};
-}
+    float bias = clamp(mean + std * normal, min, max);
 
-int NeuronMutator::next() {
-    return index++;
+    return {neuron_id, bias, activation};
 }
 
-void NeuronMutator::mutate(NeuronGene &neuron, int num_outputs) {
-    RNG rng;
-    double p = rng.uniform();
+/**
+ * Mutate a neuron from pre-drawn samples.
+ * 
+ * @param neuron The neuron to mutate.
+ * @param num_outputs The number of output neurons.
+ * @param uniforms MutationUniforms uniform samples in [0, 1).
+ * @param normal A standard normal sample.
+ */
+void NeuronMutator::mutate(NeuronGene &neuron, int num_outputs,
+    const float *uniforms, float normal) const {
+    double p = uniforms[0];
     
     // Mutate the bias value
     if (p < replace_rate) {
-        neuron.bias = clamp(new_value(mean, std), min, max);
+        neuron.bias = clamp(mean + std * normal, min, max);
     } else if (p < mutation_rate + replace_rate) {
-        double delta = clamp(rng.gaussian(0.0, mutation_power), min, max);
+        double delta = clamp(mutation_power * normal, min, max);
         neuron.bias = clamp(neuron.bias + delta, min, max);
     }
 
     // Mutate the neuron's activation function,
     // but only if it's not an input or output neuron
-    if (rng.uniform() < mutation_rate && neuron.neuron_id >= num_outputs) {
-        neuron.activation = (Activation) rng.next_int(3);
+    if (uniforms[1] < mutation_rate && neuron.neuron_id >= num_outputs) {
+        neuron.activation = (Activation) std::min(3, (int) (uniforms[2] * 4));
     }
 }
 
-LinkMutator::LinkMutator(Config &config) : index(0) {
-    std::string section = "DefaultGenome";
-    mean = config.getDouble(
-        section,
-        "weight_init_mean",
-        0.0);
-    std = config.getDouble(
-        section,
-        "weight_init_stddev",
-        1.0);
-    min = config.getDouble(
-        section,
-        "weight_min",
-        -30.0);
-    max = config.getDouble(
-        section,
-        "weight_max",
-        30.0);
-    mutation_rate = config.getDouble(
-        section,
-        "mutation_rate",
-        0.3);
-    mutation_power = config.getDouble(
-        section,
-        "mutation_power",
-        0.8);
-    replace_rate = config.getDouble(
-        section,
-        "replace_rate",
-        0.05);
+LinkMutator::LinkMutator(const NeatParams &params) :
+    mean(params.weight_init_mean), std(params.weight_init_stddev),
+    min(params.weight_min_value), max(params.weight_max_value),
+    mutation_rate(params.mutation_rate), mutation_power(params.mutation_power),
+    replace_rate(params.replace_rate) {}
+
+LinkGene LinkMutator::new_link(int input_id, int output_id, RNG &rng) const {
+    return new_link(input_id, output_id, (float) rng.gaussian(0.0, 1.0));
 }
 
-LinkGene LinkMutator::new_link(int input_id, int output_id) {
+/**
+ * Create a link from a pre-drawn sample.
+ * 
+ * @param input_id The id of the input neuron.
+ * @param output_id The id of the output neuron.
+ * @param normal A standard normal sample.
+ * @return The new link gene.
+ */
+LinkGene LinkMutator::new_link(int input_id, int output_id, float normal) const {
     // Random weight in Gaussian distribution
-    double weight = clamp(new_value(mean, std), min, max);
+    float weight = clamp(mean + std * normal, min, max);
 
-    return {{input_id, output_id}, weight, true};
+    return {{input_id, output_id}, weight};
 }
 
-void LinkMutator::mutate(LinkGene &link) {
-    RNG rng;
-    double p = rng.uniform();
+/**
+ * Mutate a link from pre-drawn samples.
+ * 
+ * @param link The link to mutate.
+ * @param is_enabled The enabled flag of the link, mutated in place.
+ * @param uniforms MutationUniforms uniform samples in [0, 1).
+ * @param normal A standard normal sample.
+ */
+void LinkMutator::mutate(LinkGene &link, bool &is_enabled,
+    const float *uniforms, float normal) const {
+    double p = uniforms[0];
     
     // Mutate the weight value
     if (p < replace_rate) {
-        link.weight = clamp(new_value(mean, std), min, max);
+        link.weight = clamp(mean + std * normal, min, max);
     } else if (p < mutation_rate + replace_rate) {
-        double delta = clamp(rng.gaussian(0.0, mutation_power), min, max);
+        double delta = clamp(mutation_power * normal, min, max);
         link.weight = clamp(link.weight + delta, min, max);
     }
 
     // Mutate the link's enabled status
-    if (rng.uniform() < mutation_rate) {
-        link.is_enabled = rng.uniform() < 0.5;
+    if (uniforms[1] < mutation_rate) {
+        is_enabled = uniforms[2] < 0.5;
     }
 }
 
-double new_value(double mean, double std) {
-    return RNG{}.gaussian(mean, std);
+/**
+ * Mix a 64-bit value (splitmix64 finaliser).
+ * 
+ * @param x The value to mix.
+ * @return The mixed value.
+ */
+static uint64_t mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+static uint64_t quantise(float value) {
+    return (uint64_t) std::llround(value / HashResolution);
+}
+
+/**
+ * Hash the structure of a neuron gene: its id and activation.
+ * 
+ * @param neuron The neuron gene.
+ * @return The 64-bit hash.
+ */
+uint64_t structure_hash(const NeuronGene &neuron) {
+    return mix(mix((uint32_t) neuron.neuron_id) ^ (uint64_t) neuron.activation);
+}
+
+/**
+ * Hash a neuron gene, including its quantised bias.
+ * 
+ * @param neuron The neuron gene.
+ * @return The 64-bit hash.
+ */
+uint64_t full_hash(const NeuronGene &neuron) {
+    return mix(structure_hash(neuron) ^ quantise(neuron.bias));
+}
+
+/**
+ * Hash the structure of a link gene: its endpoints and enabled flag.
+ * 
+ * @param link The link gene.
+ * @param is_enabled Whether the link is enabled.
+ * @return The 64-bit hash.
+ */
+uint64_t structure_hash(const LinkGene &link, bool is_enabled) {
+    uint64_t id = ((uint64_t) (uint32_t) link.link_id.input_id << 32)
+        | (uint32_t) link.link_id.output_id;
+    // Salted so that links never collide with neurons
+    return mix(mix(id ^ 0x6c696e6b00000000ull) + is_enabled);
+}
+
+/**
+ * Hash a link gene, including its quantised weight.
+ * 
+ * @param link The link gene.
+ * @param is_enabled Whether the link is enabled.
+ * @return The 64-bit hash.
+ */
+uint64_t full_hash(const LinkGene &link, bool is_enabled) {
+    return mix(structure_hash(link, is_enabled) ^ quantise(link.weight));
 }
 
 double clamp(double value, double min, double max) {
@@ -141,15 +182,15 @@ double clamp(double value, double min, double max) {
  * 
  * @param n1 The first neuron gene.
  * @param n2 The second neuron gene.
+ * @param rng The random stream of the offspring.
  * @return The offspring neuron gene.
  */
-NeuronGene crossover_neuron(const NeuronGene &n1, const NeuronGene &n2) {
+NeuronGene crossover_neuron(const NeuronGene &n1, const NeuronGene &n2, RNG &rng) {
     assert(n1.neuron_id == n2.neuron_id);
     
     // Randomly choose bias from either parent
-    RNG rng;
     int neuron_id = n1.neuron_id;
-    double bias = rng.choose<double>(0.5, n1.bias, n2.bias);
+    float bias = rng.choose<float>(0.5, n1.bias, n2.bias);
     Activation activation = rng.choose<Activation>(0.5, n1.activation, n2.activation);
 
     return {neuron_id, bias, activation};
@@ -160,16 +201,15 @@ NeuronGene crossover_neuron(const NeuronGene &n1, const NeuronGene &n2) {
  * 
  * @param l1 The first link gene.
  * @param l2 The second link gene.
+ * @param rng The random stream of the offspring.
  * @return The offspring link gene.
  */
-LinkGene crossover_link(const LinkGene &l1, const LinkGene &l2) {
+LinkGene crossover_link(const LinkGene &l1, const LinkGene &l2, RNG &rng) {
     assert(l1.link_id == l2.link_id);
 
     // Randomly choose weight from either parent
-    RNG rng;
     LinkId link_id = l1.link_id;
-    double weight = rng.choose<double>(0.5, l1.weight, l2.weight);
-    bool is_enabled = rng.choose<bool>(0.5, l1.is_enabled, l2.is_enabled);
+    float weight = rng.choose<float>(0.5, l1.weight, l2.weight);
 
-    return {link_id, weight, is_enabled};
+    return {link_id, weight};
 }
\ No newline at end of file
@@ -4,71 +4,114 @@
 #include "rng.hpp"
 #include <algorithm>
 
-Genome::Genome(int genome_id, Config &config) : genome_id(genome_id), 
-    neuron_mutator(config), link_mutator(config) {
-    _num_inputs = config.getInt(
-        "DefaultGenome", 
-        "num_inputs", 
-        1);
-    _num_outputs = config.getInt(
-        "DefaultGenome", 
-        "num_outputs", 
-        3);
-    _num_hidden = config.getInt(
-        "DefaultGenome", 
-        "num_hidden", 
-        0);
-    _neurons = {};
-    _links = {};
+enum SampleBuffer { UNIFORM_SAMPLES, NORMAL_SAMPLES };
+
+/**
+ * Per-thread sample buffers, reused by every genome built or mutated
+ * on the thread, so drawing samples in bulk does not allocate.
+ * 
+ * @param which The buffer to get.
+ * @param size The number of samples needed.
+ * @return The start of the buffer, holding at least size samples.
+ */
+static float *sample_buffer(SampleBuffer which, size_t size) {
+    thread_local vector<float> buffers[2];
+    auto &buffer = buffers[which];
+    if (buffer.size() < size) {
+        buffer.resize(size);
+    }
+    return buffer.data();
+}
+
+GenomeConfig::GenomeConfig(const NeatParams &params) :
+    num_inputs(params.num_inputs), num_outputs(params.num_outputs),
+    num_hidden(params.num_hidden),
+    neuron_mutator(params), link_mutator(params),
+    neuron_add_prob(params.neuron_add_prob),
+    neuron_delete_prob(params.neuron_delete_prob),
+    link_add_prob(params.link_add_prob),
+    link_delete_prob(params.link_delete_prob) {}
+
+Genome::Genome(int genome_id, const NeatParams &params) :
+    Genome(genome_id, std::make_shared<const GenomeConfig>(params)) {}
+
+Genome::Genome(int genome_id, shared_ptr<const GenomeConfig> genome_config) :
+    genome_id(genome_id), parent_id(-1), mate_id(-1), _genome_config(std::move(genome_config)) {
+    _num_hidden = _genome_config->num_hidden;
+    _next_neuron_id = 0;
     _fitness = FitnessNotCalculated;
+    _structure_hash = 0;
+    _full_hash = 0;
 }
 
-void Genome::config_new(Config &config) {
+/**
+ * Fill a new genome with the initial genes.
+ * 
+ * @param rng The random stream of the genome.
+ */
+void Genome::config_new(RNG &rng) {
+    const auto &neuron_mutator = _genome_config->neuron_mutator;
+    const auto &link_mutator = _genome_config->link_mutator;
+    int num_inputs = this->num_inputs();
+    int num_outputs = this->num_outputs();
+
+    // Reserve the chunk tables, they rarely grow afterwards
+    int num_links = (num_inputs + _num_hidden) * num_outputs
+        + _num_hidden * num_inputs;
+    _neurons.reserve(num_inputs + num_outputs + _num_hidden);
+    _links.reserve(num_links);
+    _enabled.reserve(num_links);
+
+    // Draw every initial bias and weight at once
+    size_t num_samples = num_outputs + _num_hidden + num_links;
+    float *normals = sample_buffer(NORMAL_SAMPLES, num_samples);
+    rng.fill_gaussian(normals, num_samples);
+
     // Add inputs
-    for (int i = 0; i < _num_inputs; i++) {
+    for (int i = 0; i < num_inputs; i++) {
         // Inputs have negative neuron_id, no bias, and linear activation
-        _neurons.push_back({-i - 1, 0.0, Activation::LINEAR});
+        add_neuron({-i - 1, 0.0, Activation::LINEAR});
     }
 
     // Add outputs
-    for (int i = 0; i < _num_outputs; i++) {
+    for (int i = 0; i < num_outputs; i++) {
         // Outputs have neuron_id 0 to num_outputs - 1
-        NeuronGene neuron = neuron_mutator.new_neuron();
+        NeuronGene neuron = neuron_mutator.new_neuron(_next_neuron_id, *normals++);
         neuron.activation = Activation::SOFTMAX;
-        _neurons.push_back(neuron);
+        add_neuron(neuron);
     }
 
     // Add hiddens if any
     for (int i = 0; i < _num_hidden; i++) {
-        _neurons.push_back(neuron_mutator.new_neuron());
+        add_neuron(neuron_mutator.new_neuron(_next_neuron_id, *normals++));
     }
 
     // Add links
     // Initially, all inputs are connected to all outputs,
     // and enabled with random weights
-    for (int i = 0; i < _num_inputs; i++) {
-        for (int j = 0; j < _num_outputs; j++) {
+    for (int i = 0; i < num_inputs; i++) {
+        for (int j = 0; j < num_outputs; j++) {
             int input_id = -i - 1;
             int output_id = j;
-            _links.push_back(link_mutator.new_link(input_id, output_id));
+            add_link(link_mutator.new_link(input_id, output_id, *normals++));
         }
     }
 
     // Add links from hidden to output
     for (int i = 0; i < _num_hidden; i++) {
-        for (int j = 0; j < _num_outputs; j++) {
-            int input_id = _num_outputs + i;
+        for (int j = 0; j < num_outputs; j++) {
+            int input_id = num_outputs + i;
             int output_id = j;
-            _links.push_back(link_mutator.new_link(input_id, output_id));
+            add_link(link_mutator.new_link(input_id, output_id, *normals++));
         }
     }
 
     // Add links from input to hidden
     for (int i = 0; i < _num_hidden; ++i) {
-        for (int j = 0; j < _num_inputs; ++j) {
+        for (int j = 0; j < num_inputs; ++j) {
             int input_id = -j - 1;
-            int output_id = _num_outputs + i;
-            _links.push_back(link_mutator.new_link(input_id, output_id));
+            int output_id = num_outputs + i;
+            add_link(link_mutator.new_link(input_id, output_id, *normals++));
         }
     }
 }
@@ -80,17 +123,21 @@ void Genome::config_new(Config &config) {
  */
 
 int Genome::num_inputs() const {
-    return _num_inputs;
+    return _genome_config->num_inputs;
 }
 
 int Genome::num_outputs() const {
-    return _num_outputs;
+    return _genome_config->num_outputs;
 }
 
 int& Genome::num_hidden() {
     return _num_hidden;
 }
 
+int Genome::num_hidden() const {
+    return _num_hidden;
+}
+
 float& Genome::fitness() {
     return _fitness;
 }
@@ -99,30 +146,111 @@ float Genome::fitness() const {
     return _fitness;
 }
 
-vector<NeuronGene>& Genome::neurons() {
-    return _neurons;
+int& Genome::next_neuron_id() {
+    return _next_neuron_id;
+}
+
+int Genome::next_neuron_id() const {
+    return _next_neuron_id;
 }
 
-const vector<NeuronGene>& Genome::neurons() const {
+const NeuronGenes& Genome::neurons() const {
     return _neurons;
 }
 
-vector<LinkGene>& Genome::links() {
+const LinkGenes& Genome::links() const {
     return _links;
 }
 
-const vector<LinkGene>& Genome::links() const {
-    return _links;
+const shared_ptr<const GenomeConfig>& Genome::genome_config() const {
+    return _genome_config;
+}
+
+/**
+ * Enabled flag of a link.
+ * 
+ * @param link_index The index of the link in links().
+ * @return True if the link is enabled.
+ */
+bool Genome::is_enabled(size_t link_index) const {
+    return _enabled.test(link_index);
+}
+
+void Genome::set_enabled(size_t link_index, bool is_enabled) {
+    const auto &link = _links[link_index];
+    if (link.is_removed() || _enabled.test(link_index) == is_enabled) {
+        return;
+    }
+    update_hashes(link, !is_enabled, false);
+    _enabled.set(link_index, is_enabled);
+    update_hashes(link, is_enabled, true);
+}
+
+uint64_t Genome::structure_hash() const {
+    return _structure_hash;
+}
+
+uint64_t Genome::full_hash() const {
+    return _full_hash;
+}
+
+/**
+ * Recompute both hashes from scratch.
+ * 
+ */
+void Genome::rehash() {
+    _structure_hash = 0;
+    _full_hash = 0;
+    for (const auto &neuron : _neurons) {
+        if (!neuron.is_removed()) {
+            update_hashes(neuron, true);
+        }
+    }
+    for (size_t i = 0; i < _links.size(); i++) {
+        if (!_links[i].is_removed()) {
+            update_hashes(_links[i], _enabled.test(i), true);
+        }
+    }
+}
+
+/**
+ * Add or subtract the hashes of a gene from the genome hashes.
+ * 
+ * @param neuron The neuron gene.
+ * @param add True to add the gene, false to subtract it.
+ */
+void Genome::update_hashes(const NeuronGene &neuron, bool add) {
+    if (add) {
+        _structure_hash += ::structure_hash(neuron);
+        _full_hash += ::full_hash(neuron);
+    } else {
+        _structure_hash -= ::structure_hash(neuron);
+        _full_hash -= ::full_hash(neuron);
+    }
+}
+
+void Genome::update_hashes(const LinkGene &link, bool is_enabled, bool add) {
+    if (add) {
+        _structure_hash += ::structure_hash(link, is_enabled);
+        _full_hash += ::full_hash(link, is_enabled);
+    } else {
+        _structure_hash -= ::structure_hash(link, is_enabled);
+        _full_hash -= ::full_hash(link, is_enabled);
+    }
 }
 
 /**
- * Add a neuron to the genome.
+ * Add a neuron to the genome. Removed neurons are kept as tombstones,
+ * outside of the hashes, e.g. to restore a genome exactly.
  * 
  * @param neuron The neuron to add.
  */
 void Genome::add_neuron(const NeuronGene &neuron) {
-    neurons().push_back(neuron);
-    neuron_mutator.next();
+    _neurons.push_back(neuron);
+    if (!neuron.is_removed()) {
+        update_hashes(neuron, true);
+    }
+    _next_neuron_id = std::max(_next_neuron_id, neuron.neuron_id + 1);
 }
 
 /**
@@ -141,12 +269,41 @@ optional<NeuronGene> Genome::find_neuron(int neuron_id) const {
 }
 
 /**
- * Add a link to the genome.
+ * Replace a neuron of the genome. Its chunk is unshared if needed.
+ * 
+ * @param neuron_index The index of the neuron in neurons().
+ * @param neuron The new value of the neuron.
+ */
+void Genome::set_neuron(size_t neuron_index, const NeuronGene &neuron) {
+    update_hashes(_neurons[neuron_index], false);
+    _neurons.mut(neuron_index) = neuron;
+    update_hashes(neuron, true);
+}
+
+/**
+ * Remove a neuron from the genome, leaving a tombstone in its place.
+ * 
+ * @param neuron_index The index of the neuron in neurons().
+ */
+void Genome::remove_neuron(size_t neuron_index) {
+    update_hashes(_neurons[neuron_index], false);
+    _neurons.mut(neuron_index).neuron_id = TombstoneId;
+}
+
+/**
+ * Add a link to the genome. Removed links are kept as disabled
+ * tombstones, outside of the hashes.
  * 
  * @param link The link to add.
+ * @param is_enabled Whether the link starts enabled. DEFAULT true.
  */
-void Genome::add_link(const LinkGene &link) {
-    links().push_back(link);
+void Genome::add_link(const LinkGene &link, bool is_enabled) {
+    is_enabled &= !link.is_removed();
+    _links.push_back(link);
+    _enabled.assign(_links.size() - 1, is_enabled);
+    if (!link.is_removed()) {
+        update_hashes(link, is_enabled, true);
+    }
 }
 
 /**
@@ -156,148 +313,236 @@ void Genome::add_link(const LinkGene &link) {
  * @return The link if found, nullopt otherwise.
  */
 optional<LinkGene> Genome::find_link(const LinkId &link_id) const {
-    for (const auto &link : links()) {
-        if (link.link_id == link_id) {
-            return link;
+    auto link_index = find_link_index(link_id);
+    if (link_index) {
+        return _links[*link_index];
+    }
+    return std::nullopt;
+}
+
+/**
+ * Find the index of a link in the genome.
+ * 
+ * @param link_id The id of the link to find.
+ * @return The index in links() if found, nullopt otherwise.
+ */
+optional<size_t> Genome::find_link_index(const LinkId &link_id) const {
+    for (size_t i = 0; i < _links.size(); i++) {
+        if (_links[i].link_id == link_id) {
+            return i;
         }
     }
     return std::nullopt;
 }
 
+/**
+ * Replace a link of the genome. Its chunk is unshared if needed.
+ * 
+ * @param link_index The index of the link in links().
+ * @param link The new value of the link.
+ */
+void Genome::set_link(size_t link_index, const LinkGene &link) {
+    bool is_enabled = _enabled.test(link_index);
+    update_hashes(_links[link_index], is_enabled, false);
+    _links.mut(link_index) = link;
+    update_hashes(link, is_enabled, true);
+}
+
+/**
+ * Remove a link from the genome, leaving a tombstone in its place.
+ * 
+ * @param link_index The index of the link in links().
+ */
+void Genome::remove_link(size_t link_index) {
+    update_hashes(_links[link_index], _enabled.test(link_index), false);
+    _links.mut(link_index).link_id = {TombstoneId, TombstoneId};
+    _enabled.set(link_index, false);
+}
+
+/**
+ * Rebuild the gene storage without tombstones.
+ * This unshares every chunk, so it is only worth it once
+ * tombstones make up a good part of the genome.
+ * 
+ */
+void Genome::compact() {
+    NeuronGenes neurons;
+    for (const auto &neuron : _neurons) {
+        if (!neuron.is_removed()) {
+            neurons.push_back(neuron);
+        }
+    }
+    _neurons = std::move(neurons);
+
+    LinkGenes links;
+    BitSet enabled;
+    for (size_t i = 0; i < _links.size(); i++) {
+        if (!_links[i].is_removed()) {
+            enabled.assign(links.size(), _enabled.test(i));
+            links.push_back(_links[i]);
+        }
+    }
+    _links = std::move(links);
+    _enabled = std::move(enabled);
+}
+
 /**
  * Mutate the genome.
  * 
- * @param config The configuration.
+ * @param rng The random stream of the genome.
  */
-void Genome::mutate(Config &config) {
-    // Get structural mutation rates from config
-    double neuron_add_prob = config.getDouble(
-        "DefaultGenome", 
-        "neuron_add_prob", 
-        0.03);
-    double neuron_del_prob = config.getDouble(
-        "DefaultGenome", 
-        "neuron_del_prob", 
-        0.01);
-    double link_add_prob = config.getDouble(
-        "DefaultGenome", 
-        "link_add_prob", 
-        0.05);
-    double link_del_prob = config.getDouble(
-        "DefaultGenome", 
-        "link_del_prob", 
-        0.01);
-    
+void Genome::mutate(RNG &rng) {
+    const GenomeConfig &genome_config = *_genome_config;
+
     // Get random probability
-    double p = RNG{}.uniform();
+    double p = rng.uniform();
 
     // Structural mutations
-    if (p < neuron_add_prob) {
+    if (p < genome_config.neuron_add_prob) {
         // Add a neuron
-        mutate_add_neuron();
+        mutate_add_neuron(rng);
     }
 
-    if (p < neuron_del_prob) {
+    if (p < genome_config.neuron_delete_prob) {
         // Remove a neuron
-        mutate_remove_neuron();
+        mutate_remove_neuron(rng);
     }
 
-    if (p < link_add_prob) {
+    if (p < genome_config.link_add_prob) {
         // Add a link
-        mutate_add_link();
+        mutate_add_link(rng);
     }
 
-    if (p < link_del_prob) {
+    if (p < genome_config.link_delete_prob) {
         // Remove a link
-        mutate_remove_link();
+        mutate_remove_link(rng);
     }
 
+    // Draw the samples of every gene mutation at once
+    size_t num_genes = _links.size() + _neurons.size();
+    float *uniforms = sample_buffer(UNIFORM_SAMPLES, MutationUniforms * num_genes);
+    float *normals = sample_buffer(NORMAL_SAMPLES, num_genes);
+    rng.fill_uniform(uniforms, MutationUniforms * num_genes);
+    rng.fill_gaussian(normals, num_genes);
+
     // Mutate link genes
-    for (auto &link : links()) {
-        link_mutator.mutate(link);
+    const auto &link_mutator = genome_config.link_mutator;
+    // Genes are mutated on a copy and only written back if they changed,
+    // so untouched chunks stay shared with the parent
+    for (size_t i = 0; i < _links.size(); i++) {
+        if (_links[i].is_removed()) {
+            continue;
+        }
+        LinkGene link = _links[i];
+        bool is_enabled = _enabled.test(i);
+        link_mutator.mutate(link, is_enabled,
+            uniforms + MutationUniforms * i, normals[i]);
+        if (link.weight != _links[i].weight) {
+            set_link(i, link);
+        }
+        set_enabled(i, is_enabled);
     }
 
-    // Mutate neuron genes
-    for (auto &neuron : neurons()) {
-        neuron_mutator.mutate(neuron, num_outputs());
+    // Mutate neuron genes, with the samples after those of the links
+    const auto &neuron_mutator = genome_config.neuron_mutator;
+    uniforms += MutationUniforms * _links.size();
+    normals += _links.size();
+    for (size_t i = 0; i < _neurons.size(); i++) {
+        if (_neurons[i].is_removed()) {
+            continue;
+        }
+        NeuronGene neuron = _neurons[i];
+        neuron_mutator.mutate(neuron, num_outputs(),
+            uniforms + MutationUniforms * i, normals[i]);
+        if (neuron.bias != _neurons[i].bias
+            || neuron.activation != _neurons[i].activation) {
+            set_neuron(i, neuron);
+        }
     }
 }
 
 /**
  * Structural mutation: Add a neuron.
  * 
+ * @param rng The random stream of the genome.
  */
-void Genome::mutate_add_neuron() {
+void Genome::mutate_add_neuron(RNG &rng) {
     if (links().empty()) {
         // No links to split
         return;
     }
+    if (_next_neuron_id > MaxNeuronId) {
+        // Every neuron id of this lineage is taken
+        return;
+    }
 
     // Choose a random link to split
-    RNG rng;
-    LinkGene &link = rng.choose_from(links());
+    auto link_index = choose_random_link(links(), rng);
+    if (!link_index) {
+        // Only tombstones left
+        return;
+    }
     // Disable the old link
-    link.is_enabled = false;
+    set_enabled(*link_index, false);
+    LinkGene link = _links[*link_index];
 
     // Create a new neuron
-    NeuronGene neuron = neuron_mutator.new_neuron();
+    NeuronGene neuron = _genome_config->neuron_mutator.new_neuron(_next_neuron_id, rng);
     add_neuron(neuron);
     num_hidden()++;
 
     // Create two new links: input -> neuron with weight 1.0,
     // neuron -> output with weight of the old link, both enabled
     LinkId link_id = link.link_id;
-    double weight = link.weight;
-    add_link({{link_id.input_id, neuron.neuron_id}, 1.0, true});
-    add_link({{neuron.neuron_id, link_id.output_id}, weight, true});
+    float weight = link.weight;
+    add_link({{link_id.input_id, neuron.neuron_id}, 1.0});
+    add_link({{neuron.neuron_id, link_id.output_id}, weight});
 }
 
 /**
  * Structural mutation: Remove a neuron.
  * 
+ * @param rng The random stream of the genome.
  */
-void Genome::mutate_remove_neuron() {
+void Genome::mutate_remove_neuron(RNG &rng) {
     if (num_hidden() == 0) {
         // No hidden neurons to remove
         return;
     }
 
     // Choose a random hidden neuron to remove
-    auto &neurons = this->neurons();
-    auto neuron_it = choose_random_hidden(neurons, num_outputs());
+    size_t neuron_index = choose_random_hidden(neurons(), num_outputs(), rng);
+    int neuron_id = _neurons[neuron_index].neuron_id;
 
     // Remove all links connected to the neuron
-    auto &links = this->links();
-    links.erase(
-        std::remove_if(
-            links.begin(),
-            links.end(),
-            [neuron_it](const LinkGene &link) {
-                return link.has_neuron(neuron_it);
-            }),
-        links.end());
+    for (size_t i = 0; i < _links.size(); i++) {
+        if (_links[i].has_neuron(neuron_id)) {
+            remove_link(i);
+        }
+    }
 
     // Remove the neuron
-    neurons.erase(neuron_it);
+    remove_neuron(neuron_index);
     num_hidden()--;
 }
 
 /**
  * Structural mutation: Add a link.
  * 
+ * @param rng The random stream of the genome.
  */
-void Genome::mutate_add_link() {
+void Genome::mutate_add_link(RNG &rng) {
     // Get input and output links
     int input_id = choose_random_input_or_hidden(neurons(),
-        num_outputs());
-    int output_id = choose_random_output_or_hidden(neurons());
+        num_outputs(), rng);
+    int output_id = choose_random_output_or_hidden(neurons(), rng);
     LinkId link_id = {input_id, output_id};
 
     // Avoid duplicate links
-    auto existing_link = find_link(link_id);
+    auto existing_link = find_link_index(link_id);
     if (existing_link) {
         // Enable it
-        existing_link->is_enabled = true;
+        set_enabled(*existing_link, true);
         return;
     }
 
@@ -307,27 +552,90 @@ void Genome::mutate_add_link() {
     }
 
     // Create a new link
-    LinkGene new_link = link_mutator.new_link(input_id, output_id);
+    LinkGene new_link = _genome_config->link_mutator.new_link(input_id, output_id, rng);
     add_link(new_link);
 }
 
 /**
  * Structural mutation: Remove a link.
  * 
+ * @param rng The random stream of the genome.
  */
-void Genome::mutate_remove_link() {
+void Genome::mutate_remove_link(RNG &rng) {
     if (links().empty()) {
         // No links to remove
         return;
     }
 
     // Choose a random link to remove
-    RNG rng;
-    auto &links = this->links();
-    auto link_it = rng.choose_random(links);
+    auto link_index = choose_random_link(links(), rng);
+    if (!link_index) {
+        // Only tombstones left
+        return;
+    }
 
     // Remove the link
-    links.erase(link_it);
+    remove_link(*link_index);
+}
+
+/**
+ * Compare the genes of two genomes exactly.
+ * 
+ * @param other The other genome.
+ * @return True if both have the same live genes, enabled flags included.
+ */
+bool Genome::same_genes(const Genome &other) const {
+    if (_structure_hash != other._structure_hash || _full_hash != other._full_hash) {
+        return false;
+    }
+
+    auto live_neurons = [](const Genome &genome) {
+        vector<NeuronGene> neurons;
+        for (const auto &neuron : genome.neurons()) {
+            if (!neuron.is_removed()) {
+                neurons.push_back(neuron);
+            }
+        }
+        std::sort(neurons.begin(), neurons.end(), [](const NeuronGene &a, const NeuronGene &b) {
+            return a.neuron_id < b.neuron_id;
+        });
+        return neurons;
+    };
+    auto live_links = [](const Genome &genome) {
+        vector<std::pair<LinkGene, bool>> links;
+        for (size_t i = 0; i < genome.links().size(); i++) {
+            if (!genome.links()[i].is_removed()) {
+                links.emplace_back(genome.links()[i], genome.is_enabled(i));
+            }
+        }
+        std::sort(links.begin(), links.end(), [](const auto &a, const auto &b) {
+            const LinkId &x = a.first.link_id, &y = b.first.link_id;
+            return x.input_id != y.input_id ? x.input_id < y.input_id : x.output_id < y.output_id;
+        });
+        return links;
+    };
+
+    vector<NeuronGene> n1 = live_neurons(*this), n2 = live_neurons(other);
+    if (n1.size() != n2.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < n1.size(); i++) {
+        if (n1[i].neuron_id != n2[i].neuron_id || n1[i].bias != n2[i].bias
+            || n1[i].activation != n2[i].activation) {
+            return false;
+        }
+    }
+    auto l1 = live_links(*this), l2 = live_links(other);
+    if (l1.size() != l2.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < l1.size(); i++) {
+        if (!(l1[i].first.link_id == l2[i].first.link_id)
+            || l1[i].first.weight != l2[i].first.weight || l1[i].second != l2[i].second) {
+            return false;
+        }
+    }
+    return true;
 }
 
 /**
@@ -335,22 +643,44 @@ void Genome::mutate_remove_link() {
  * 
  */
 void Genome::print() const {
-    cout << "Genome " << genome_id << endl;
-    cout << "Fitness: " << fitness() << endl;
+    cout << "Genome " << genome_id << "\n";
+    cout << "Fitness: " << fitness() << "\n";
     cout << "Neurons:";
     for (const auto &neuron : neurons()) {
+        if (neuron.is_removed()) {
+            continue;
+        }
         cout << "\n\t" << neuron.neuron_id << " "; 
         neuron.print();
     }
     cout << "\nLinks:";
-    for (const auto &link : links()) {
+    for (size_t i = 0; i < _links.size(); i++) {
+        const auto &link = _links[i];
+        if (link.is_removed()) {
+            continue;
+        }
         cout << "\n\t" << link.link_id.input_id << " -> " << link.link_id.output_id << " ";
         link.print();
+        cout << " Enabled: " << std::boolalpha << is_enabled(i);
     }
     cout << "\n\n";
 }
 
-GenomeIndexer::GenomeIndexer() : index(0) {}
+/**
+ * Memory used by the genome, including its gene storage.
+ * Chunks shared with other genomes are split between their owners,
+ * and the config shared with other genomes is not counted.
+ * 
+ * @return The footprint in bytes.
+ */
+size_t Genome::memory_footprint() const {
+    return sizeof(Genome)
+        + _neurons.memory_footprint()
+        + _links.memory_footprint()
+        + _enabled.memory_footprint();
+}
+
+GenomeIndexer::GenomeIndexer(int first) : index(first) {}
 
 /**
  * Get the next index.
@@ -361,50 +691,78 @@ int GenomeIndexer::next() {
     return index++;
 }
 
+int GenomeIndexer::peek() const {
+    return index.load();
+}
+
 /**
  * Crossover two genomes.
  * 
  * @param g1 The first genome.
  * @param g2 The second genome.
- * @param config The configuration.
  * @param indexer The genome indexer.
+ * @param rng The random stream of the offspring.
  * @return The offspring genome.
  */
-Genome crossover(const Genome &g1, const Genome &g2, Config &config, GenomeIndexer &indexer) {
+Genome crossover(const Genome &g1, const Genome &g2, GenomeIndexer &indexer, RNG &rng) {
     if (g2.fitness() > g1.fitness()) {
-        return crossover(g2, g1, config, indexer);
+        return crossover(g2, g1, indexer, rng);
     }
 
-    // Create a new genome, without neurons or links
-    Genome offspring(indexer.next(), config);
+    // The offspring starts as a copy of the fitter parent, sharing all
+    // of its gene chunks. Excess and disjoint genes are inherited from
+    // it as they are, so only matching genes that take the other
+    // parent's value are written, unsharing their chunk.
+    Genome offspring = g1;
+    offspring.genome_id = indexer.next();
+    offspring.parent_id = g1.genome_id;
+    offspring.mate_id = g2.genome_id;
+    offspring.fitness() = FitnessNotCalculated;
 
     // Inherit neuron genes
-    for (const auto &n1 : g1.neurons()) {
-        int neuron_id = n1.neuron_id;
-        std::optional<NeuronGene> n2 = g2.find_neuron(neuron_id);
-        if (!n2) {
-            // Neuron is unique to g1
-            offspring.add_neuron(n1);
-        } else {
+    size_t num_removed = 0;
+    const auto &neurons = g1.neurons();
+    for (size_t i = 0; i < neurons.size(); i++) {
+        const auto &n1 = neurons[i];
+        if (n1.is_removed()) {
+            num_removed++;
+            continue;
+        }
+        std::optional<NeuronGene> n2 = g2.find_neuron(n1.neuron_id);
+        if (n2) {
             // Crossover matching neurons
-            offspring.add_neuron(crossover_neuron(n1, *n2));
+            NeuronGene neuron = crossover_neuron(n1, *n2, rng);
+            if (neuron.bias != n1.bias || neuron.activation != n1.activation) {
+                offspring.set_neuron(i, neuron);
+            }
         }
     }
 
     // Inherit link genes
-    for (const auto &l1 : g1.links()) {
-        LinkId link_id = l1.link_id;
-        std::optional<LinkGene> l2 = g2.find_link(link_id);
-        if (!l2) {
-            // Excess or disjoint links are inherited 
-            // from the fitter parent
-            offspring.add_link(l1);
-        } else {
+    const auto &links = g1.links();
+    for (size_t i = 0; i < links.size(); i++) {
+        const auto &l1 = links[i];
+        if (l1.is_removed()) {
+            num_removed++;
+            continue;
+        }
+        std::optional<size_t> l2 = g2.find_link_index(l1.link_id);
+        if (l2) {
             // Crossover matching links
-            offspring.add_link(crossover_link(l1, *l2));
+            LinkGene link = crossover_link(l1, g2.links()[*l2], rng);
+            if (link.weight != l1.weight) {
+                offspring.set_link(i, link);
+            }
+            offspring.set_enabled(i, rng.choose<bool>(
+                0.5, g1.is_enabled(i), g2.is_enabled(*l2)));
         }
     }
 
+    // Drop tombstones once they are a quarter of the genome
+    if (4 * num_removed > neurons.size() + links.size()) {
+        offspring.compact();
+    }
+
     return offspring;
 }
 
@@ -413,12 +771,15 @@ Genome crossover(const Genome &g1, const Genome &g2, Config &config, GenomeIndex
  * 
  * @param neurons The neurons to choose from.
  * @param num_outputs The number of output neurons.
+ * @param rng The random stream to draw from.
  * @return The integer id of the chosen neuron.
  */
-int choose_random_input_or_hidden(const vector<NeuronGene> &neurons, int num_outputs) {
-    RNG rng;
+int choose_random_input_or_hidden(const NeuronGenes &neurons, int num_outputs, RNG &rng) {
     vector<int> input_or_hidden;
     for (const auto &neuron : neurons) {
+        if (neuron.is_removed()) {
+            continue;
+        }
         if (neuron.neuron_id < 0 || neuron.neuron_id >= num_outputs) {
             input_or_hidden.push_back(neuron.neuron_id);
         }
@@ -430,10 +791,10 @@ int choose_random_input_or_hidden(const vector<NeuronGene> &neurons, int num_out
  * Choose a random output or hidden neuron.
  * 
  * @param neurons The neurons to choose from.
+ * @param rng The random stream to draw from.
  * @return The integer id of the chosen neuron.
  */
-int choose_random_output_or_hidden(const vector<NeuronGene> &neurons) {
-    RNG rng;
+int choose_random_output_or_hidden(const NeuronGenes &neurons, RNG &rng) {
     vector<int> output_or_hidden;
     for (const auto &neuron : neurons) {
         if (neuron.neuron_id >= 0) {
@@ -448,15 +809,35 @@ int choose_random_output_or_hidden(const vector<NeuronGene> &neurons) {
  * 
  * @param neurons The neurons to choose from.
  * @param num_outputs The number of output neurons.
- * @return The iterator to the chosen neuron.
+ * @param rng The random stream to draw from.
+ * @return The index of the chosen neuron.
  */
-vector<NeuronGene>::iterator choose_random_hidden(vector<NeuronGene> &neurons, int num_outputs) {
-    RNG rng;
-    vector<NeuronGene>::iterator it;
+size_t choose_random_hidden(const NeuronGenes &neurons, int num_outputs, RNG &rng) {
+    size_t i;
     do {
-        it = rng.choose_random(neurons);
-    } while (it->neuron_id < num_outputs);
-    return it;
+        i = rng.next_int(neurons.size() - 1);
+    } while (neurons[i].neuron_id < num_outputs);
+    return i;
+}
+
+/** 
+ * Choose a random link that has not been removed.
+ * 
+ * @param links The links to choose from.
+ * @param rng The random stream to draw from.
+ * @return The index of the chosen link, or nullopt if all were removed.
+ */
+optional<size_t> choose_random_link(const LinkGenes &links, RNG &rng) {
+    vector<size_t> alive;
+    for (size_t i = 0; i < links.size(); i++) {
+        if (!links[i].is_removed()) {
+            alive.push_back(i);
+        }
+    }
+    if (alive.empty()) {
+        return std::nullopt;
+    }
+    return rng.choose_from(alive);
 }
 
 /** 
@@ -467,7 +848,7 @@ vector<NeuronGene>::iterator choose_random_hidden(vector<NeuronGene> &neurons, i
  * @param output_id The id of the output neuron.
  * @return True if a cycle would be created, false otherwise.
  */
-bool is_cyclic(const vector<LinkGene> &links, int input_id, int output_id) {
+bool is_cyclic(const LinkGenes &links, int input_id, int output_id) {
     if (input_id == output_id) {
         return true;
     }
@@ -0,0 +1,577 @@
+// history.cpp
+
+#include "NEAT/history.hpp"
+#include "NEAT/range_coder.hpp"
+#include <cerrno>
+#include <cstring>
+#include <optional>
+#include <unordered_map>
+#include <unistd.h>
+
+static constexpr char MAGIC[8] = {'N', 'E', 'A', 'T', 'H', 'I', 'S', 'T'};
+static constexpr char BLOCK_MAGIC[4] = {'N', 'H', 'G', 'B'};
+static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+// Sanity limit on decoded gene counts
+static constexpr uint64_t MAX_GENES = 1 << 24;
+
+struct HeaderRecord {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    int32_t num_inputs;
+    int32_t num_outputs;
+    uint32_t keyframe_interval;
+    uint32_t reserved;
+};
+
+struct BlockRecord {
+    char magic[4];
+    uint32_t num_genomes;
+    uint64_t generation;
+    uint8_t keyframe;
+    uint8_t padding[7];
+    uint64_t size;
+};
+
+static_assert(sizeof(HeaderRecord) == 32 && sizeof(BlockRecord) == 32,
+    "History records must not be padded");
+
+// Contexts of the coder. Numbers of different kinds get their own, and
+// the four bytes of a float one each, since their statistics differ.
+enum HistoryContext : size_t {
+    COUNT_CONTEXT,
+    GENOME_ID_CONTEXT,
+    PARENT_CONTEXT,
+    HIDDEN_CONTEXT,
+    NEURON_ID_CONTEXT,
+    ACTIVATION_CONTEXT,
+    LINK_INPUT_CONTEXT,
+    LINK_OUTPUT_CONTEXT,
+    NEURON_KEPT_CONTEXT,
+    NEURON_CHANGED_CONTEXT,
+    NEURON_FROM_MATE_CONTEXT,
+    LINK_KEPT_CONTEXT,
+    LINK_CHANGED_CONTEXT,
+    LINK_FROM_MATE_CONTEXT,
+    ENABLED_CONTEXT,
+    NEW_ENABLED_CONTEXT,
+    FITNESS_CONTEXT,
+    BIAS_CONTEXT = FITNESS_CONTEXT + 4,
+    NEW_BIAS_CONTEXT = BIAS_CONTEXT + 4,
+    WEIGHT_CONTEXT = NEW_BIAS_CONTEXT + 4,
+    NEW_WEIGHT_CONTEXT = WEIGHT_CONTEXT + 4,
+    NUM_CONTEXTS = NEW_WEIGHT_CONTEXT + 4
+};
+
+using Encoder = RangeEncoder<NUM_CONTEXTS>;
+using Decoder = RangeDecoder<NUM_CONTEXTS>;
+
+static uint32_t float_bits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float bits_float(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static uint64_t zigzag(int64_t value) {
+    return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+    return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+}
+
+/**
+ * Find the gene matching a gene of the parent. Genes keep their order
+ * from parent to offspring, so the search starts after the last match.
+ *
+ * @param genes The genes of the offspring.
+ * @param cursor The index after the last match, advanced on a match.
+ * @param matches Whether a gene is the one looked for.
+ * @return The index of the gene, nullopt if the offspring does not have it.
+ */
+template <typename Genes, typename Matches>
+static std::optional<size_t> find_gene(const Genes &genes, size_t &cursor, Matches matches) {
+    for (size_t i = cursor; i < genes.size(); i++) {
+        if (matches(genes[i])) {
+            cursor = i + 1;
+            return i;
+        }
+    }
+    for (size_t i = 0; i < cursor && i < genes.size(); i++) {
+        if (matches(genes[i])) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+// Parents of a genome in the previous generation, as rebuilt by the
+// reader. Null when they are not there, e.g. in keyframes.
+struct Parents {
+    const Genome *parent;
+    const Genome *mate;
+};
+
+static Parents find_parents(const Genome &genome, const vector<Genome> &previous,
+    const std::unordered_map<int, size_t> &index) {
+    auto parent = index.find(genome.parent_id);
+    auto mate = index.find(genome.mate_id);
+    return {parent == index.end() ? nullptr : &previous[parent->second],
+        mate == index.end() ? nullptr : &previous[mate->second]};
+}
+
+static uint64_t parent_code(int genome_id, int parent_id) {
+    return parent_id == -1 ? 0 : zigzag((int64_t) genome_id - parent_id) + 1;
+}
+
+static int parent_id(int genome_id, uint64_t code) {
+    return code == 0 ? -1 : (int) (genome_id - unzigzag(code - 1));
+}
+
+/**
+ * Code a genome, against its parents if they are in the previous
+ * generation. Each gene of the parent is either dropped, kept as it is,
+ * taken from the mate, or changed; new genes are coded whole.
+ *
+ * @param encoder The coder of the generation.
+ * @param genome The genome.
+ * @param previous The previous generation, as rebuilt by the reader.
+ * @param index Index of the previous generation by genome id, empty
+ * for keyframes.
+ * @param last_id The id of the genome coded before, updated.
+ * @return The genome as the reader rebuilds it, with its genes in the
+ * order they are coded in, which its offspring are coded against.
+ */
+static Genome put_genome(Encoder &encoder, const Genome &genome,
+    const vector<Genome> &previous, const std::unordered_map<int, size_t> &index,
+    int &last_id) {
+    encoder.put_varint(GENOME_ID_CONTEXT, zigzag((int64_t) genome.genome_id - last_id - 1));
+    last_id = genome.genome_id;
+    encoder.put_varint(PARENT_CONTEXT, parent_code(genome.genome_id, genome.parent_id));
+    encoder.put_varint(PARENT_CONTEXT, parent_code(genome.genome_id, genome.mate_id));
+    encoder.put_varint(HIDDEN_CONTEXT, zigzag(genome.num_hidden()));
+    Parents parents = find_parents(genome, previous, index);
+    const Genome *parent = parents.parent, *mate = parents.mate;
+    encoder.put_u32(FITNESS_CONTEXT, float_bits(genome.fitness())
+        ^ (parent ? float_bits(parent->fitness()) : 0));
+
+    Genome rebuilt(genome.genome_id, genome.genome_config());
+    rebuilt.parent_id = genome.parent_id;
+    rebuilt.mate_id = genome.mate_id;
+    rebuilt.num_hidden() = genome.num_hidden();
+    rebuilt.fitness() = genome.fitness();
+
+    // Neurons of the parent, then new ones
+    const auto &neurons = genome.neurons();
+    vector<uint8_t> inherited(neurons.size(), 0);
+    if (parent) {
+        size_t cursor = 0, mate_cursor = 0;
+        for (const auto &old : parent->neurons()) {
+            auto same_id = [&](const NeuronGene &neuron) {
+                return neuron.neuron_id == old.neuron_id;
+            };
+            auto at = find_gene(neurons, cursor, same_id);
+            encoder.put_bit(NEURON_KEPT_CONTEXT, at.has_value());
+            if (!at) {
+                continue;
+            }
+            const NeuronGene &neuron = neurons[*at];
+            inherited[*at] = 1;
+            rebuilt.add_neuron(neuron);
+            bool changed = float_bits(neuron.bias) != float_bits(old.bias)
+                || neuron.activation != old.activation;
+            encoder.put_bit(NEURON_CHANGED_CONTEXT, changed);
+            if (!changed) {
+                continue;
+            }
+            auto mate_at = mate ? find_gene(mate->neurons(), mate_cursor, same_id) : std::nullopt;
+            if (mate_at) {
+                const NeuronGene &other = mate->neurons()[*mate_at];
+                bool from_mate = float_bits(neuron.bias) == float_bits(other.bias)
+                    && neuron.activation == other.activation;
+                encoder.put_bit(NEURON_FROM_MATE_CONTEXT, from_mate);
+                if (from_mate) {
+                    continue;
+                }
+            }
+            encoder.put_u32(BIAS_CONTEXT, float_bits(neuron.bias) ^ float_bits(old.bias));
+            encoder.put_byte(ACTIVATION_CONTEXT,
+                (uint8_t) neuron.activation ^ (uint8_t) old.activation);
+        }
+    }
+    uint64_t num_new = 0;
+    for (size_t i = 0; i < neurons.size(); i++) {
+        num_new += !inherited[i] && !neurons[i].is_removed();
+    }
+    encoder.put_varint(COUNT_CONTEXT, num_new);
+    int last_neuron_id = 0;
+    for (size_t i = 0; i < neurons.size(); i++) {
+        const NeuronGene &neuron = neurons[i];
+        if (inherited[i] || neuron.is_removed()) {
+            continue;
+        }
+        encoder.put_varint(NEURON_ID_CONTEXT, zigzag((int64_t) neuron.neuron_id - last_neuron_id));
+        last_neuron_id = neuron.neuron_id;
+        encoder.put_u32(NEW_BIAS_CONTEXT, float_bits(neuron.bias));
+        encoder.put_byte(ACTIVATION_CONTEXT, (uint8_t) neuron.activation);
+        rebuilt.add_neuron(neuron);
+    }
+
+    // Same for links, with their enabled flags
+    const auto &links = genome.links();
+    inherited.assign(links.size(), 0);
+    if (parent) {
+        size_t cursor = 0, mate_cursor = 0;
+        const auto &old_links = parent->links();
+        for (size_t j = 0; j < old_links.size(); j++) {
+            const LinkGene &old = old_links[j];
+            auto same_id = [&](const LinkGene &link) {
+                return link.link_id == old.link_id;
+            };
+            auto at = find_gene(links, cursor, same_id);
+            encoder.put_bit(LINK_KEPT_CONTEXT, at.has_value());
+            if (!at) {
+                continue;
+            }
+            const LinkGene &link = links[*at];
+            bool is_enabled = genome.is_enabled(*at);
+            inherited[*at] = 1;
+            rebuilt.add_link(link, is_enabled);
+            encoder.put_bit(ENABLED_CONTEXT, is_enabled != parent->is_enabled(j));
+            bool changed = float_bits(link.weight) != float_bits(old.weight);
+            encoder.put_bit(LINK_CHANGED_CONTEXT, changed);
+            if (!changed) {
+                continue;
+            }
+            auto mate_at = mate ? find_gene(mate->links(), mate_cursor, same_id) : std::nullopt;
+            if (mate_at) {
+                bool from_mate = float_bits(link.weight)
+                    == float_bits(mate->links()[*mate_at].weight);
+                encoder.put_bit(LINK_FROM_MATE_CONTEXT, from_mate);
+                if (from_mate) {
+                    continue;
+                }
+            }
+            encoder.put_u32(WEIGHT_CONTEXT, float_bits(link.weight) ^ float_bits(old.weight));
+        }
+    }
+    num_new = 0;
+    for (size_t i = 0; i < links.size(); i++) {
+        num_new += !inherited[i] && !links[i].is_removed();
+    }
+    encoder.put_varint(COUNT_CONTEXT, num_new);
+    for (size_t i = 0; i < links.size(); i++) {
+        const LinkGene &link = links[i];
+        if (inherited[i] || link.is_removed()) {
+            continue;
+        }
+        encoder.put_varint(LINK_INPUT_CONTEXT, zigzag(link.link_id.input_id));
+        encoder.put_varint(LINK_OUTPUT_CONTEXT, zigzag(link.link_id.output_id));
+        encoder.put_u32(NEW_WEIGHT_CONTEXT, float_bits(link.weight));
+        encoder.put_bit(NEW_ENABLED_CONTEXT, genome.is_enabled(i));
+        rebuilt.add_link(link, genome.is_enabled(i));
+    }
+    return rebuilt;
+}
+
+static uint64_t get_count(Decoder &decoder) {
+    uint64_t count = decoder.get_varint(COUNT_CONTEXT);
+    if (count > MAX_GENES) {
+        throw std::invalid_argument("Gene count out of range in history");
+    }
+    return count;
+}
+
+/**
+ * Decode a genome coded by put_genome.
+ *
+ * @param decoder The decoder of the generation.
+ * @param previous The previous generation.
+ * @param index Index of the previous generation by genome id, empty
+ * for keyframes.
+ * @param genome_config The shared config of the decoded genome.
+ * @param last_id The id of the genome decoded before, updated.
+ * @return The genome.
+ */
+static Genome get_genome(Decoder &decoder, const vector<Genome> &previous,
+    const std::unordered_map<int, size_t> &index,
+    const shared_ptr<const GenomeConfig> &genome_config, int &last_id) {
+    Genome genome((int) (last_id + 1 + unzigzag(decoder.get_varint(GENOME_ID_CONTEXT))),
+        genome_config);
+    last_id = genome.genome_id;
+    genome.parent_id = parent_id(genome.genome_id, decoder.get_varint(PARENT_CONTEXT));
+    genome.mate_id = parent_id(genome.genome_id, decoder.get_varint(PARENT_CONTEXT));
+    genome.num_hidden() = (int) unzigzag(decoder.get_varint(HIDDEN_CONTEXT));
+    Parents parents = find_parents(genome, previous, index);
+    const Genome *parent = parents.parent, *mate = parents.mate;
+    genome.fitness() = bits_float(decoder.get_u32(FITNESS_CONTEXT)
+        ^ (parent ? float_bits(parent->fitness()) : 0));
+
+    if (parent) {
+        size_t mate_cursor = 0;
+        for (const auto &old : parent->neurons()) {
+            if (!decoder.get_bit(NEURON_KEPT_CONTEXT)) {
+                continue;
+            }
+            NeuronGene neuron = old;
+            if (decoder.get_bit(NEURON_CHANGED_CONTEXT)) {
+                auto mate_at = mate ? find_gene(mate->neurons(), mate_cursor,
+                    [&](const NeuronGene &other) { return other.neuron_id == old.neuron_id; })
+                    : std::nullopt;
+                if (mate_at && decoder.get_bit(NEURON_FROM_MATE_CONTEXT)) {
+                    neuron = mate->neurons()[*mate_at];
+                } else {
+                    neuron.bias = bits_float(decoder.get_u32(BIAS_CONTEXT) ^ float_bits(old.bias));
+                    neuron.activation = (Activation) (decoder.get_byte(ACTIVATION_CONTEXT)
+                        ^ (uint8_t) old.activation);
+                }
+            }
+            genome.add_neuron(neuron);
+        }
+    }
+    int last_neuron_id = 0;
+    for (uint64_t i = get_count(decoder); i > 0; i--) {
+        int64_t neuron_id = last_neuron_id + unzigzag(decoder.get_varint(NEURON_ID_CONTEXT));
+        if (!fits_neuron_id(neuron_id)) {
+            throw std::invalid_argument("Neuron id out of range in history");
+        }
+        NeuronGene neuron;
+        neuron.neuron_id = neuron_id;
+        last_neuron_id = neuron_id;
+        neuron.bias = bits_float(decoder.get_u32(NEW_BIAS_CONTEXT));
+        neuron.activation = (Activation) decoder.get_byte(ACTIVATION_CONTEXT);
+        genome.add_neuron(neuron);
+    }
+    for (const auto &neuron : genome.neurons()) {
+        if (neuron.activation > Activation::SOFTMAX) {
+            throw std::invalid_argument("Invalid activation in history");
+        }
+    }
+
+    if (parent) {
+        size_t mate_cursor = 0;
+        const auto &old_links = parent->links();
+        for (size_t j = 0; j < old_links.size(); j++) {
+            if (!decoder.get_bit(LINK_KEPT_CONTEXT)) {
+                continue;
+            }
+            LinkGene link = old_links[j];
+            bool is_enabled = decoder.get_bit(ENABLED_CONTEXT) != parent->is_enabled(j);
+            if (decoder.get_bit(LINK_CHANGED_CONTEXT)) {
+                auto mate_at = mate ? find_gene(mate->links(), mate_cursor,
+                    [&](const LinkGene &other) { return other.link_id == link.link_id; })
+                    : std::nullopt;
+                if (mate_at && decoder.get_bit(LINK_FROM_MATE_CONTEXT)) {
+                    link.weight = mate->links()[*mate_at].weight;
+                } else {
+                    link.weight = bits_float(decoder.get_u32(WEIGHT_CONTEXT)
+                        ^ float_bits(link.weight));
+                }
+            }
+            genome.add_link(link, is_enabled);
+        }
+    }
+    for (uint64_t i = get_count(decoder); i > 0; i--) {
+        int64_t input_id = unzigzag(decoder.get_varint(LINK_INPUT_CONTEXT));
+        int64_t output_id = unzigzag(decoder.get_varint(LINK_OUTPUT_CONTEXT));
+        if (!fits_neuron_id(input_id) || !fits_neuron_id(output_id)) {
+            throw std::invalid_argument("Neuron id out of range in history");
+        }
+        LinkGene link;
+        link.link_id = {(int) input_id, (int) output_id};
+        link.weight = bits_float(decoder.get_u32(NEW_WEIGHT_CONTEXT));
+        genome.add_link(link, decoder.get_bit(NEW_ENABLED_CONTEXT));
+    }
+    return genome;
+}
+
+// Index of a generation by genome id. Ids are unique within a
+// population; if they are not, the first genome with an id wins.
+static std::unordered_map<int, size_t> index_by_id(const vector<Genome> &genomes) {
+    std::unordered_map<int, size_t> index;
+    for (size_t i = 0; i < genomes.size(); i++) {
+        index.emplace(genomes[i].genome_id, i);
+    }
+    return index;
+}
+
+HistoryWriter::HistoryWriter(const string &path, const GenomeConfig &genome_config,
+    uint32_t keyframe_interval) : path(path), keyframe_interval(keyframe_interval),
+    _num_generations(0), _bytes_written(0) {
+    if (keyframe_interval == 0) {
+        throw std::invalid_argument("Keyframe interval must be positive");
+    }
+    if (std::ifstream(path)) {
+        // Carry on after the last whole generation
+        HistoryReader reader(path);
+        if (reader.num_inputs() != genome_config.num_inputs
+            || reader.num_outputs() != genome_config.num_outputs) {
+            throw std::invalid_argument(path + " holds genomes of other inputs or outputs");
+        }
+        this->keyframe_interval = reader.keyframe_interval();
+        _num_generations = reader.num_generations();
+        _bytes_written = reader.end();
+        if (::truncate(path.c_str(), _bytes_written) != 0) {
+            throw std::runtime_error("Could not write history to " + path + ": "
+                + strerror(errno));
+        }
+        file.open(path, std::ios::binary | std::ios::app);
+    } else {
+        file.open(path, std::ios::binary);
+        HeaderRecord header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = HistoryVersion;
+        header.byte_order = BYTE_ORDER_MARK;
+        header.num_inputs = genome_config.num_inputs;
+        header.num_outputs = genome_config.num_outputs;
+        header.keyframe_interval = keyframe_interval;
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.flush();
+        _bytes_written = sizeof(header);
+    }
+    if (!file) {
+        throw std::runtime_error("Could not write history to " + path);
+    }
+}
+
+/**
+ * Append a generation to the history.
+ *
+ * @param generation The number of the generation, e.g.
+ * Population::generation().
+ * @param genomes The genomes of the generation.
+ */
+void HistoryWriter::append(uint64_t generation, const vector<Genome> &genomes) {
+    bool keyframe = previous.empty() || _num_generations % keyframe_interval == 0;
+    std::unordered_map<int, size_t> by_id;
+    if (!keyframe) {
+        by_id = index_by_id(previous);
+    }
+
+    buffer.clear();
+    Encoder encoder(buffer);
+    vector<Genome> rebuilt;
+    rebuilt.reserve(genomes.size());
+    int last_id = -1;
+    for (const auto &genome : genomes) {
+        rebuilt.push_back(put_genome(encoder, genome, previous, by_id, last_id));
+    }
+    encoder.finish();
+
+    BlockRecord block{};
+    std::memcpy(block.magic, BLOCK_MAGIC, sizeof(BLOCK_MAGIC));
+    block.num_genomes = genomes.size();
+    block.generation = generation;
+    block.keyframe = keyframe;
+    block.size = buffer.size();
+    file.write(reinterpret_cast<const char *>(&block), sizeof(block));
+    file.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+    // A crash loses at most the generation being written
+    file.flush();
+    if (!file) {
+        throw std::runtime_error("Could not write history to " + path);
+    }
+    _bytes_written += sizeof(block) + buffer.size();
+    _num_generations++;
+    previous = std::move(rebuilt);
+}
+
+HistoryReader::HistoryReader(const string &path) : path(path),
+    file(path, std::ios::binary) {
+    if (!file) {
+        throw std::runtime_error("Could not read history from " + path);
+    }
+    HeaderRecord header;
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))
+        || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::invalid_argument(path + " is not a history");
+    }
+    if (header.version != HistoryVersion) {
+        throw std::invalid_argument(path + " has an unsupported history version");
+    }
+    if (header.byte_order != BYTE_ORDER_MARK) {
+        throw std::invalid_argument(path + " was written on a machine of another byte order");
+    }
+    _num_inputs = header.num_inputs;
+    _num_outputs = header.num_outputs;
+    _keyframe_interval = header.keyframe_interval;
+
+    file.seekg(0, std::ios::end);
+    uint64_t file_size = file.tellg();
+    uint64_t offset = sizeof(header);
+    while (file_size - offset >= sizeof(BlockRecord)) {
+        BlockRecord record;
+        file.seekg(offset);
+        file.read(reinterpret_cast<char *>(&record), sizeof(record));
+        if (std::memcmp(record.magic, BLOCK_MAGIC, sizeof(BLOCK_MAGIC)) != 0) {
+            throw std::invalid_argument(path + " has a malformed generation");
+        }
+        if (record.size > file_size - offset - sizeof(record)) {
+            // Unfinished, the writer stopped in the middle of it
+            break;
+        }
+        if (blocks.empty() && !record.keyframe) {
+            throw std::invalid_argument(path + " does not start with a keyframe");
+        }
+        blocks.push_back({record.generation, record.num_genomes, record.keyframe != 0,
+            offset + sizeof(record), record.size});
+        offset += sizeof(record) + record.size;
+    }
+    file.clear();
+}
+
+uint64_t HistoryReader::end() const {
+    return blocks.empty() ? sizeof(HeaderRecord) : blocks.back().offset + blocks.back().size;
+}
+
+/**
+ * Rebuild a generation, from the keyframe before it.
+ *
+ * @param index The index of the generation in the history.
+ * @param genome_config The shared config of the rebuilt genomes.
+ * @return The genomes of the generation.
+ */
+vector<Genome> HistoryReader::generation(size_t index,
+    const shared_ptr<const GenomeConfig> &genome_config) {
+    if (index >= blocks.size()) {
+        throw std::out_of_range("No generation " + std::to_string(index) + " in the history");
+    }
+    if (genome_config->num_inputs != _num_inputs || genome_config->num_outputs != _num_outputs) {
+        throw std::invalid_argument("The history has other inputs or outputs than the config");
+    }
+    size_t first = index;
+    while (!blocks[first].keyframe) {
+        first--;
+    }
+
+    vector<Genome> genomes;
+    vector<uint8_t> bytes;
+    for (size_t i = first; i <= index; i++) {
+        const Block &block = blocks[i];
+        bytes.resize(block.size);
+        file.seekg(block.offset);
+        if (!file.read(reinterpret_cast<char *>(bytes.data()), bytes.size())) {
+            throw std::runtime_error("Could not read history from " + path);
+        }
+
+        vector<Genome> previous = std::move(genomes);
+        std::unordered_map<int, size_t> by_id;
+        if (!block.keyframe) {
+            by_id = index_by_id(previous);
+        }
+        genomes.clear();
+        genomes.reserve(block.num_genomes);
+        Decoder decoder(bytes.data(), bytes.size());
+        int last_id = -1;
+        for (uint32_t j = 0; j < block.num_genomes; j++) {
+            genomes.push_back(get_genome(decoder, previous, by_id, genome_config, last_id));
+        }
+    }
+    return genomes;
+}
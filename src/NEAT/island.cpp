@@ -0,0 +1,251 @@
+// island.cpp
+
+#include "NEAT/island.hpp"
+#include "NEAT/serialize.hpp"
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Largest genome encoding that can be sent between islands
+static constexpr size_t SLOT_SIZE = 16 * 1024;
+// Migrations that can be in flight between two islands
+static constexpr size_t MIGRATIONS_IN_FLIGHT = 2;
+
+// Messages are stored after their length
+static constexpr size_t LENGTH_SIZE = sizeof(uint32_t);
+
+SharedRings::SharedRings(size_t num_rings, size_t num_slots, size_t slot_size) :
+    _num_rings(num_rings), _num_slots(num_slots), _slot_size(slot_size) {
+    _bytes = num_rings * (sizeof(Ring) + num_slots * (LENGTH_SIZE + slot_size));
+    void *memory = mmap(nullptr, _bytes, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        throw std::runtime_error("Could not map shared memory for the rings");
+    }
+    _memory = (uint8_t *) memory;
+    for (size_t i = 0; i < num_rings; i++) {
+        new (&ring(i)) Ring{};
+    }
+}
+
+SharedRings::~SharedRings() {
+    munmap(_memory, _bytes);
+}
+
+size_t SharedRings::slot_size() const {
+    return _slot_size;
+}
+
+SharedRings::Ring &SharedRings::ring(size_t index) {
+    return *(Ring *) (_memory + index * sizeof(Ring));
+}
+
+uint8_t *SharedRings::slot(size_t index, uint64_t position) {
+    uint8_t *slots = _memory + _num_rings * sizeof(Ring);
+    size_t slot_index = index * _num_slots + position % _num_slots;
+    return slots + slot_index * (LENGTH_SIZE + _slot_size);
+}
+
+/**
+ * Add a message to a ring. Only one process may push to a ring.
+ *
+ * @param index The ring.
+ * @param message The message.
+ * @return true if the message was added, false if the ring is full or
+ * the message is longer than a slot.
+ */
+bool SharedRings::push(size_t index, const vector<uint8_t> &message) {
+    Ring &r = ring(index);
+    uint64_t tail = r.tail.value.load(std::memory_order_relaxed);
+    uint64_t head = r.head.value.load(std::memory_order_acquire);
+    if (tail - head == _num_slots || message.size() > _slot_size) {
+        return false;
+    }
+
+    uint8_t *at = slot(index, tail);
+    uint32_t length = message.size();
+    std::memcpy(at, &length, LENGTH_SIZE);
+    std::memcpy(at + LENGTH_SIZE, message.data(), length);
+    // Publish the slot only once it is written
+    r.tail.value.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * Take the oldest message of a ring. Only one process may pop from a ring.
+ *
+ * @param index The ring.
+ * @param message Set to the message.
+ * @return true if there was a message, false if the ring is empty.
+ */
+bool SharedRings::pop(size_t index, vector<uint8_t> &message) {
+    Ring &r = ring(index);
+    uint64_t head = r.head.value.load(std::memory_order_relaxed);
+    uint64_t tail = r.tail.value.load(std::memory_order_acquire);
+    if (head == tail) {
+        return false;
+    }
+
+    const uint8_t *at = slot(index, head);
+    uint32_t length;
+    std::memcpy(&length, at, LENGTH_SIZE);
+    message.assign(at + LENGTH_SIZE, at + LENGTH_SIZE + length);
+    // Hand the slot back to the producer
+    r.head.value.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * Get the islands an island sends its migrants to.
+ *
+ * @param topology The migration topology.
+ * @param island The sending island.
+ * @param num_islands The number of islands.
+ * @return The receiving islands.
+ */
+vector<int> migration_targets(MigrationTopology topology, int island, int num_islands) {
+    vector<int> targets;
+    if (num_islands < 2) {
+        return targets;
+    }
+    if (topology == MigrationTopology::RING) {
+        targets.push_back((island + 1) % num_islands);
+    } else {
+        for (int i = 0; i < num_islands; i++) {
+            if (i != island) {
+                targets.push_back(i);
+            }
+        }
+    }
+    return targets;
+}
+
+/**
+ * Get the islands an island receives migrants from.
+ *
+ * @param topology The migration topology.
+ * @param island The receiving island.
+ * @param num_islands The number of islands.
+ * @return The sending islands.
+ */
+vector<int> migration_sources(MigrationTopology topology, int island, int num_islands) {
+    if (topology == MigrationTopology::RING && num_islands > 1) {
+        return {(island + num_islands - 1) % num_islands};
+    }
+    return migration_targets(topology, island, num_islands);
+}
+
+/**
+ * Exchange migrants with the neighbours of an island. Sending never
+ * waits: migrants that do not fit in a full ring are dropped, and only
+ * the migrants that already arrived are received.
+ *
+ * @param population The population of the island.
+ * @param island The island.
+ * @param rings The rings between islands, ring from * num_islands + to
+ * going from island from to island to.
+ * @param params The parameters of the run.
+ */
+void migrate(Population &population, int island, SharedRings &rings,
+    const NeatParams &params) {
+    const int num_islands = params.num_islands;
+    vector<uint8_t> message;
+
+    vector<Genome> emigrants = population.top_genomes(params.migration_size);
+    for (int target : migration_targets(params.migration_topology, island, num_islands)) {
+        for (const auto &genome : emigrants) {
+            message.clear();
+            encode_genome(genome, message);
+            rings.push(island * num_islands + target, message);
+        }
+    }
+
+    vector<Genome> immigrants;
+    Genome genome(-1, population.genome_config());
+    for (int source : migration_sources(params.migration_topology, island, num_islands)) {
+        while (rings.pop(source * num_islands + island, message)) {
+            decode_genome(message.data(), message.size(), population.genome_config(), genome);
+            immigrants.push_back(genome);
+        }
+    }
+    population.immigrate(immigrants);
+}
+
+/**
+ * Run each island in its own process.
+ *
+ * @param params The parameters of the run.
+ * @param run_island Runs one island, and returns its best genome.
+ * @return The best genome of all islands.
+ */
+Genome run_island_processes(const NeatParams &params,
+    const std::function<Genome(int island, SharedRings &rings)> &run_island) {
+    const int num_islands = params.num_islands;
+    // One ring per pair of islands, and one per island for its result
+    const size_t first_result_ring = (size_t) num_islands * num_islands;
+    size_t num_slots = MIGRATIONS_IN_FLIGHT * std::max(1, params.migration_size);
+    SharedRings rings(first_result_ring + num_islands, num_slots, SLOT_SIZE);
+
+    // Output buffered before the fork would be written by every child
+    std::cout.flush();
+    std::cerr.flush();
+
+    vector<pid_t> children;
+    for (int island = 0; island < num_islands; island++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::cerr << "Could not fork island " << island << std::endl;
+            continue;
+        }
+        if (pid == 0) {
+            int status = 0;
+            try {
+                vector<uint8_t> result;
+                encode_genome(run_island(island, rings), result);
+                if (!rings.push(first_result_ring + island, result)) {
+                    std::cerr << "Best genome of island " << island
+                        << " is too large to return" << std::endl;
+                    status = 1;
+                }
+            } catch (const std::exception &e) {
+                std::cerr << "Island " << island << " failed: " << e.what() << std::endl;
+                status = 1;
+            }
+            std::cout.flush();
+            // Skip the destructors and exit handlers of the parent's objects
+            _exit(status);
+        }
+        children.push_back(pid);
+    }
+
+    for (pid_t pid : children) {
+        int status;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::cerr << "Island process " << pid << " did not finish" << std::endl;
+        }
+    }
+
+    auto genome_config = std::make_shared<const GenomeConfig>(params);
+    Genome best(-1, genome_config), genome(-1, genome_config);
+    bool found = false;
+    vector<uint8_t> message;
+    for (int island = 0; island < num_islands; island++) {
+        if (!rings.pop(first_result_ring + island, message)) {
+            continue;
+        }
+        decode_genome(message.data(), message.size(), genome_config, genome);
+        if (!found || genome.fitness() > best.fitness()) {
+            best = genome;
+            found = true;
+        }
+    }
+    if (!found) {
+        throw std::runtime_error("No island finished");
+    }
+    return best;
+}
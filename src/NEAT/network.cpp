@@ -0,0 +1,178 @@
+// network.cpp
+
+#include "NEAT/network.hpp"
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Apply an activation function. Softmax is normalised over the outputs
+ * after the pass, so it is linear here.
+ *
+ * @param x The weighted sum of the neuron.
+ * @param activation The activation function.
+ * @return The value of the neuron.
+ */
+static float activate_value(float x, Activation activation) {
+    switch (activation) {
+        case Activation::SIGMOID:
+            return 1.0f / (1.0f + std::exp(-x));
+        case Activation::TANH:
+            return std::tanh(x);
+        case Activation::RELU:
+            return std::max(0.0f, x);
+        case Activation::LINEAR:
+        case Activation::SOFTMAX:
+        default:
+            return x;
+    }
+}
+
+/**
+ * Build the network of a genome. Removed genes, disabled links and
+ * links to unknown neurons are left out.
+ *
+ * @param genome The genome.
+ */
+FeedForwardNetwork::FeedForwardNetwork(const Genome &genome) :
+    _num_inputs(genome.num_inputs()), _num_outputs(genome.num_outputs()) {
+    const auto &neurons = genome.neurons();
+    const auto &links = genome.links();
+
+    // Non-input neurons, by id
+    std::unordered_map<int, size_t> neuron_index;
+    vector<const NeuronGene *> hidden;
+    for (const auto &neuron : neurons) {
+        if (!neuron.is_removed() && neuron.neuron_id >= 0) {
+            neuron_index[neuron.neuron_id] = hidden.size();
+            hidden.push_back(&neuron);
+        }
+    }
+    auto is_input = [this](int id) { return id < 0 && id >= -_num_inputs; };
+
+    // Incoming links of each neuron, and the links between neurons
+    vector<vector<size_t>> incoming(hidden.size());
+    vector<vector<size_t>> outgoing(hidden.size());
+    vector<int> in_degree(hidden.size(), 0);
+    for (size_t i = 0; i < links.size(); i++) {
+        const auto &link = links[i];
+        if (link.is_removed() || !genome.is_enabled(i)) {
+            continue;
+        }
+        auto out = neuron_index.find(link.link_id.output_id);
+        if (out == neuron_index.end()) {
+            continue;
+        }
+        if (is_input(link.link_id.input_id)) {
+            incoming[out->second].push_back(i);
+            continue;
+        }
+        auto in = neuron_index.find(link.link_id.input_id);
+        if (in == neuron_index.end()) {
+            continue;
+        }
+        incoming[out->second].push_back(i);
+        outgoing[in->second].push_back(out->second);
+        in_degree[out->second]++;
+    }
+
+    // Order the neurons so each comes after its inputs (Kahn's algorithm)
+    vector<size_t> order;
+    order.reserve(hidden.size());
+    for (size_t i = 0; i < hidden.size(); i++) {
+        if (in_degree[i] == 0) {
+            order.push_back(i);
+        }
+    }
+    for (size_t k = 0; k < order.size(); k++) {
+        for (size_t next : outgoing[order[k]]) {
+            if (--in_degree[next] == 0) {
+                order.push_back(next);
+            }
+        }
+    }
+    // Neurons on a cycle, which genomes should not have, read the
+    // previous values of their inputs
+    for (size_t i = 0; i < hidden.size(); i++) {
+        if (in_degree[i] > 0) {
+            order.push_back(i);
+        }
+    }
+
+    vector<int> value_index(hidden.size());
+    for (size_t k = 0; k < order.size(); k++) {
+        value_index[order[k]] = _num_inputs + k;
+    }
+    auto source_index = [&](int id) {
+        return is_input(id) ? -id - 1 : value_index[neuron_index[id]];
+    };
+
+    nodes.reserve(order.size());
+    for (size_t i : order) {
+        nodes.push_back({value_index[i], (int) link_sources.size(),
+            (int) incoming[i].size(), hidden[i]->bias, hidden[i]->activation});
+        for (size_t l : incoming[i]) {
+            link_sources.push_back(source_index(links[l].link_id.input_id));
+            link_weights.push_back(links[l].weight);
+        }
+    }
+
+    values.assign(_num_inputs + hidden.size(), 0.0f);
+    output_indices.assign(_num_outputs, -1);
+    softmax_outputs.assign(_num_outputs, false);
+    for (int j = 0; j < _num_outputs; j++) {
+        auto it = neuron_index.find(j);
+        if (it != neuron_index.end()) {
+            output_indices[j] = value_index[it->second];
+            softmax_outputs[j] = hidden[it->second]->activation == Activation::SOFTMAX;
+        }
+    }
+}
+
+/**
+ * Run the network.
+ *
+ * @param inputs The input values.
+ * @param outputs Set to the output values.
+ */
+void FeedForwardNetwork::activate(const float *inputs, float *outputs) {
+    std::copy(inputs, inputs + _num_inputs, values.begin());
+    for (const auto &node : nodes) {
+        float sum = node.bias;
+        const int end = node.first_link + node.num_links;
+        for (int l = node.first_link; l < end; l++) {
+            sum += link_weights[l] * values[link_sources[l]];
+        }
+        values[node.value_index] = activate_value(sum, node.activation);
+    }
+
+    float max_value = -INFINITY;
+    for (int j = 0; j < _num_outputs; j++) {
+        outputs[j] = output_indices[j] < 0 ? 0.0f : values[output_indices[j]];
+        if (softmax_outputs[j]) {
+            max_value = std::max(max_value, outputs[j]);
+        }
+    }
+
+    // Softmax over the softmax outputs, shifted by their maximum
+    float total = 0.0f;
+    for (int j = 0; j < _num_outputs; j++) {
+        if (softmax_outputs[j]) {
+            outputs[j] = std::exp(outputs[j] - max_value);
+            total += outputs[j];
+        }
+    }
+    for (int j = 0; j < _num_outputs; j++) {
+        if (softmax_outputs[j]) {
+            outputs[j] /= total;
+        }
+    }
+}
+
+int FeedForwardNetwork::num_inputs() const {
+    return _num_inputs;
+}
+
+int FeedForwardNetwork::num_outputs() const {
+    return _num_outputs;
+}
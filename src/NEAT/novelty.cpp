@@ -0,0 +1,152 @@
+// novelty.cpp
+
+#include "NEAT/novelty.hpp"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <stdexcept>
+
+VPTree::VPTree(const float *points, size_t num_points, size_t dim) :
+    points(points), dim(dim) {
+    vector<uint32_t> indices(num_points);
+    for (size_t i = 0; i < num_points; i++) {
+        indices[i] = i;
+    }
+    nodes.reserve(num_points);
+    build(indices, 0, num_points);
+}
+
+float VPTree::distance(const float *a, size_t point) const {
+    const float *b = points + point * dim;
+    float sum = 0.0f;
+    for (size_t i = 0; i < dim; i++) {
+        float d = a[i] - b[i];
+        sum += d * d;
+    }
+    return std::sqrt(sum);
+}
+
+/**
+ * Build the subtree of indices[begin, end). The middle point is the
+ * vantage point, and the median distance to it splits the others.
+ *
+ * @return The index of the root node, or -1 for an empty range.
+ */
+int32_t VPTree::build(vector<uint32_t> &indices, size_t begin, size_t end) {
+    if (begin == end) {
+        return -1;
+    }
+    std::swap(indices[begin], indices[begin + (end - begin) / 2]);
+    int32_t node = nodes.size();
+    nodes.push_back({indices[begin], 0.0f, -1, -1});
+    if (end - begin == 1) {
+        return node;
+    }
+
+    const float *vantage = points + indices[begin] * dim;
+    size_t median = begin + 1 + (end - begin - 1) / 2;
+    std::nth_element(indices.begin() + begin + 1, indices.begin() + median,
+        indices.begin() + end, [&](uint32_t a, uint32_t b) {
+            return distance(vantage, a) < distance(vantage, b);
+        });
+    nodes[node].radius = distance(vantage, indices[median]);
+    int32_t inside = build(indices, begin + 1, median);
+    int32_t outside = build(indices, median, end);
+    nodes[node].inside = inside;
+    nodes[node].outside = outside;
+    return node;
+}
+
+vector<float> VPTree::nearest(const float *query, size_t k, size_t skip) const {
+    // Max-heap of the k best distances so far
+    std::priority_queue<float> best;
+    float tau = INFINITY;
+    vector<int32_t> stack;
+    if (!nodes.empty() && k > 0) {
+        stack.push_back(0);
+    }
+    while (!stack.empty()) {
+        const Node &node = nodes[stack.back()];
+        stack.pop_back();
+        float d = distance(query, node.point);
+        if (node.point != skip && d < tau) {
+            best.push(d);
+            if (best.size() > k) {
+                best.pop();
+            }
+            if (best.size() == k) {
+                tau = best.top();
+            }
+        }
+
+        // Search the side of the query first, and the other side only
+        // if the ball of radius tau crosses the boundary
+        if (d < node.radius) {
+            if (node.outside >= 0 && d + tau >= node.radius) {
+                stack.push_back(node.outside);
+            }
+            if (node.inside >= 0) {
+                stack.push_back(node.inside);
+            }
+        } else {
+            if (node.inside >= 0 && d - tau <= node.radius) {
+                stack.push_back(node.inside);
+            }
+            if (node.outside >= 0) {
+                stack.push_back(node.outside);
+            }
+        }
+    }
+
+    vector<float> distances(best.size());
+    for (size_t i = distances.size(); i-- > 0;) {
+        distances[i] = best.top();
+        best.pop();
+    }
+    return distances;
+}
+
+NoveltyArchive::NoveltyArchive(size_t dim, size_t k) : _dim(dim), k(k) {}
+
+/**
+ * Compute the novelty of the behaviours of a generation. They are
+ * indexed together with the archive, so each query is a tree search
+ * rather than a scan of every other behaviour.
+ *
+ * @param behaviours The behaviours, dim() floats each.
+ * @return The novelty of each behaviour.
+ */
+vector<float> NoveltyArchive::novelty(const vector<float> &behaviours) const {
+    if (behaviours.size() % _dim != 0) {
+        throw std::invalid_argument("Behaviours are not a multiple of the dimension");
+    }
+    const size_t num_behaviours = behaviours.size() / _dim;
+    const size_t num_archived = size();
+    vector<float> points = archive;
+    points.insert(points.end(), behaviours.begin(), behaviours.end());
+    VPTree tree(points.data(), num_archived + num_behaviours, _dim);
+
+    vector<float> result(num_behaviours, 0.0f);
+    for (size_t i = 0; i < num_behaviours; i++) {
+        vector<float> distances = tree.nearest(&behaviours[i * _dim], k, num_archived + i);
+        for (float d : distances) {
+            result[i] += d;
+        }
+        if (!distances.empty()) {
+            result[i] /= distances.size();
+        }
+    }
+    return result;
+}
+
+void NoveltyArchive::add(const float *behaviour) {
+    archive.insert(archive.end(), behaviour, behaviour + _dim);
+}
+
+size_t NoveltyArchive::size() const {
+    return archive.size() / _dim;
+}
+
+size_t NoveltyArchive::dim() const {
+    return _dim;
+}
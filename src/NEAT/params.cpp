@@ -0,0 +1,225 @@
+// params.cpp
+
+#include "NEAT/params.hpp"
+#include <variant>
+#include <limits>
+#include <stdexcept>
+
+using std::invalid_argument;
+
+using Field = std::variant<
+    int NeatParams::*,
+    double NeatParams::*,
+    bool NeatParams::*,
+    uint64_t NeatParams::*,
+    Activation NeatParams::*,
+    MigrationTopology NeatParams::*,
+    SelectionMethod NeatParams::*,
+    EvaluationMethod NeatParams::*>;
+
+// Declaration of a config key: where it lives, which member it sets
+// and the range its value must be in
+struct ParamSpec {
+    const char *section;
+    const char *key;
+    Field field;
+    double min;
+    double max;
+};
+
+static constexpr double INF = std::numeric_limits<double>::infinity();
+static constexpr double INT_LIMIT = std::numeric_limits<int>::max();
+
+static const ParamSpec SCHEMA[] = {
+    {"NEAT", "population_size", &NeatParams::population_size, 1, INT_LIMIT},
+    {"NEAT", "max_generations", &NeatParams::max_generations, 0, INT_LIMIT},
+    {"NEAT", "survival_threshold", &NeatParams::survival_threshold, 0, 1},
+    {"NEAT", "seed", &NeatParams::seed, 0, INF},
+    {"NEAT", "deduplicate_evaluations", &NeatParams::deduplicate_evaluations, 0, 1},
+    {"NEAT", "selection", &NeatParams::selection,
+        (double) SelectionMethod::UNIFORM, (double) SelectionMethod::TOURNAMENT},
+    {"NEAT", "tournament_size", &NeatParams::tournament_size, 1, INT_LIMIT},
+
+    {"DefaultGenome", "num_inputs", &NeatParams::num_inputs, 1, MaxNeuronId},
+    {"DefaultGenome", "num_outputs", &NeatParams::num_outputs, 1, MaxNeuronId},
+    {"DefaultGenome", "num_hidden", &NeatParams::num_hidden, 0, MaxNeuronId},
+
+    {"DefaultGenome", "bias_init_mean", &NeatParams::bias_init_mean, -INF, INF},
+    {"DefaultGenome", "bias_init_stddev", &NeatParams::bias_init_stddev, 0, INF},
+    {"DefaultGenome", "bias_max_value", &NeatParams::bias_max_value, -INF, INF},
+    {"DefaultGenome", "bias_min_value", &NeatParams::bias_min_value, -INF, INF},
+    {"DefaultGenome", "activation", &NeatParams::activation,
+        (double) Activation::LINEAR, (double) Activation::SOFTMAX},
+
+    {"DefaultGenome", "weight_init_mean", &NeatParams::weight_init_mean, -INF, INF},
+    {"DefaultGenome", "weight_init_stddev", &NeatParams::weight_init_stddev, 0, INF},
+    {"DefaultGenome", "weight_max_value", &NeatParams::weight_max_value, -INF, INF},
+    {"DefaultGenome", "weight_min_value", &NeatParams::weight_min_value, -INF, INF},
+
+    {"DefaultGenome", "neuron_add_prob", &NeatParams::neuron_add_prob, 0, 1},
+    {"DefaultGenome", "neuron_delete_prob", &NeatParams::neuron_delete_prob, 0, 1},
+    {"DefaultGenome", "link_add_prob", &NeatParams::link_add_prob, 0, 1},
+    {"DefaultGenome", "link_delete_prob", &NeatParams::link_delete_prob, 0, 1},
+
+    {"DefaultGenome", "mutation_rate", &NeatParams::mutation_rate, 0, 1},
+    {"DefaultGenome", "mutation_power", &NeatParams::mutation_power, 0, INF},
+    {"DefaultGenome", "replace_rate", &NeatParams::replace_rate, 0, 1},
+
+    {"Islands", "num_islands", &NeatParams::num_islands, 1, 64},
+    {"Islands", "migration_interval", &NeatParams::migration_interval, 1, INT_LIMIT},
+    {"Islands", "migration_size", &NeatParams::migration_size, 0, INT_LIMIT},
+    {"Islands", "migration_topology", &NeatParams::migration_topology,
+        (double) MigrationTopology::RING, (double) MigrationTopology::FULL},
+
+    {"Evaluation", "board_width", &NeatParams::board_width, 4, 1024},
+    {"Evaluation", "board_height", &NeatParams::board_height, 4, 1024},
+    {"Evaluation", "allow_teleport", &NeatParams::allow_teleport, 0, 1},
+    {"Evaluation", "episodes_per_genome", &NeatParams::episodes_per_genome, 1, INT_LIMIT},
+    {"Evaluation", "max_steps", &NeatParams::max_steps, 1, INT_LIMIT},
+    {"Evaluation", "hunger_steps", &NeatParams::hunger_steps, 1, INT_LIMIT},
+    {"Evaluation", "common_seeds", &NeatParams::common_seeds, 0, 1},
+    {"Evaluation", "rotate_seeds", &NeatParams::rotate_seeds, 0, 1},
+    {"Evaluation", "evaluation_method", &NeatParams::evaluation_method,
+        (double) EvaluationMethod::LOCAL, (double) EvaluationMethod::NOVELTY},
+
+    {"Racing", "racing_min_episodes", &NeatParams::racing_min_episodes, 1, INT_LIMIT},
+    {"Racing", "racing_max_episodes", &NeatParams::racing_max_episodes, 1, INT_LIMIT},
+    {"Racing", "racing_z", &NeatParams::racing_z, 0, INF},
+
+    {"Staging", "screening_board_width", &NeatParams::screening_board_width, 4, 1024},
+    {"Staging", "screening_board_height", &NeatParams::screening_board_height, 4, 1024},
+    {"Staging", "screening_episodes", &NeatParams::screening_episodes, 1, INT_LIMIT},
+    {"Staging", "screening_max_steps", &NeatParams::screening_max_steps, 1, INT_LIMIT},
+    {"Staging", "screening_percentile", &NeatParams::screening_percentile, 0, 1},
+
+    {"Novelty", "novelty_weight", &NeatParams::novelty_weight, 0, INF},
+    {"Novelty", "novelty_k", &NeatParams::novelty_k, 1, INT_LIMIT},
+    {"Novelty", "novelty_grid", &NeatParams::novelty_grid, 1, 64},
+    {"Novelty", "novelty_archive_add", &NeatParams::novelty_archive_add, 0, INT_LIMIT},
+
+    {"Distributed", "master_port", &NeatParams::master_port, 0, 65535},
+    {"Distributed", "batch_size", &NeatParams::batch_size, 1, INT_LIMIT},
+    {"Distributed", "pipeline_depth", &NeatParams::pipeline_depth, 1, INT_LIMIT},
+};
+
+/**
+ * Find the declaration of a config key.
+ *
+ * @param section The section of the key.
+ * @param key The key.
+ * @return The declaration, or nullptr if the key is unknown.
+ */
+static const ParamSpec *find_spec(const string &section, const string &key) {
+    for (const auto &spec : SCHEMA) {
+        if (section == spec.section && key == spec.key) {
+            return &spec;
+        }
+    }
+    return nullptr;
+}
+
+static string describe(const ParamSpec &spec) {
+    return string("[") + spec.section + "] " + spec.key;
+}
+
+/**
+ * Parse a number, requiring the whole value to be consumed.
+ *
+ * @param spec The declaration of the key, for error messages.
+ * @param value The text of the value.
+ * @return The parsed number.
+ */
+static double parse_number(const ParamSpec &spec, const string &value) {
+    size_t end = 0;
+    double number;
+    try {
+        number = std::stod(value, &end);
+    } catch (const std::exception &) {
+        end = 0;
+    }
+    if (end == 0 || end != value.size()) {
+        throw invalid_argument(describe(spec) + ": not a number: " + value);
+    }
+    if (number < spec.min || number > spec.max) {
+        throw invalid_argument(describe(spec) + ": out of range: " + value);
+    }
+    return number;
+}
+
+/**
+ * Parse a value and store it in the member declared by the schema.
+ *
+ * @param params The parameters to set.
+ * @param spec The declaration of the key.
+ * @param value The text of the value.
+ */
+static void set_field(NeatParams &params, const ParamSpec &spec, const string &value) {
+    if (auto field = std::get_if<bool NeatParams::*>(&spec.field)) {
+        if (value == "1" || value == "true") {
+            params.**field = true;
+        } else if (value == "0" || value == "false") {
+            params.**field = false;
+        } else {
+            throw invalid_argument(describe(spec) + ": not a boolean: " + value);
+        }
+    } else if (auto field = std::get_if<uint64_t NeatParams::*>(&spec.field)) {
+        // Parsed on its own, a double cannot hold every 64-bit seed
+        size_t end = 0;
+        try {
+            params.**field = std::stoull(value, &end);
+        } catch (const std::exception &) {
+            end = 0;
+        }
+        if (end == 0 || end != value.size() || value[0] == '-') {
+            throw invalid_argument(describe(spec) + ": not an unsigned integer: " + value);
+        }
+    } else {
+        double number = parse_number(spec, value);
+        if (auto field = std::get_if<double NeatParams::*>(&spec.field)) {
+            params.**field = number;
+        } else {
+            if (number != (int) number) {
+                throw invalid_argument(describe(spec) + ": not an integer: " + value);
+            }
+            if (auto field = std::get_if<int NeatParams::*>(&spec.field)) {
+                params.**field = (int) number;
+            } else if (auto field = std::get_if<Activation NeatParams::*>(&spec.field)) {
+                params.**field = (Activation) number;
+            } else if (auto field = std::get_if<MigrationTopology NeatParams::*>(&spec.field)) {
+                params.**field = (MigrationTopology) number;
+            } else if (auto field = std::get_if<EvaluationMethod NeatParams::*>(&spec.field)) {
+                params.**field = (EvaluationMethod) number;
+            } else {
+                params.*std::get<SelectionMethod NeatParams::*>(spec.field)
+                    = (SelectionMethod) number;
+            }
+        }
+    }
+}
+
+NeatParams::NeatParams(const Config &config) {
+    for (const auto &section : config.getSettings()) {
+        for (const auto &setting : section.second) {
+            const ParamSpec *spec = find_spec(section.first, setting.first);
+            if (spec == nullptr) {
+                throw invalid_argument(
+                    "Unknown config key: [" + section.first + "] " + setting.first);
+            }
+            set_field(*this, *spec, setting.second);
+        }
+    }
+
+    // Checks across keys
+    if (bias_min_value > bias_max_value) {
+        throw invalid_argument("bias_min_value is greater than bias_max_value");
+    }
+    if (weight_min_value > weight_max_value) {
+        throw invalid_argument("weight_min_value is greater than weight_max_value");
+    }
+    if (num_outputs + num_hidden > MaxNeuronId + 1) {
+        throw invalid_argument("num_outputs and num_hidden need more neuron ids than there are");
+    }
+    if (survival_threshold <= 0) {
+        throw invalid_argument("survival_threshold must keep at least one genome");
+    }
+}
@@ -1,17 +1,43 @@
 // population.cp
 
 #include "NEAT/population.hpp"
+#include "NEAT/selection.hpp"
 #include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <unordered_map>
 
-Population::Population(Config &config, RNG &rng) : _config(config), _rng(rng) {
-    // Create the initial population
-    for (int i = 0; i < _config.population_size(); i++) {
-        Genome genome(indexer.next(), _config);
-        genome.config_new(_config);
+Population::Population(const NeatParams &params, RNG &rng) : _params(params), _rng(rng),
+    _genome_config(std::make_shared<const GenomeConfig>(_params)),
+    _survival_cutoff(std::make_shared<SurvivalCutoff>()) {
+    // Create the initial population. Each genome draws from its own
+    // stream, so the result does not depend on the order they are built in
+    uint64_t seed = _rng.next();
+    for (int i = 0; i < _params.population_size; i++) {
+        Genome genome(indexer.next(), _genome_config);
+        RNG genome_rng = RNG::stream(seed, i);
+        genome.config_new(genome_rng);
         _genomes.push_back(genome);
     }
 }
 
+Population::Population(const NeatParams &params, PopulationState state) :
+    _params(params), _rng(state.rng), indexer(state.next_genome_id),
+    _genome_config(state.best.genome_config()),
+    _survival_cutoff(std::make_shared<SurvivalCutoff>()),
+    best(std::move(state.best)), _genomes(std::move(state.genomes)),
+    _species(std::move(state.species)), _generation(state.generation) {}
+
+/**
+ * Copy the state of the run, see PopulationState.
+ * 
+ * @return The state.
+ */
+PopulationState Population::state() const {
+    return {_generation, _rng.state(), indexer.peek(), _genomes, _species, best};
+}
+
 /**
  * Run the genetic algorithm for a given number of generations.
  * 
@@ -29,6 +55,15 @@ Population::Population(Config &config, RNG &rng) : _config(config), _rng(rng) {
 //     }
 // }
 
+/**
+ * Replace the evaluated population by its offspring.
+ */
+void Population::next_generation() {
+    update_best();
+    _genomes = reproduce();
+    _generation++;
+}
+
 /**
  * Reproduce the next generation of genomes.
  * 
@@ -37,26 +72,154 @@ Population::Population(Config &config, RNG &rng) : _config(config), _rng(rng) {
 vector<Genome> Population::reproduce() {
     // Sort the genomes by fitness
     auto old_genomes = sort_by_fitness(_genomes);
-    int cutoff = std::ceil(
-        _config.survival_threshold() * old_genomes.size());
+    int cutoff = num_survivors();
 
     // Keep the top genomes
     vector<Genome> top_genomes(old_genomes.begin(), old_genomes.begin() + cutoff);
-    int spawn_size = _config.population_size();
+    vector<float> top_fitness;
+    for (const auto &genome : top_genomes) {
+        top_fitness.push_back(genome.fitness());
+    }
+    ParentSelector selector(top_fitness, _params);
+    int spawn_size = _params.population_size;
     
     // Create the new population as an empty vector
     vector<Genome> new_generation = {};
-    while (spawn_size-- >= 0) {
-        // Select two parents at random
-        const auto& p1 = _rng.choose_from(top_genomes);
-        const auto& p2 = _rng.choose_from(top_genomes);
-        Genome offspring = crossover(p1, p2, _config, indexer);
-        offspring.mutate(_config);
+    uint64_t seed = _rng.next();
+    for (int i = 0; spawn_size-- >= 0; i++) {
+        // Each offspring gets its own random stream
+        RNG rng = RNG::stream(seed, i);
+
+        // Select two parents among the survivors
+        const auto& p1 = top_genomes[selector.choose(rng)];
+        const auto& p2 = top_genomes[selector.choose(rng)];
+        Genome offspring = crossover(p1, p2, indexer, rng);
+        offspring.mutate(rng);
         new_generation.push_back(offspring);
     }
     return new_generation;
 }
 
+/**
+ * Get copies of the best evaluated genomes.
+ * 
+ * @param n The maximum number of genomes.
+ * @return The genomes, best first.
+ */
+vector<Genome> Population::top_genomes(size_t n) const {
+    vector<Genome> top;
+    for (const auto &genome : _genomes) {
+        if (genome.fitness() != FitnessNotCalculated) {
+            top.push_back(genome);
+        }
+    }
+    n = std::min(n, top.size());
+    std::partial_sort(top.begin(), top.begin() + n, top.end(),
+        [](const Genome &a, const Genome &b) {
+            return a.fitness() > b.fitness();
+        });
+    top.erase(top.begin() + n, top.end());
+    return top;
+}
+
+/**
+ * Add evaluated genomes from another population, each taking the place
+ * of the worst evaluated genome. They keep their fitness, and get new
+ * ids from this population.
+ * 
+ * @param migrants The genomes to add.
+ */
+void Population::immigrate(const vector<Genome> &migrants) {
+    for (const auto &migrant : migrants) {
+        size_t worst = worst_evaluated();
+        if (_genomes[worst].fitness() == FitnessNotCalculated
+            || migrant.fitness() <= _genomes[worst].fitness()) {
+            continue;
+        }
+        _genomes[worst] = migrant;
+        _genomes[worst].genome_id = indexer.next();
+        update_best(_genomes[worst]);
+    }
+}
+
+/**
+ * Find the genomes that are exact duplicates of each other.
+ * 
+ * @return The clusters of duplicates, as indices into the population.
+ * Genomes without duplicates are not reported.
+ */
+vector<vector<size_t>> Population::duplicate_clusters() const {
+    // Clusters with each full hash, since a hash can be shared by genomes
+    // that are not duplicates
+    std::unordered_map<uint64_t, vector<size_t>> by_hash;
+    vector<vector<size_t>> all;
+    for (size_t i = 0; i < _genomes.size(); i++) {
+        auto &candidates = by_hash[_genomes[i].full_hash()];
+        auto match = std::find_if(candidates.begin(), candidates.end(), [&](size_t cluster) {
+            return _genomes[all[cluster][0]].same_genes(_genomes[i]);
+        });
+        if (match == candidates.end()) {
+            candidates.push_back(all.size());
+            all.push_back({i});
+        } else {
+            all[*match].push_back(i);
+        }
+    }
+
+    vector<vector<size_t>> clusters;
+    for (auto &cluster : all) {
+        if (cluster.size() > 1) {
+            clusters.push_back(std::move(cluster));
+        }
+    }
+    return clusters;
+}
+
+/**
+ * Move every genome with the same genes as an earlier one to the back
+ * of the population, keeping the order of the others.
+ * 
+ * @param originals Set to the index of the genome each duplicate copies,
+ * in the order of the duplicates.
+ * @return Iterator to the first duplicate.
+ */
+vector<Genome>::iterator Population::move_duplicates_back(vector<size_t> &originals) {
+    // Indices into unique by full hash
+    std::unordered_map<uint64_t, vector<size_t>> by_hash;
+    vector<Genome> unique, duplicates;
+    originals.clear();
+    for (auto &genome : _genomes) {
+        auto &candidates = by_hash[genome.full_hash()];
+        auto match = std::find_if(candidates.begin(), candidates.end(),
+            [&](size_t i) { return unique[i].same_genes(genome); });
+        if (match == candidates.end()) {
+            candidates.push_back(unique.size());
+            unique.push_back(std::move(genome));
+        } else {
+            originals.push_back(*match);
+            duplicates.push_back(std::move(genome));
+        }
+    }
+
+    size_t num_unique = unique.size();
+    _genomes = std::move(unique);
+    std::move(duplicates.begin(), duplicates.end(), std::back_inserter(_genomes));
+    return _genomes.begin() + num_unique;
+}
+
+/**
+ * Give each duplicate the fitness of the evaluated genome it duplicates.
+ * 
+ * @param first_duplicate Iterator to the first duplicate.
+ * @param originals The genomes they duplicate, see move_duplicates_back.
+ */
+void Population::copy_fitness_to_duplicates(vector<Genome>::iterator first_duplicate,
+    const vector<size_t> &originals) {
+    for (size_t i = 0; i < originals.size(); i++) {
+        (first_duplicate + i)->fitness() = _genomes[originals[i]].fitness();
+    }
+}
+
 /**
  * Update the best genome in the population.
  * 
@@ -64,10 +227,134 @@ vector<Genome> Population::reproduce() {
  */
 void Population::update_best() {
     for (const auto &genome : _genomes) {
-        if (genome.fitness() > best.fitness()) {
-            best = genome;
+        update_best(genome);
+    }
+}
+
+/**
+ * Update the best genome with a single genome.
+ * 
+ * @param genome The genome to compare with the best one.
+ */
+void Population::update_best(const Genome &genome) {
+    if (genome.fitness() > best.fitness()) {
+        best = genome;
+    }
+}
+
+/**
+ * Find the top evaluated genomes, with the same survival threshold as
+ * reproduce(), and build the selector that draws parents among them.
+ * Used by steady-state evolution, under its lock.
+ * 
+ * @return The parent pool.
+ */
+Population::ParentPool Population::parent_pool() const {
+    vector<size_t> evaluated;
+    for (size_t i = 0; i < _genomes.size(); i++) {
+        if (_genomes[i].fitness() != FitnessNotCalculated) {
+            evaluated.push_back(i);
+        }
+    }
+
+    // Only the top of the population has to be ordered
+    size_t cutoff = std::max<size_t>(1, std::ceil(
+        _params.survival_threshold * evaluated.size()));
+    std::nth_element(evaluated.begin(), evaluated.begin() + (cutoff - 1),
+        evaluated.end(), [this](size_t a, size_t b) {
+            return _genomes[a].fitness() > _genomes[b].fitness();
+        });
+    evaluated.resize(cutoff);
+
+    vector<float> top_fitness;
+    for (size_t i : evaluated) {
+        top_fitness.push_back(_genomes[i].fitness());
+    }
+    float lowest = *std::min_element(top_fitness.begin(), top_fitness.end());
+    ParentSelector selector(top_fitness, _params);
+    return {std::move(evaluated), std::move(selector), lowest};
+}
+
+/**
+ * Number of genomes that survive truncation selection.
+ */
+size_t Population::num_survivors() const {
+    return std::max<size_t>(1, std::ceil(_params.survival_threshold * _genomes.size()));
+}
+
+/**
+ * Publish the fitness of the last genome that would be chosen as a
+ * parent, once every genome of the population is evaluated. Until then
+ * the cutoff could still drop, so there is none. Used by steady-state
+ * evolution, under its lock.
+ * 
+ * @param evaluated The evaluated genomes of the population.
+ */
+void Population::publish_survival_cutoff(const EvaluatedIndex &evaluated) {
+    if (evaluated.size() < _genomes.size()) {
+        _survival_cutoff->publish(FitnessNotCalculated);
+        return;
+    }
+    _survival_cutoff->publish(evaluated.cutoff());
+}
+
+/**
+ * Add an evaluated genome. It joins the survivors, and pushes the lowest
+ * of them down to the rest once there are too many.
+ * 
+ * @param fitness The fitness of the genome.
+ * @param index Its index in the population.
+ */
+void Population::EvaluatedIndex::add(float fitness, size_t index) {
+    survivors.emplace(fitness, index);
+    if (survivors.size() > num_survivors) {
+        rest.insert(rest.end(), *survivors.begin());
+        survivors.erase(survivors.begin());
+    }
+}
+
+/**
+ * Remove an evaluated genome. A survivor is replaced by the highest of
+ * the rest.
+ * 
+ * @param fitness The fitness the genome was added with.
+ * @param index Its index in the population.
+ */
+void Population::EvaluatedIndex::remove(float fitness, size_t index) {
+    if (survivors.erase({fitness, index}) == 0) {
+        rest.erase({fitness, index});
+    } else if (!rest.empty()) {
+        survivors.insert(survivors.begin(), *std::prev(rest.end()));
+        rest.erase(std::prev(rest.end()));
+    }
+}
+
+/**
+ * Find the evaluated genome with the lowest fitness. Ties go to the
+ * lowest index, as in worst_evaluated().
+ * 
+ * @return Its index in the population.
+ */
+size_t Population::EvaluatedIndex::worst() const {
+    return rest.empty() ? survivors.begin()->second : rest.begin()->second;
+}
+
+/**
+ * Find the evaluated genome with the lowest fitness.
+ * 
+ * @return Its index in the population.
+ */
+size_t Population::worst_evaluated() const {
+    size_t worst = 0;
+    float worst_fitness = std::numeric_limits<float>::max();
+    for (size_t i = 0; i < _genomes.size(); i++) {
+        float fitness = _genomes[i].fitness();
+        if (fitness != FitnessNotCalculated && fitness < worst_fitness) {
+            worst = i;
+            worst_fitness = fitness;
         }
     }
+    return worst;
 }
 
 /**
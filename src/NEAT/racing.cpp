@@ -0,0 +1,116 @@
+// racing.cpp
+
+#include "NEAT/racing.hpp"
+
+/**
+ * Start a race.
+ *
+ * @param num_genomes The number of genomes, all contenders at first.
+ * @param num_survivors The number of genomes kept by selection.
+ * @param z The half width of the confidence intervals, in standard errors.
+ */
+Race::Race(size_t num_genomes, size_t num_survivors, double z) :
+    samples(num_genomes), eliminated_in(num_genomes, 0), num_survivors(num_survivors), z(z) {
+    for (size_t genome = 0; genome < num_genomes; genome++) {
+        _contenders.push_back(genome);
+    }
+}
+
+const vector<size_t> &Race::contenders() const {
+    return _contenders;
+}
+
+void Race::record(size_t genome, double fitness) {
+    samples[genome].sum += fitness;
+    samples[genome].sum_squares += fitness * fitness;
+    samples[genome].count++;
+}
+
+double Race::mean(size_t genome) const {
+    const Samples &s = samples[genome];
+    return s.count == 0 ? 0.0 : s.sum / s.count;
+}
+
+int Race::episodes(size_t genome) const {
+    return samples[genome].count;
+}
+
+/**
+ * Half width of the confidence interval of the mean of a genome.
+ *
+ * @param genome The genome.
+ * @return z standard errors, infinite with fewer than two samples.
+ */
+double Race::half_width(size_t genome) const {
+    const Samples &s = samples[genome];
+    if (s.count < 2) {
+        return INFINITY;
+    }
+    double mean = s.sum / s.count;
+    double variance = std::max(0.0,
+        (s.sum_squares - s.count * mean * mean) / (s.count - 1));
+    return z * std::sqrt(variance / s.count);
+}
+
+/**
+ * Eliminate the contenders whose upper bound is below the
+ * num_survivors-th highest lower bound. At least num_survivors
+ * contenders always remain.
+ *
+ * @return The number of eliminated contenders.
+ */
+size_t Race::eliminate() {
+    if (num_survivors == 0 || _contenders.size() <= num_survivors) {
+        return 0;
+    }
+
+    vector<double> lower;
+    for (size_t genome : _contenders) {
+        lower.push_back(mean(genome) - half_width(genome));
+    }
+    std::nth_element(lower.begin(), lower.begin() + (num_survivors - 1),
+        lower.end(), std::greater<double>());
+    double cutoff = lower[num_survivors - 1];
+
+    size_t before = _contenders.size();
+    rounds++;
+    _contenders.erase(std::remove_if(_contenders.begin(), _contenders.end(),
+        [&](size_t genome) {
+            if (mean(genome) + half_width(genome) < cutoff) {
+                eliminated_in[genome] = rounds;
+                return true;
+            }
+            return false;
+        }), _contenders.end());
+    return before - _contenders.size();
+}
+
+/**
+ * Fitness of each genome for selection: its mean, capped just below the
+ * lowest fitness of the genomes that outlasted it. Genomes are then
+ * ranked by the round they were eliminated in first, and by their mean
+ * within a round.
+ *
+ * @return The fitness of each genome.
+ */
+vector<float> Race::fitness() const {
+    vector<float> fitness(samples.size());
+    float floor = INFINITY;
+    for (size_t genome = 0; genome < samples.size(); genome++) {
+        fitness[genome] = mean(genome);
+        if (eliminated_in[genome] == 0) {
+            floor = std::min(floor, fitness[genome]);
+        }
+    }
+    // From the last round of eliminations back to the first
+    for (int round = rounds; round >= 1; round--) {
+        float cap = std::nextafter(floor, -INFINITY);
+        for (size_t genome = 0; genome < samples.size(); genome++) {
+            if (eliminated_in[genome] == round) {
+                fitness[genome] = std::min(fitness[genome], cap);
+                floor = std::min(floor, fitness[genome]);
+            }
+        }
+    }
+    return fitness;
+}
@@ -1,77 +1,345 @@
 // rng.cpp
 
 #include "rng.hpp"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
 
-RNG::RNG(unsigned seed) : gen(seed) {}
+// Samples are generated in blocks of this size, small enough to stay
+// on the stack and in L1, large enough for the loops to vectorise
+static constexpr size_t BLOCK_SIZE = 256;
+static constexpr float TWO_PI = 6.28318530717958647692f;
+
+/**
+ * splitmix64 step, used to expand seeds into generator states.
+ *
+ * @param x The state of the splitmix64 sequence, advanced in place.
+ * @return The next value of the sequence.
+ */
+static uint64_t splitmix64(uint64_t &x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+static uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// The kernels below are branch free and call no library functions, so
+// the loops of fill_gaussian() vectorise. The polynomials of the
+// logarithm and of sincos are those of Cephes, accurate to a few units
+// in the last place.
+
+/**
+ * Natural logarithm of a positive, normal float.
+ *
+ * @param x The value.
+ * @return Its logarithm.
+ */
+static inline float log_kernel(float x) {
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    // x = m * 2^e, with m in [0.5, 1)
+    int32_t exponent = (int32_t) (bits >> 23) - 126;
+    bits = (bits & 0x007fffffu) | 0x3f000000u;
+    // Below sqrt(1/2), m is doubled, so that m - 1 is around zero. Done
+    // on the bits, as arithmetic that might trap is not vectorised.
+    bool low = bits < 0x3f3504f3u;
+    exponent -= low;
+    bits += low ? 0x00800000u : 0u;
+    float m;
+    std::memcpy(&m, &bits, sizeof(m));
+    float e = (float) exponent;
+    float t = m - 1.0f;
+
+    float z = t * t;
+    float y = 7.0376836292e-2f;
+    y = y * t - 1.1514610310e-1f;
+    y = y * t + 1.1676998740e-1f;
+    y = y * t - 1.2420140846e-1f;
+    y = y * t + 1.4249322787e-1f;
+    y = y * t - 1.6668057665e-1f;
+    y = y * t + 2.0000714765e-1f;
+    y = y * t - 2.4999993993e-1f;
+    y = y * t + 3.3333331174e-1f;
+    y = y * t * z;
+    y += -2.12194440e-4f * e;
+    y += -0.5f * z;
+    return t + y + 0.693359375f * e;
+}
+
+/**
+ * Square root of a non-negative float. std::sqrt may set errno, which
+ * keeps loops that call it from vectorising.
+ *
+ * @param x The value.
+ * @return Its square root.
+ */
+static inline float sqrt_kernel(float x) {
+    // Reciprocal square root from the bits of x, refined by Newton's
+    // method to full precision
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    bits = 0x5f375a86u - (bits >> 1);
+    float y;
+    std::memcpy(&y, &bits, sizeof(y));
+    for (int i = 0; i < 3; i++) {
+        y = y * (1.5f - 0.5f * x * y * y);
+    }
+    return x * y;
+}
+
+/**
+ * Sine and cosine of 2 pi u.
+ *
+ * @param u The angle, in turns, in [0, 1).
+ * @param sin The sine, output.
+ * @param cos The cosine, output.
+ */
+static inline void sincos_kernel(float u, float &sin, float &cos) {
+    // Quarter turns, and what is left of the nearest one, in [-pi/4, pi/4]
+    float quarters = 4.0f * u;
+    int32_t q = (int32_t) (quarters + 0.5f);
+    float x = (quarters - (float) q) * (0.25f * TWO_PI);
+
+    float z = x * x;
+    float s = x + x * z * (-1.6666654611e-1f + z * (8.3321608736e-3f
+        + z * -1.9515295891e-4f));
+    float c = 1.0f - 0.5f * z + z * z * (4.166664568298827e-2f
+        + z * (-1.388731625493765e-3f + z * 2.443315711809948e-5f));
+    // Rotated by the quarter turns
+    bool swap = q & 1;
+    float sin_x = swap ? c : s, cos_x = swap ? s : c;
+    sin = (q & 2) ? -sin_x : sin_x;
+    cos = ((q + 1) & 2) ? -cos_x : cos_x;
+}
+
+RNG::RNG() : RNG(((uint64_t) std::random_device()() << 32) | std::random_device()()) {}
+
+RNG::RNG(uint64_t seed) : spare_gaussian(0.0), has_spare_gaussian(false) {
+    for (auto &word : s) {
+        word = splitmix64(seed);
+    }
+}
+
+RNG::RNG(const State &state) : spare_gaussian(state.spare_gaussian),
+    has_spare_gaussian(state.has_spare_gaussian) {
+    std::copy(state.s, state.s + 4, s);
+}
+
+/**
+ * State of the generator. A generator built from it makes the same
+ * draws as this one from now on.
+ *
+ * @return The state.
+ */
+RNG::State RNG::state() const {
+    State state;
+    std::copy(s, s + 4, state.s);
+    state.spare_gaussian = spare_gaussian;
+    state.has_spare_gaussian = has_spare_gaussian;
+    return state;
+}
+
+/**
+ * Derives an independent stream from a seed and a pair of ids.
+ * The same arguments always give the same stream, whatever thread
+ * or order it is created in.
+ *
+ * @param seed The master seed.
+ * @param id The stream id.
+ * @param sub_id The sub-stream id. DEFAULT 0.
+ * @return The generator of the stream.
+ */
+RNG RNG::stream(uint64_t seed, uint64_t id, uint64_t sub_id) {
+    uint64_t x = seed;
+    uint64_t key = splitmix64(x);
+    x = key ^ id;
+    key = splitmix64(x);
+    x = key ^ sub_id;
+    return RNG(splitmix64(x));
+}
+
+/**
+ * Jumps the generator 2^128 draws ahead, giving 2^128 non-overlapping
+ * sub-sequences of the current stream.
+ */
+void RNG::jump() {
+    static const uint64_t JUMP[] = {
+        0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull,
+        0xa9582618e03fc9aaull, 0x39abdc4529b1661cull };
+
+    uint64_t t[4] = {0, 0, 0, 0};
+    for (uint64_t jump : JUMP) {
+        for (int b = 0; b < 64; b++) {
+            if (jump & (uint64_t{1} << b)) {
+                for (int i = 0; i < 4; i++) {
+                    t[i] ^= s[i];
+                }
+            }
+            next();
+        }
+    }
+    for (int i = 0; i < 4; i++) {
+        s[i] = t[i];
+    }
+}
+
+/**
+ * Generates the next 64 random bits (xoshiro256++).
+ *
+ * @return A uniformly distributed 64-bit integer.
+ */
+uint64_t RNG::next() {
+    const uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+    const uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
 
 /**
  * Generates a random integer between min and max.
- * 
+ *
  * @param max The maximum value of the random integer.
  * @param min The minimum value of the random integer. DEFAULT 0.
  * @return A random integer between min and max.
  */
 int RNG::next_int(int max, int min) {
-    std::uniform_int_distribution<int> dist(min, max);
-    return dist(gen);
+    uint64_t range = (uint64_t) ((int64_t) max - min) + 1;
+    // Reject the values that would bias the modulo
+    uint64_t limit = UINT64_MAX - UINT64_MAX % range;
+    uint64_t x;
+    do {
+        x = next();
+    } while (x >= limit);
+    return (int) (min + (int64_t) (x % range));
 }
 
 /**
  * Generates a random double between min and max.
- * 
+ *
  * @param min The minimum value of the random double. DEFAULT 0.0.
  * @param max The maximum value of the random double. DEFAULT 1.0.
  * @return A random double between min and max.
  */
 double RNG::uniform(double min, double max) {
-    std::uniform_real_distribution<double> dist(min, max);
-    return dist(gen);
+    // 53 random bits give every double in [0, 1) with the same spacing
+    return min + (max - min) * ((next() >> 11) * 0x1.0p-53);
 }
 
 /**
  * Generates a random double from a Gaussian distribution.
- * 
+ *
  * @param mean The mean of the Gaussian distribution.
  * @param std The standard deviation of the Gaussian distribution.
  * @return A random double from a Gaussian distribution.
  */
 double RNG::gaussian(double mean, double std) {
-    std::normal_distribution<double> dist(mean, std);
-    return dist(gen);
+    if (has_spare_gaussian) {
+        has_spare_gaussian = false;
+        return mean + std * spare_gaussian;
+    }
+
+    // Box-Muller, keeping the second value for the next call
+    double u1 = 1.0 - uniform();
+    double u2 = uniform();
+    double r = std::sqrt(-2.0 * std::log(u1));
+    spare_gaussian = r * std::sin(2.0 * M_PI * u2);
+    has_spare_gaussian = true;
+    return mean + std * r * std::cos(2.0 * M_PI * u2);
 }
 
 /**
- * Chooses between two values based on a probability.
+ * Fills an array with uniform floats between min and max.
+ * Each 64-bit draw gives two floats of 24 random bits.
  * 
- * @param p The probability of choosing a.
- * @param a The first value.
- * @param b The second value.
- * @return a if the random number is less than p, b otherwise.
+ * @param out The array to fill.
+ * @param n The number of values.
+ * @param min The minimum value. DEFAULT 0.0.
+ * @param max The maximum value. DEFAULT 1.0.
  */
-// template <typename T>
-// T RNG::choose(double p, const T& a, const T& b) {
-//     std::bernoulli_distribution dist(p);
-//     return dist(gen) ? a : b;
-// }
+void RNG::fill_uniform(float *out, size_t n, float min, float max) {
+    uint64_t bits[BLOCK_SIZE / 2];
+    const float scale = (max - min) * 0x1.0p-24f;
+    for (size_t start = 0; start < n; start += BLOCK_SIZE) {
+        size_t count = std::min(BLOCK_SIZE, n - start);
+        size_t words = (count + 1) / 2;
+        for (size_t i = 0; i < words; i++) {
+            bits[i] = next();
+        }
+        // Conversion loop, free of dependencies between iterations
+        float *block = out + start;
+        for (size_t i = 0; i < count / 2; i++) {
+            block[2 * i] = min + scale * (float) (bits[i] >> 40);
+            block[2 * i + 1] = min + scale * (float) ((bits[i] >> 8) & 0xffffff);
+        }
+        if (count % 2) {
+            block[count - 1] = min + scale * (float) (bits[words - 1] >> 40);
+        }
+    }
+}
 
 /**
- * Chooses a random element from a vector.
+ * Fills an array with Gaussian floats, using both values of each
+ * Box-Muller pair. The uniform draws of a block are made first, then
+ * transformed together by vectorised kernels.
  * 
- * @param vec The vector to choose from.
- * @return A reference to a random element in the vector.
+ * @param out The array to fill.
+ * @param n The number of values.
+ * @param mean The mean of the distribution. DEFAULT 0.0.
+ * @param std The standard deviation of the distribution. DEFAULT 1.0.
  */
-// template <typename T>
-// T& RNG::choose_from(vector<T> &vec) {
-//     return vec[next_int(vec.size() - 1)];
-// }
+void RNG::fill_gaussian(float *out, size_t n, float mean, float std) {
+    float u1[BLOCK_SIZE / 2], u2[BLOCK_SIZE / 2];
+    for (size_t start = 0; start < n; start += BLOCK_SIZE) {
+        size_t count = std::min(BLOCK_SIZE, n - start);
+        size_t pairs = (count + 1) / 2;
+        fill_uniform(u1, pairs);
+        fill_uniform(u2, pairs);
+
+        float *block = out + start;
+        for (size_t i = 0; i < count / 2; i++) {
+            // 1 - u keeps the logarithm finite
+            float r = std * sqrt_kernel(-2.0f * log_kernel(1.0f - u1[i]));
+            float sin, cos;
+            sincos_kernel(u2[i], sin, cos);
+            block[2 * i] = mean + r * cos;
+            block[2 * i + 1] = mean + r * sin;
+        }
+        if (count % 2) {
+            float r = std * sqrt_kernel(-2.0f * log_kernel(1.0f - u1[pairs - 1]));
+            float sin, cos;
+            sincos_kernel(u2[pairs - 1], sin, cos);
+            block[count - 1] = mean + r * cos;
+        }
+    }
+}
 
 /**
- * Chooses a random iterator from a vector.
+ * Fills an array with 1 with probability p, and 0 otherwise.
  * 
- * @param vec The vector to choose from.
- * @return An iterator to a random element in the vector.
+ * @param out The array to fill.
+ * @param n The number of values.
+ * @param p The probability of a 1.
  */
-// template <typename T>
-// typename vector<T>::iterator RNG::choose_random(const vector<T> &vec) {
-//     return vec.begin() + next_int(vec.size() - 1);
-// }
\ No newline at end of file
+void RNG::fill_bernoulli_mask(uint8_t *out, size_t n, double p) {
+    // Compare 32-bit halves of each draw against a fixed threshold
+    uint64_t threshold = (uint64_t) (p * 4294967296.0);
+    for (size_t i = 0; i + 1 < n; i += 2) {
+        uint64_t x = next();
+        out[i] = (x >> 32) < threshold;
+        out[i + 1] = (x & 0xffffffffu) < threshold;
+    }
+    if (n % 2) {
+        out[n - 1] = (next() >> 32) < threshold;
+    }
+}
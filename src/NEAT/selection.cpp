@@ -0,0 +1,127 @@
+// selection.cpp
+
+#include "NEAT/selection.hpp"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+// Weight of the worst candidate in proportional selection, as a share of
+// the spread of fitness
+static constexpr double PROPORTIONAL_FLOOR = 0.01;
+
+/**
+ * Build the table. Columns with less than the mean weight are topped up
+ * by an alias from a column with more, so every column holds exactly
+ * the mean.
+ *
+ * @param weights The non-negative weights, not all zero.
+ */
+AliasTable::AliasTable(const vector<double> &weights) :
+    probability(weights.size()), alias(weights.size()) {
+    const size_t n = weights.size();
+    double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+    if (n == 0 || !(total > 0.0)) {
+        throw std::invalid_argument("Alias table needs a positive total weight");
+    }
+
+    vector<double> scaled(n);
+    vector<uint32_t> small, large;
+    for (size_t i = 0; i < n; i++) {
+        scaled[i] = weights[i] * n / total;
+        (scaled[i] < 1.0 ? small : large).push_back(i);
+    }
+    while (!small.empty() && !large.empty()) {
+        uint32_t less = small.back(), more = large.back();
+        small.pop_back();
+        probability[less] = scaled[less];
+        alias[less] = more;
+        scaled[more] -= 1.0 - scaled[less];
+        if (scaled[more] < 1.0) {
+            large.pop_back();
+            small.push_back(more);
+        }
+    }
+    // What is left is full, up to rounding
+    for (uint32_t i : large) {
+        probability[i] = 1.0;
+        alias[i] = i;
+    }
+    for (uint32_t i : small) {
+        probability[i] = 1.0;
+        alias[i] = i;
+    }
+}
+
+size_t AliasTable::sample(RNG &rng) const {
+    double u = rng.uniform() * probability.size();
+    size_t column = std::min<size_t>(u, probability.size() - 1);
+    return u - column < probability[column] ? column : alias[column];
+}
+
+size_t AliasTable::size() const {
+    return probability.size();
+}
+
+ParentSelector::ParentSelector(const vector<float> &fitness, const NeatParams &params) :
+    method(params.selection), tournament_size(params.tournament_size), fitness(fitness) {
+    if (fitness.empty()) {
+        throw std::invalid_argument("No candidates to select parents from");
+    }
+    const size_t n = fitness.size();
+    vector<double> weights(n);
+    if (method == SelectionMethod::PROPORTIONAL) {
+        // Fitness can be negative, so weights are the fitness above the
+        // worst candidate, plus a share of the spread so that it still
+        // gets a chance. Equal candidates all get the same.
+        auto range = std::minmax_element(fitness.begin(), fitness.end());
+        double lowest = *range.first;
+        double floor = PROPORTIONAL_FLOOR * ((double) *range.second - lowest);
+        for (size_t i = 0; i < n; i++) {
+            weights[i] = (double) fitness[i] - lowest + floor;
+        }
+        if (std::all_of(weights.begin(), weights.end(), [](double w) { return w == 0.0; })) {
+            std::fill(weights.begin(), weights.end(), 1.0);
+        }
+        table = AliasTable(weights);
+    } else if (method == SelectionMethod::RANK) {
+        // Linear ranking: the best has weight n, the worst 1, and ties
+        // share the mean weight of their ranks
+        vector<size_t> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(),
+            [&](size_t a, size_t b) { return fitness[a] < fitness[b]; });
+        for (size_t i = 0; i < n;) {
+            size_t j = i;
+            while (j < n && fitness[order[j]] == fitness[order[i]]) {
+                j++;
+            }
+            for (size_t k = i; k < j; k++) {
+                weights[order[k]] = (i + j + 1) / 2.0;
+            }
+            i = j;
+        }
+        table = AliasTable(weights);
+    }
+}
+
+size_t ParentSelector::choose(RNG &rng) const {
+    const int last = fitness.size() - 1;
+    switch (method) {
+        case SelectionMethod::PROPORTIONAL:
+        case SelectionMethod::RANK:
+            return table.sample(rng);
+        case SelectionMethod::TOURNAMENT: {
+            size_t best = rng.next_int(last);
+            for (int round = 1; round < tournament_size; round++) {
+                size_t contender = rng.next_int(last);
+                if (fitness[contender] > fitness[best]) {
+                    best = contender;
+                }
+            }
+            return best;
+        }
+        case SelectionMethod::UNIFORM:
+        default:
+            return rng.next_int(last);
+    }
+}
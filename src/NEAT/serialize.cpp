@@ -0,0 +1,161 @@
+// serialize.cpp
+
+#include "NEAT/serialize.hpp"
+#include <fstream>
+#include <iterator>
+
+static constexpr size_t HEADER_SIZE = 1 + 5 * 4;
+static constexpr size_t NEURON_SIZE = 4 + 4 + 1;
+static constexpr size_t LINK_SIZE = 4 + 4 + 4 + 1;
+
+/**
+ * Size of the encoding of a genome.
+ *
+ * @param genome The genome.
+ * @return The number of bytes encode_genome() appends for it.
+ */
+size_t encoded_size(const Genome &genome) {
+    size_t size = HEADER_SIZE;
+    for (const auto &neuron : genome.neurons()) {
+        size += neuron.is_removed() ? 0 : NEURON_SIZE;
+    }
+    for (const auto &link : genome.links()) {
+        size += link.is_removed() ? 0 : LINK_SIZE;
+    }
+    return size;
+}
+
+/**
+ * Encode a genome.
+ *
+ * @param genome The genome to encode.
+ * @param out The buffer the encoding is appended to.
+ */
+void encode_genome(const Genome &genome, vector<uint8_t> &out) {
+    const auto &neurons = genome.neurons();
+    const auto &links = genome.links();
+    uint32_t num_neurons = 0, num_links = 0;
+    for (const auto &neuron : neurons) {
+        num_neurons += !neuron.is_removed();
+    }
+    for (const auto &link : links) {
+        num_links += !link.is_removed();
+    }
+
+    out.reserve(out.size() + HEADER_SIZE
+        + num_neurons * NEURON_SIZE + num_links * LINK_SIZE);
+    put_value<uint8_t>(out, GenomeEncodingVersion);
+    put_value<int32_t>(out, genome.genome_id);
+    put_value<float>(out, genome.fitness());
+    put_value<int32_t>(out, genome.num_hidden());
+    put_value<uint32_t>(out, num_neurons);
+    put_value<uint32_t>(out, num_links);
+
+    for (const auto &neuron : neurons) {
+        if (neuron.is_removed()) {
+            continue;
+        }
+        put_value<int32_t>(out, neuron.neuron_id);
+        put_value<float>(out, neuron.bias);
+        put_value<uint8_t>(out, (uint8_t) neuron.activation);
+    }
+    for (size_t i = 0; i < links.size(); i++) {
+        if (links[i].is_removed()) {
+            continue;
+        }
+        put_value<int32_t>(out, links[i].link_id.input_id);
+        put_value<int32_t>(out, links[i].link_id.output_id);
+        put_value<float>(out, links[i].weight);
+        put_value<uint8_t>(out, genome.is_enabled(i));
+    }
+}
+
+/**
+ * Decode a genome.
+ *
+ * @param data The start of the encoding.
+ * @param size The number of bytes available from data.
+ * @param genome_config The shared config of the decoded genome.
+ * @param genome The genome to overwrite with the decoded one.
+ * @return The number of bytes used by the encoding.
+ */
+size_t decode_genome(const uint8_t *data, size_t size,
+    const shared_ptr<const GenomeConfig> &genome_config, Genome &genome) {
+    ByteReader reader(data, size);
+    if (reader.get<uint8_t>() != GenomeEncodingVersion) {
+        throw std::invalid_argument("Unknown genome encoding version");
+    }
+    genome = Genome(reader.get<int32_t>(), genome_config);
+    genome.fitness() = reader.get<float>();
+    genome.num_hidden() = reader.get<int32_t>();
+    uint32_t num_neurons = reader.get<uint32_t>();
+    uint32_t num_links = reader.get<uint32_t>();
+    if (num_neurons > size / NEURON_SIZE || num_links > size / LINK_SIZE) {
+        throw std::invalid_argument("Truncated genome encoding");
+    }
+
+    for (uint32_t i = 0; i < num_neurons; i++) {
+        NeuronGene neuron;
+        int32_t neuron_id = reader.get<int32_t>();
+        if (!fits_neuron_id(neuron_id)) {
+            throw std::invalid_argument("Neuron id out of range in genome encoding");
+        }
+        neuron.neuron_id = neuron_id;
+        neuron.bias = reader.get<float>();
+        uint8_t activation = reader.get<uint8_t>();
+        if (activation > (uint8_t) Activation::SOFTMAX) {
+            throw std::invalid_argument("Invalid activation in genome encoding");
+        }
+        neuron.activation = (Activation) activation;
+        genome.add_neuron(neuron);
+    }
+    for (uint32_t i = 0; i < num_links; i++) {
+        int32_t input_id = reader.get<int32_t>();
+        int32_t output_id = reader.get<int32_t>();
+        if (!fits_neuron_id(input_id) || !fits_neuron_id(output_id)) {
+            throw std::invalid_argument("Neuron id out of range in genome encoding");
+        }
+        LinkGene link;
+        link.link_id = {input_id, output_id};
+        link.weight = reader.get<float>();
+        genome.add_link(link, reader.get<uint8_t>() != 0);
+    }
+    return reader.position();
+}
+
+/**
+ * Save a genome to a file.
+ *
+ * @param path The file.
+ * @param genome The genome.
+ */
+void save_genome(const string &path, const Genome &genome) {
+    vector<uint8_t> bytes;
+    encode_genome(genome, bytes);
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+    if (!file) {
+        throw std::runtime_error("Could not write genome to " + path);
+    }
+}
+
+/**
+ * Load a genome saved by save_genome.
+ *
+ * @param path The file.
+ * @param genome_config The shared config of the loaded genome.
+ * @return The genome.
+ */
+Genome load_genome(const string &path, const shared_ptr<const GenomeConfig> &genome_config) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Could not read genome from " + path);
+    }
+    vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)),
+        std::istreambuf_iterator<char>());
+    Genome genome(-1, genome_config);
+    if (decode_genome(bytes.data(), bytes.size(), genome_config, genome) != bytes.size()) {
+        throw std::invalid_argument("Trailing data after genome in " + path);
+    }
+    return genome;
+}
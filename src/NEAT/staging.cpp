@@ -0,0 +1,57 @@
+// staging.cpp
+
+#include "NEAT/staging.hpp"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Decide which genomes pass screening.
+ *
+ * @param screening The screening fitness of each genome.
+ * @param params The parameters of the run.
+ * @return Whether each genome goes on to the full evaluation. Ties
+ * with the cutoff pass.
+ */
+vector<bool> screening_cutoff(const vector<float> &screening, const NeatParams &params) {
+    const size_t n = screening.size();
+    vector<bool> passed(n, true);
+    size_t num_survivors = std::ceil(params.survival_threshold * n);
+    size_t num_failed = std::min<size_t>(params.screening_percentile * n,
+        n - std::min(n, num_survivors));
+    if (num_failed == 0) {
+        return passed;
+    }
+
+    // Lowest fitness that passes
+    vector<float> sorted = screening;
+    std::nth_element(sorted.begin(), sorted.begin() + num_failed, sorted.end());
+    float cutoff = sorted[num_failed];
+    for (size_t genome = 0; genome < n; genome++) {
+        passed[genome] = screening[genome] >= cutoff;
+    }
+    return passed;
+}
+
+void rank_screened_out(vector<float> &fitness, const vector<float> &screening,
+    const vector<bool> &passed) {
+    float floor = 0.0f, best_screened_out = 0.0f;
+    bool any_passed = false, any_screened_out = false;
+    for (size_t genome = 0; genome < fitness.size(); genome++) {
+        if (passed[genome]) {
+            floor = any_passed ? std::min(floor, fitness[genome]) : fitness[genome];
+            any_passed = true;
+        } else {
+            best_screened_out = any_screened_out
+                ? std::max(best_screened_out, screening[genome]) : screening[genome];
+            any_screened_out = true;
+        }
+    }
+
+    // The best screened out genome lands one below the floor
+    float shift = any_passed ? floor - 1.0f - best_screened_out : 0.0f;
+    for (size_t genome = 0; genome < fitness.size(); genome++) {
+        if (!passed[genome]) {
+            fitness[genome] = screening[genome] + shift;
+        }
+    }
+}
@@ -0,0 +1,345 @@
+// stats.cpp
+
+#include "NEAT/stats.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+static constexpr char MAGIC[8] = {'N', 'E', 'A', 'T', 'S', 'T', 'A', 'T'};
+// How long the writer sleeps when there is nothing to write
+static constexpr std::chrono::milliseconds POLL_INTERVAL{20};
+
+/**
+ * Summarise a distribution.
+ *
+ * @param values The values, in any order.
+ * @return The summary.
+ */
+Distribution describe(vector<float> values) {
+    if (values.empty()) {
+        return {0, 0, 0, 0, 0, 0};
+    }
+    std::sort(values.begin(), values.end());
+    auto quantile = [&](double q) {
+        return values[(size_t) std::lround(q * (values.size() - 1))];
+    };
+    double sum = 0.0;
+    for (float value : values) {
+        sum += value;
+    }
+    return {values.front(), quantile(0.25), quantile(0.5), quantile(0.75),
+        values.back(), (float) (sum / values.size())};
+}
+
+/**
+ * Measure an evaluated generation.
+ *
+ * @param generation The number of the generation.
+ * @param genomes The genomes of the generation.
+ * @param results The results of its evaluations, e.g.
+ * SnakeFitness::results().
+ * @param evaluate_seconds The time the evaluations took.
+ * @return The stats of the generation.
+ */
+GenerationStats measure_generation(uint64_t generation, const vector<Genome> &genomes,
+    const vector<EvaluationResult> &results, double evaluate_seconds) {
+    vector<float> fitness, neurons, links, steps;
+    for (const auto &genome : genomes) {
+        if (genome.fitness() != FitnessNotCalculated) {
+            fitness.push_back(genome.fitness());
+        }
+        size_t num_neurons = 0, num_links = 0;
+        for (const auto &neuron : genome.neurons()) {
+            num_neurons += !neuron.is_removed();
+        }
+        for (const auto &link : genome.links()) {
+            num_links += !link.is_removed();
+        }
+        neurons.push_back(num_neurons);
+        links.push_back(num_links);
+    }
+    uint64_t num_aborted = 0;
+    for (const auto &result : results) {
+        if (result.aborted) {
+            num_aborted++;
+        } else {
+            steps.push_back(result.mean_steps);
+        }
+    }
+
+    GenerationStats stats{};
+    stats.generation = generation;
+    stats.num_genomes = genomes.size();
+    stats.num_evaluations = results.size();
+    stats.num_aborted = num_aborted;
+    stats.fitness = describe(std::move(fitness));
+    stats.neurons = describe(std::move(neurons));
+    stats.links = describe(std::move(links));
+    stats.episode_steps = describe(std::move(steps));
+    stats.evaluations_per_second = evaluate_seconds > 0.0
+        ? results.size() / evaluate_seconds : 0.0;
+    stats.evaluate_seconds = evaluate_seconds;
+    return stats;
+}
+
+double StatsColumn::value(const GenerationStats &stats) const {
+    const char *field = reinterpret_cast<const char *>(&stats) + offset;
+    switch (type) {
+        case ColumnType::U64: {
+            uint64_t value;
+            std::memcpy(&value, field, sizeof(value));
+            return value;
+        }
+        case ColumnType::F32: {
+            float value;
+            std::memcpy(&value, field, sizeof(value));
+            return value;
+        }
+        case ColumnType::F64:
+        default: {
+            double value;
+            std::memcpy(&value, field, sizeof(value));
+            return value;
+        }
+    }
+}
+
+static size_t column_size(ColumnType type) {
+    return type == ColumnType::F32 ? sizeof(float) : sizeof(uint64_t);
+}
+
+const vector<StatsColumn> &stats_columns() {
+    static const vector<StatsColumn> columns = []() {
+        vector<StatsColumn> columns = {
+            {"generation", ColumnType::U64, offsetof(GenerationStats, generation)},
+            {"num_genomes", ColumnType::U64, offsetof(GenerationStats, num_genomes)},
+            {"num_evaluations", ColumnType::U64, offsetof(GenerationStats, num_evaluations)},
+            {"num_aborted", ColumnType::U64, offsetof(GenerationStats, num_aborted)},
+        };
+        // Six columns per distribution
+        auto add_distribution = [&](const string &name, size_t offset) {
+            columns.push_back({name + "_min", ColumnType::F32, offset + offsetof(Distribution, min)});
+            columns.push_back({name + "_p25", ColumnType::F32, offset + offsetof(Distribution, p25)});
+            columns.push_back({name + "_median", ColumnType::F32,
+                offset + offsetof(Distribution, median)});
+            columns.push_back({name + "_p75", ColumnType::F32, offset + offsetof(Distribution, p75)});
+            columns.push_back({name + "_max", ColumnType::F32, offset + offsetof(Distribution, max)});
+            columns.push_back({name + "_mean", ColumnType::F32, offset + offsetof(Distribution, mean)});
+        };
+        add_distribution("fitness", offsetof(GenerationStats, fitness));
+        add_distribution("neurons", offsetof(GenerationStats, neurons));
+        add_distribution("links", offsetof(GenerationStats, links));
+        add_distribution("episode_steps", offsetof(GenerationStats, episode_steps));
+        columns.push_back({"evaluations_per_second", ColumnType::F64,
+            offsetof(GenerationStats, evaluations_per_second)});
+        columns.push_back({"evaluate_seconds", ColumnType::F64,
+            offsetof(GenerationStats, evaluate_seconds)});
+        columns.push_back({"reproduce_seconds", ColumnType::F64,
+            offsetof(GenerationStats, reproduce_seconds)});
+        columns.push_back({"save_seconds", ColumnType::F64,
+            offsetof(GenerationStats, save_seconds)});
+        return columns;
+    }();
+    return columns;
+}
+
+StatsLogger::StatsLogger(const string &csv_path, const string &binary_path) {
+    const auto &columns = stats_columns();
+    if (!csv_path.empty()) {
+        csv.open(csv_path);
+        if (!csv) {
+            throw std::runtime_error("Could not create " + csv_path);
+        }
+        csv.precision(9);
+        for (size_t i = 0; i < columns.size(); i++) {
+            csv << (i ? "," : "") << columns[i].name;
+        }
+        csv << '\n';
+        csv.flush();
+    }
+    if (!binary_path.empty()) {
+        binary.open(binary_path, std::ios::binary);
+        if (!binary) {
+            throw std::runtime_error("Could not create " + binary_path);
+        }
+        uint32_t version = StatsVersion, num_columns = columns.size();
+        binary.write(MAGIC, sizeof(MAGIC));
+        binary.write(reinterpret_cast<const char *>(&version), sizeof(version));
+        binary.write(reinterpret_cast<const char *>(&num_columns), sizeof(num_columns));
+        for (const auto &column : columns) {
+            uint8_t type = (uint8_t) column.type, length = column.name.size();
+            binary.put(type);
+            binary.put(length);
+            binary.write(column.name.data(), length);
+        }
+        binary.flush();
+    }
+    thread = std::thread([this]() { run(); });
+}
+
+StatsLogger::~StatsLogger() {
+    stopping.store(true, std::memory_order_release);
+    thread.join();
+}
+
+/**
+ * Queue the stats of a generation for writing.
+ *
+ * @param stats The stats.
+ * @return False if the queue was full, and the stats were dropped.
+ */
+bool StatsLogger::log(const GenerationStats &stats) {
+    if (!queue.try_push(stats)) {
+        _num_dropped++;
+        return false;
+    }
+    num_logged++;
+    return true;
+}
+
+void StatsLogger::flush() {
+    while (num_taken.load(std::memory_order_acquire) < num_logged) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void StatsLogger::run() {
+    vector<GenerationStats> rows;
+    rows.reserve(QUEUE_SIZE);
+    while (true) {
+        // Checked before draining, so whatever was logged before the
+        // logger stopped is written
+        bool stop = stopping.load(std::memory_order_acquire);
+        rows.clear();
+        GenerationStats stats;
+        while (queue.try_pop(stats)) {
+            rows.push_back(stats);
+        }
+        if (!rows.empty() && !failed) {
+            write(rows);
+        }
+        num_taken.fetch_add(rows.size(), std::memory_order_release);
+        if (stop) {
+            return;
+        }
+        if (rows.empty()) {
+            std::this_thread::sleep_for(POLL_INTERVAL);
+        }
+    }
+}
+
+// Writes the rows to both outputs, as one row group of the binary one
+void StatsLogger::write(const vector<GenerationStats> &rows) {
+    const auto &columns = stats_columns();
+    if (csv.is_open()) {
+        for (const auto &row : rows) {
+            for (size_t i = 0; i < columns.size(); i++) {
+                csv << (i ? "," : "") << columns[i].value(row);
+            }
+            csv << '\n';
+        }
+        csv.flush();
+    }
+    if (binary.is_open()) {
+        uint32_t num_rows = rows.size();
+        binary.write(reinterpret_cast<const char *>(&num_rows), sizeof(num_rows));
+        for (const auto &column : columns) {
+            size_t size = column_size(column.type);
+            for (const auto &row : rows) {
+                binary.write(reinterpret_cast<const char *>(&row) + column.offset, size);
+            }
+        }
+        binary.flush();
+    }
+    if ((csv.is_open() && !csv) || (binary.is_open() && !binary)) {
+        failed = true;
+    }
+}
+
+const vector<double> &StatsTable::column(const string &name) const {
+    auto it = std::find(names.begin(), names.end(), name);
+    if (it == names.end()) {
+        throw std::out_of_range("No column " + name);
+    }
+    return columns[it - names.begin()];
+}
+
+/**
+ * Read the columns of a binary stats file.
+ *
+ * @param path The file.
+ * @return The columns, as doubles.
+ */
+StatsTable read_stats(const string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Could not read stats from " + path);
+    }
+    vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)),
+        std::istreambuf_iterator<char>());
+    size_t at = 0;
+    auto take = [&](void *out, size_t size) {
+        if (bytes.size() - at < size) {
+            return false;
+        }
+        std::memcpy(out, bytes.data() + at, size);
+        at += size;
+        return true;
+    };
+
+    char magic[8];
+    uint32_t version = 0, num_columns = 0;
+    if (!take(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0
+        || !take(&version, sizeof(version)) || !take(&num_columns, sizeof(num_columns))) {
+        throw std::invalid_argument(path + " is not a stats file");
+    }
+    if (version != StatsVersion) {
+        throw std::invalid_argument(path + " has an unsupported stats version");
+    }
+    StatsTable table;
+    vector<ColumnType> types;
+    for (uint32_t i = 0; i < num_columns; i++) {
+        uint8_t type = 0, length = 0;
+        char name[256];
+        if (!take(&type, 1) || !take(&length, 1) || !take(name, length)
+            || type > (uint8_t) ColumnType::F64) {
+            throw std::invalid_argument(path + " has malformed columns");
+        }
+        types.push_back((ColumnType) type);
+        table.names.emplace_back(name, length);
+    }
+    table.columns.resize(num_columns);
+
+    size_t row_size = 0;
+    for (ColumnType type : types) {
+        row_size += column_size(type);
+    }
+    uint32_t num_rows;
+    while (take(&num_rows, sizeof(num_rows))) {
+        if (row_size * num_rows > bytes.size() - at) {
+            break;
+        }
+        for (uint32_t c = 0; c < num_columns; c++) {
+            for (uint32_t r = 0; r < num_rows; r++) {
+                if (types[c] == ColumnType::U64) {
+                    uint64_t value = 0;
+                    take(&value, sizeof(value));
+                    table.columns[c].push_back(value);
+                } else if (types[c] == ColumnType::F32) {
+                    float value = 0.0f;
+                    take(&value, sizeof(value));
+                    table.columns[c].push_back(value);
+                } else {
+                    double value = 0.0;
+                    take(&value, sizeof(value));
+                    table.columns[c].push_back(value);
+                }
+            }
+        }
+    }
+    return table;
+}
@@ -1,245 +1,565 @@
 #include <SFML/Graphics.hpp>
 #include "snakeEngine.hpp"
-#include "hsv_color.hpp"
+#include "gameRenderer.hpp"
 #include "controller.hpp"
 #include "ticker.hpp"
-#include <cassert>
+#include "tripleBuffer.hpp"
+#include "gameSnapshot.hpp"
+#include "replay.hpp"
+#include "populationWall.hpp"
+#include "wallRenderer.hpp"
+#include "snakeEvaluator.hpp"
+#include "NEAT/population.hpp"
+#include "NEAT/checkpoint.hpp"
+#include "NEAT/history.hpp"
+#include "NEAT/stats.hpp"
+#include "NEAT/island.hpp"
+#include "NEAT/distributed.hpp"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <thread>
 
 // Game configuration
 static int WIDTH = 30;
 static int HEIGHT = 30;
 static double FPS = 15.0;
+static double SPEED = 1.0;
 static bool ALLOW_TELEPORT = false;
 static bool SCORE = false;
 static int window_size = 800;
+static int WALL_FRAMES = 64;
+static std::string RECORD;
+static std::string GENOME = "best.genome";
+static std::string CHECKPOINT;
+static std::string HISTORY;
+static std::string STATS;
+static LookaheadParams SEARCH;
 
 // Function to parse command line arguments
 void init_options(int argc, char **argv);
 
-// Define the GameRendererConfig class
-class GameRendererConfig {
-    public:
-        GameRendererConfig() {}
-
-        sf::Vector2f grid_size;
-        sf::Vector2f grid_offset;
-        sf::Vector2f field_size;
-        sf::Vector2f field_offset;
-        sf::Color background_color;
-        sf::Color stroke_color;
-        sf::Color snake_color;
-        sf::Color food_color;
+// Frames drawn per second, however fast the game runs
+static const double RENDER_FPS = 60.0;
+
+// Commands from the window to the game
+struct SimulationControl {
+    std::atomic<bool> running{true};
+    std::atomic<bool> restart{false};
+    std::atomic<double> speed{1.0};
 };
 
-// Define the GameRenderer class
-class GameRenderer {
-    public:
-        GameRenderer(sf::RenderWindow &window, const SnakeEngine &engine,
-        GameRendererConfig config) : window(window), engine(engine), config() {
-            set_config();
-        }
+// Write the action log of a game to the -r file
+void save_recording(const ActionLog &log) {
+    std::ofstream file(RECORD);
+    write_action_log(file, log);
+    if (!file) {
+        printf("Could not write the recording to %s\n", RECORD.c_str());
+    }
+}
+
+/**
+ * Read the parameters of config.cfg, reporting a missing or invalid
+ * file rather than throwing.
+ *
+ * @param params The parameters, output.
+ * @return False if they could not be read.
+ */
+bool read_params(NeatParams &params) {
+    try {
+        params = NeatParams(Config("config.cfg"));
+    } catch (const std::exception &e) {
+        printf("%s\n", e.what());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Save the best genome of a run to the -g file, reporting a failure
+ * rather than throwing, as training threads cannot.
+ *
+ * @param genome The genome.
+ * @return False if it could not be written.
+ */
+bool save_best_genome(const Genome &genome) {
+    try {
+        save_genome(GENOME, genome);
+    } catch (const std::exception &e) {
+        printf("%s\n", e.what());
+        return false;
+    }
+    printf("Best genome saved to %s\n", GENOME.c_str());
+    return true;
+}
+
+/**
+ * Run games on their own thread, publishing a snapshot after each batch
+ * of steps, until control.running is cleared.
+ *
+ * @param controller Chooses the actions of the snake.
+ * @param control Commands from the window.
+ * @param snapshots Where the snapshots go.
+ */
+void simulate(Controller &controller, SimulationControl &control,
+    TripleBuffer<GameSnapshot> &snapshots) {
+    Ticker ticker{FPS, RENDER_FPS};
+    // Every game has its own seed, so its action log can play it again
+    ActionLog log{WIDTH, HEIGHT, ALLOW_TELEPORT, RNG{}.next(), {}};
+    SnakeEngine engine{log.width, log.height, log.allow_teleport, log.seed};
+    GameState state = GameState::Running;
+    uint64_t step = 0;
+    snapshots.write_buffer().capture(engine, state, step);
+    snapshots.publish();
 
-        // Set config values from window size and engine dimensions
-        void set_config() {
-            // Grid size is 80% of the window size, with a 10% offset 
-            // on each side
-            config.grid_size = {window.getSize().x * 0.8f, 
-                            window.getSize().y * 0.8f};
-            config.grid_offset = {window.getSize().x * 0.1f, 
-                            window.getSize().y * 0.1f};
-            // Field size is the grid size divided by the number of 
-            // rows and columns, minus the stroke width
-            config.field_size = {
-                config.grid_size.x / engine._width() - 2,
-                config.grid_size.y / engine._height() - 2
-            };
-            config.field_offset = {1, 1};
-            config.background_color = { 23, 23, 33 };
-            config.stroke_color = { 57, 57, 67 };
-            config.snake_color = { 228, 63, 63 };
-            config.food_color = { 72, 201, 176 };
+    while (control.running.load()) {
+        ticker.setSpeed(control.speed.load());
+        if (control.restart.exchange(false)) {
+            log = ActionLog{WIDTH, HEIGHT, ALLOW_TELEPORT, RNG{}.next(), {}};
+            engine = SnakeEngine{log.width, log.height, log.allow_teleport, log.seed};
+            state = GameState::Running;
+            step = 0;
         }
 
-        void draw() {
-            window.clear(config.background_color);
-            draw_grid();
-            draw_snake();
-            draw_food();
-            if (SCORE) {
-                draw_score();
+        // Sleep until the next frame, then catch up on the steps due
+        int steps = ticker.wait();
+        if (state != GameState::Running) {
+            continue;
+        }
+        for (int i = 0; i < steps && state == GameState::Running; i++) {
+            Action action = controller.get_action(engine);
+            if (!RECORD.empty()) {
+                log.actions.push_back(action);
             }
+            state = engine.process(action);
+            step++;
+        }
+        if (state != GameState::Running && !RECORD.empty()) {
+            save_recording(log);
         }
+        snapshots.write_buffer().capture(engine, state, step);
+        snapshots.publish();
+    }
+
+    // A game left before its end is recorded too
+    if (state == GameState::Running && !RECORD.empty()) {
+        save_recording(log);
+    }
+}
+
+// The fitness function of population mode, and the results of its last
+// evaluation, empty for methods that do not report them
+struct TrainingFitness {
+    std::function<void(vector<Genome>::iterator, vector<Genome>::iterator)> evaluate;
+    std::function<vector<EvaluationResult>()> results;
+};
+
+/**
+ * Create the fitness function of population mode, as chosen by
+ * evaluation_method in config.cfg.
+ *
+ * @param params The parameters of the run.
+ * @param population The population, whose survival cutoff local
+ * evaluations stop at, and whose generation is evaluated next.
+ * @param wall Where local evaluations show their games.
+ * @return The fitness function.
+ */
+TrainingFitness make_fitness(const NeatParams &params, const Population &population,
+    std::shared_ptr<PopulationWall> wall) {
+    if (params.evaluation_method == EvaluationMethod::DISTRIBUTED) {
+        auto fitness = std::make_shared<DistributedEvaluator>(params);
+        fitness->seek(population.generation());
+        printf("Waiting for workers on port %d\n", fitness->port());
+        return {[fitness](auto begin, auto end) { (*fitness)(begin, end); },
+            [fitness]() { return fitness->results(); }};
+    }
+    if (params.evaluation_method == EvaluationMethod::RACING) {
+        auto fitness = std::make_shared<SnakeRacingFitness>(params,
+            std::thread::hardware_concurrency());
+        fitness->seek(population.generation());
+        return {[fitness](auto begin, auto end) { (*fitness)(begin, end); },
+            []() { return vector<EvaluationResult>(); }};
+    }
+    if (params.evaluation_method == EvaluationMethod::STAGED) {
+        auto fitness = std::make_shared<SnakeStagedFitness>(params,
+            std::thread::hardware_concurrency());
+        fitness->seek(population.generation());
+        fitness->abort_below(population.survival_cutoff());
+        fitness->watch(std::move(wall));
+        return {[fitness](auto begin, auto end) { (*fitness)(begin, end); },
+            [fitness]() { return fitness->results(); }};
+    }
+    if (params.evaluation_method == EvaluationMethod::NOVELTY) {
+        auto fitness = std::make_shared<SnakeNoveltyFitness>(params,
+            std::thread::hardware_concurrency());
+        fitness->seek(population.generation());
+        return {[fitness](auto begin, auto end) { (*fitness)(begin, end); },
+            [fitness]() { return fitness->results(); }};
+    }
+    auto fitness = std::make_shared<SnakeFitness>(params, std::thread::hardware_concurrency());
+    fitness->seek(population.generation());
+    fitness->abort_below(population.survival_cutoff());
+    fitness->watch(std::move(wall));
+    return {[fitness](auto begin, auto end) { (*fitness)(begin, end); },
+        [fitness]() { return fitness->results(); }};
+}
 
-        void draw_grid() {
-            sf::RectangleShape stroke{};
-            stroke.setSize(config.grid_size);
-            stroke.setPosition(config.grid_offset);
-            stroke.setFillColor(config.stroke_color);
-            window.draw(stroke);
+/**
+ * Train a population with the parameters of config.cfg, showing the
+ * games of every genome of the current generation side by side, until
+ * the last generation or the window is closed.
+ *
+ * @param window The window to draw in.
+ * @return The exit code.
+ */
+int run_population(sf::RenderWindow &window) {
+    NeatParams params;
+    if (!read_params(params)) {
+        return -1;
+    }
+    auto wall = std::make_shared<PopulationWall>(params.population_size);
+    WallRenderer renderer{window, *wall, (size_t) WALL_FRAMES};
 
-            for (int i = 0; i < engine._height(); i++) {
-                for (int j = 0; j < engine._width(); j++) {
-                    draw_field({i, j}, config.background_color);
+    // Training runs on its own thread, with one evaluation thread per
+    // core feeding the wall, or with remote workers that leave it empty;
+    // the window never holds them up
+    std::atomic<bool> running{true};
+    std::thread training([&]() {
+        RNG rng(params.seed);
+        std::unique_ptr<Population> population;
+        if (!CHECKPOINT.empty() && std::ifstream(CHECKPOINT)) {
+            // A checkpoint that cannot be resumed is left alone, rather
+            // than overwritten by a new run
+            try {
+                Checkpoint checkpoint(CHECKPOINT);
+                population = std::make_unique<Population>(params,
+                    checkpoint.load(std::make_shared<const GenomeConfig>(params)));
+            } catch (const std::exception &e) {
+                printf("Could not resume from %s: %s\n", CHECKPOINT.c_str(), e.what());
+                return;
+            }
+            printf("Resumed from %s at generation %llu\n", CHECKPOINT.c_str(),
+                (unsigned long long) population->generation());
+        } else {
+            population = std::make_unique<Population>(params, rng);
+        }
+        TrainingFitness fitness;
+        try {
+            fitness = make_fitness(params, *population, wall);
+        } catch (const std::exception &e) {
+            printf("%s\n", e.what());
+            return;
+        }
+        // Checkpoints are written in the background, while the next
+        // generation is evaluated
+        std::unique_ptr<CheckpointWriter> checkpoints;
+        if (!CHECKPOINT.empty()) {
+            checkpoints = std::make_unique<CheckpointWriter>(CHECKPOINT);
+        }
+        std::unique_ptr<HistoryWriter> history;
+        if (!HISTORY.empty()) {
+            history = std::make_unique<HistoryWriter>(HISTORY, *population->genome_config());
+        }
+        // Stats are written on a thread of their own, so the disk never
+        // holds up training
+        std::unique_ptr<StatsLogger> stats_logger;
+        if (!STATS.empty()) {
+            try {
+                stats_logger = std::make_unique<StatsLogger>(STATS + ".csv", STATS + ".stats");
+            } catch (const std::exception &e) {
+                printf("%s\n", e.what());
+            }
+        }
+        using Clock = std::chrono::steady_clock;
+        auto seconds = [](Clock::time_point start) {
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        };
+        for (int generation = population->generation() + 1;
+            generation <= params.max_generations && running.load(); generation++) {
+            auto start = Clock::now();
+            try {
+                population->evaluate(fitness.evaluate);
+            } catch (const std::exception &e) {
+                printf("%s\n", e.what());
+                break;
+            }
+            GenerationStats stats = measure_generation(population->generation(),
+                population->genomes(), fitness.results(), seconds(start));
+            printf("Generation %d: best fitness %.2f\n", generation,
+                population->best_genome().fitness());
+            // A failed history or checkpoint is reported, and the run goes on
+            start = Clock::now();
+            try {
+                if (history) {
+                    history->append(population->generation(), population->genomes());
+                }
+            } catch (const std::exception &e) {
+                printf("%s\n", e.what());
+            }
+            stats.save_seconds = seconds(start);
+            start = Clock::now();
+            population->next_generation();
+            stats.reproduce_seconds = seconds(start);
+            start = Clock::now();
+            try {
+                if (checkpoints) {
+                    checkpoints->save(population->state());
                 }
+            } catch (const std::exception &e) {
+                printf("%s\n", e.what());
+            }
+            stats.save_seconds += seconds(start);
+            if (stats_logger) {
+                stats_logger->log(stats);
             }
         }
-
-        sf::Color luminance_wheel(sf::Color base, double position,
-                            double min = 0.5, double max = 0.75) {
-            auto hsv = HsvColor::from_rgb(base);
-            hsv.v = min + (max - min) * position;
-            assert(hsv.v >= 0.0 && hsv.v <= 1.0);
-            return hsv.to_rgb();
+        if (stats_logger && stats_logger->num_dropped() > 0) {
+            printf("Stats of %zu generations were dropped\n", stats_logger->num_dropped());
         }
-
-        sf::Color color_wheel(sf::Color base, double position) {
-            auto hsv = HsvColor::from_rgb(base);
-            hsv.h = fmod(hsv.h + 360 * position, 360);
-            return hsv.to_rgb();
+        if (stats_logger && !stats_logger->ok()) {
+            printf("Could not write the stats to %s\n", STATS.c_str());
         }
-
-        void draw_snake() {
-            const auto &snake = engine._snake();
-            for (int i = 0; i < snake.body.size(); i++) {
-                auto segment = snake.body[i];
-                double position = 1.0 - (double)i / (double)snake.body.size();
-                draw_field(segment, color_wheel(config.snake_color, position));
+        try {
+            if (checkpoints) {
+                checkpoints->wait();
             }
+        } catch (const std::exception &e) {
+            printf("%s\n", e.what());
         }
+        save_best_genome(population->best_genome());
+    });
 
-        void draw_food() {
-            draw_field(engine._food(), config.food_color);
+    while (window.isOpen()) {
+        sf::Event event{};
+        while (window.pollEvent(event)) {
+            if (event.type == sf::Event::Closed) {
+                window.close();
+            }
         }
+        renderer.draw();
+        window.display();
+    }
 
-        void draw_score() {
-            sf::Font font;
-            font.loadFromFile("assets/Arial.ttf");
-            sf::Text text;
-            text.setFont(font);
-            text.setString("Score: " + std::to_string(engine._score()));
-            text.setCharacterSize(24);
-            text.setFillColor(sf::Color::White);
-            text.setPosition(10, 10);
-            window.draw(text);
-        }
+    // The generation being evaluated is finished first
+    running = false;
+    training.join();
+    return 0;
+}
 
-        void draw_field(Coordinates c, sf::Color color) {
-            sf::RectangleShape shape{};
-            shape.setSize(config.field_size);
-            shape.setPosition(to_position(c));
-            shape.setFillColor(color);
-            window.draw(shape);
-        }
-            
-
-    private:
-        sf::RenderWindow &window;
-        const SnakeEngine &engine;
-        GameRendererConfig config;
-
-        sf::Vector2f to_position(Coordinates c) {
-            // Calculate the position of the field, such that
-            // the offset of the field is what makes the stroke
-            return {
-                config.grid_offset.x + c.col * (config.field_size.x + 2)
-                + config.field_offset.x,
-                config.grid_offset.y + c.row * (config.field_size.y + 2)
-                + config.field_offset.y
-            };
+/**
+ * Evolve a population with the parameters of config.cfg without
+ * generations: one worker per core evaluates offspring as they are born,
+ * each replacing the worst genome. Runs as many evaluations as
+ * max_generations generations would, then saves the best genome.
+ *
+ * @return The exit code.
+ */
+int run_steady() {
+    NeatParams params;
+    if (!read_params(params)) {
+        return -1;
+    }
+    RNG rng(params.seed);
+    Population population(params, rng);
+    auto cutoff = population.survival_cutoff();
+    // Episodes are drawn from one seed for the whole run, so with
+    // common_seeds every offspring plays the same ones
+    uint64_t seed = SeedSchedule(params).next();
+
+    size_t max_evaluations = (size_t) params.population_size * params.max_generations;
+    std::mutex progress;
+    size_t num_evaluations = 0;
+    float best_fitness = FitnessNotCalculated;
+    auto evaluate = [&](const Genome &genome) {
+        float fitness = evaluate_genome(genome, params,
+            SeedSchedule::genome_seed(seed, genome.genome_id, params), cutoff.get()).fitness;
+        std::lock_guard<std::mutex> lock(progress);
+        best_fitness = std::max(best_fitness, fitness);
+        if (++num_evaluations % params.population_size == 0) {
+            printf("Evaluation %zu: best fitness %.2f\n", num_evaluations, best_fitness);
         }
-};
+        return fitness;
+    };
+    population.run_steady_state(evaluate, max_evaluations);
+
+    return save_best_genome(population.best_genome()) ? 0 : -1;
+}
+
+/**
+ * Evolve params.num_islands populations with the parameters of
+ * config.cfg, one process each and without a window, their best genomes
+ * migrating every migration_interval generations. Saves the best genome
+ * of all islands.
+ *
+ * @return The exit code.
+ */
+int run_islands() {
+    NeatParams params;
+    if (!read_params(params)) {
+        return -1;
+    }
+    // The cores are split between the islands
+    unsigned num_threads = std::max(1u,
+        std::thread::hardware_concurrency() / (unsigned) params.num_islands);
+    try {
+        Genome best = run_island_processes(params, [&](int island, SharedRings &rings) {
+            RNG rng = RNG::stream(params.seed, island);
+            Population population(params, rng);
+            SnakeFitness fitness(params, num_threads);
+            fitness.abort_below(population.survival_cutoff());
+            for (int generation = 1; generation <= params.max_generations; generation++) {
+                population.evaluate(fitness);
+                if (generation % params.migration_interval == 0) {
+                    migrate(population, island, rings, params);
+                }
+                // The best genome is updated as the generation is replaced
+                population.next_generation();
+                printf("Island %d, generation %d: best fitness %.2f\n", island, generation,
+                    population.best_genome().fitness());
+            }
+            return population.best_genome();
+        });
+        printf("Best fitness of all islands %.2f\n", best.fitness());
+        return save_best_genome(best) ? 0 : -1;
+    } catch (const std::exception &e) {
+        printf("%s\n", e.what());
+        return -1;
+    }
+}
 
 int main(int argc, char **argv) {
     if (argc < 2) {
-        printf("Usage: ./NEAT_Snake <player|ai> [-options]\nUse -h for help\n");
+        printf("Usage: ./NEAT_Snake <player|ai|search|population|steady|islands> [-options]\n"
+            "Use -h for help\n");
         return -1;
     }
 
     // Get init options
     init_options(argc, argv);
+    SEARCH.board_width = WIDTH;
+    SEARCH.board_height = HEIGHT;
+
+    // Modes without a window
+    if (std::string(argv[1]) == "steady") {
+        return run_steady();
+    }
+    if (std::string(argv[1]) == "islands") {
+        return run_islands();
+    }
+
+    // A missing or unplayable genome is reported before the window opens
+    std::unique_ptr<Controller> controller;
+    if (std::string(argv[1]) != "population") {
+        try {
+            controller = make_controller(argv[1], GENOME, SEARCH);
+        } catch (const std::exception &e) {
+            printf("%s\n", e.what());
+            return -1;
+        }
+    }
 
     sf::RenderWindow window(
         sf::VideoMode(window_size, window_size), 
         "Snake Game");
+    window.setFramerateLimit(RENDER_FPS);
 
-    auto controller = make_controller(argv[1]);
-    Ticker ticker{FPS};
-    SnakeEngine engine{WIDTH, HEIGHT, ALLOW_TELEPORT};
-    GameRenderer renderer{window, engine, GameRendererConfig{}};
-    GameState state = GameState::Running;
+    if (std::string(argv[1]) == "population") {
+        return run_population(window);
+    }
+
+    GameRenderer renderer{window, WIDTH, HEIGHT, SCORE};
+
+    // The game runs on its own thread, and the window draws the latest
+    // snapshot it published, so neither waits for the other
+    SimulationControl control;
+    control.speed = SPEED;
+    TripleBuffer<GameSnapshot> snapshots;
+    std::thread simulation(simulate, std::ref(*controller), std::ref(control),
+        std::ref(snapshots));
 
     while (window.isOpen()) {
+        snapshots.update();
+        const GameSnapshot &game = snapshots.read_buffer();
         sf::Event event{};
 
         while (window.pollEvent(event)) {
             if (event.type == sf::Event::Closed) {
                 window.close();
+            } else if (event.type == sf::Event::KeyPressed
+                && game.state != GameState::Running) {
+                // When the game is over, 'r' restarts it and any other
+                // key closes the window
+                if (event.key.code == sf::Keyboard::R) {
+                    control.restart = true;
+                } else {
+                    window.close();
+                }
+            } else if (event.type == sf::Event::KeyPressed
+                && (event.key.code == sf::Keyboard::Add
+                    || event.key.code == sf::Keyboard::Equal)) {
+                control.speed = std::min(control.speed.load() * 2, Ticker::MAX_SPEED);
+            } else if (event.type == sf::Event::KeyPressed
+                && (event.key.code == sf::Keyboard::Subtract
+                    || event.key.code == sf::Keyboard::Hyphen)) {
+                control.speed = std::max(control.speed.load() / 2, Ticker::MIN_SPEED);
             } else {
                 controller->on_key_pressed(event);
             }
         }
-
-        if (ticker.tick()) {
-            state = engine.process(controller->get_action());
+        if (!window.isOpen()) {
+            break;
         }
 
-        if (state != GameState::Running) {
-            // If state is win, print a message on the window, and freeze the screen
-            sf::Font font;
-            font.loadFromFile("assets/Arial.ttf");
-            sf::Text text;
-            text.setFont(font);
-            if (state == GameState::GameOver) {
-                text.setString("Game Over!\nFinal Score: " 
-                    + std::to_string(engine._score()));
-            } else {
-                text.setString("You Win!\nFinal Score: " 
-                    + std::to_string(engine._score()));
-            }
-            text.setCharacterSize(24);
-            text.setFillColor(sf::Color::White);
-            text.setPosition(window.getSize().x * 0.5f, 
-                window.getSize().y * 0.5f);
-            window.draw(text);
-            window.display();
-            // Wait for the window to be closed, or for the user to press a key.
-            // If 'r' is pressed, restart the game
-            sf::Event event{};
-            while (window.waitEvent(event)) {
-                if (event.type == sf::Event::Closed) {
-                    window.close();
-                    return 0;
-                } else if (event.type == sf::Event::KeyPressed) {
-                    if (event.key.code == sf::Keyboard::R) {
-                        engine = SnakeEngine{WIDTH, HEIGHT, 
-                            ALLOW_TELEPORT};
-                        state = GameState::Running;
-                        break;
-                    } else {
-                        window.close();
-                        return 0;
-                    }
-                }
-            }
+        renderer.draw(game);
+        if (game.state == GameState::GameOver) {
+            renderer.draw_message("Game Over!\nFinal Score: "
+                + std::to_string(game.score));
+        } else if (game.state == GameState::Win) {
+            renderer.draw_message("You Win!\nFinal Score: "
+                + std::to_string(game.score));
         }
-
-        renderer.draw();
         window.display();
     }
+
+    control.running = false;
+    simulation.join();
+
+    if (const LatencyHistogram *latency = controller->latency_histogram()) {
+        printf("Action latency: %s\n", latency->summary().c_str());
+        printf("Budget per step at %.0f steps/s: %.1fus\n", FPS * Ticker::MAX_SPEED,
+            1e6 / (FPS * Ticker::MAX_SPEED));
+    }
     return 0;
 }
 
 void init_options(int argc, char **argv) {
     for (int i = 2; i < argc; i++) {
         if (std::string(argv[i]) == "-h") {
-            printf("Usage: ./NEAT_Snake <player|ai> [-options]\n");
+            printf("Usage: ./NEAT_Snake <player|ai|search|population|steady|islands> [-options]\n");
             printf("Options:\n");
             printf("  -x <width>    Set the width of the game board (default 30)\n");
             printf("  -y <height>   Set the height of the game board (default 30)\n");
             printf("  -f <fps>      Set the target frames per second (default 15)\n");
+            printf("  -m <speed>    Set the fast-forward multiplier, 1 to 1000 (default 1)\n");
+            printf("                +/- double or halve it while playing\n");
             printf("  -t            Allow the snake to teleport\n");
             printf("  -s <size>     Set the window size (default 800)\n");
             printf("  -z            Display the score always\n");
+            printf("  -w <tiles>    Set the tiles refreshed per frame in population mode (default 64)\n");
+            printf("  -r <file>     Record the actions of each game, for snake-render\n");
+            printf("  -g <file>     Set the genome played in ai and search modes and saved in\n");
+            printf("                population mode (default best.genome)\n");
+            printf("  -c <file>     Checkpoint population mode after each generation, and\n");
+            printf("                resume from the file if it exists\n");
+            printf("  -a <file>     Append every generation of population mode to a history,\n");
+            printf("                for neat-history\n");
+            printf("  -l <name>     Log the stats of each generation of population mode to\n");
+            printf("                <name>.csv and <name>.stats\n");
+            printf("  -d <depth>    Set the steps searched ahead in search mode (default 4)\n");
+            printf("  -k <actions>  Set the actions tried per searched step, 1 to 3 (default 3)\n");
+            printf("  -u <us>       Set the time budget of a search, in microseconds (default 2000)\n");
             printf("  -h            Display this help message\n");
             exit(0);
         } else if (std::string(argv[i]) == "-x") {
@@ -248,12 +568,32 @@ void init_options(int argc, char **argv) {
             HEIGHT = std::stoi(argv[++i]);
         } else if (std::string(argv[i]) == "-f") {
             FPS = std::stod(argv[++i]);
+        } else if (std::string(argv[i]) == "-m") {
+            SPEED = std::stod(argv[++i]);
         } else if (std::string(argv[i]) == "-t") {
             ALLOW_TELEPORT = true;
         } else if (std::string(argv[i]) == "-s") {
             window_size = std::stoi(argv[++i]);
         } else if (std::string(argv[i]) == "-z") {
             SCORE = true;
+        } else if (std::string(argv[i]) == "-w") {
+            WALL_FRAMES = std::stoi(argv[++i]);
+        } else if (std::string(argv[i]) == "-r") {
+            RECORD = argv[++i];
+        } else if (std::string(argv[i]) == "-g") {
+            GENOME = argv[++i];
+        } else if (std::string(argv[i]) == "-c") {
+            CHECKPOINT = argv[++i];
+        } else if (std::string(argv[i]) == "-a") {
+            HISTORY = argv[++i];
+        } else if (std::string(argv[i]) == "-l") {
+            STATS = argv[++i];
+        } else if (std::string(argv[i]) == "-d") {
+            SEARCH.depth = std::stoi(argv[++i]);
+        } else if (std::string(argv[i]) == "-k") {
+            SEARCH.beam_width = std::stoi(argv[++i]);
+        } else if (std::string(argv[i]) == "-u") {
+            SEARCH.time_budget = std::chrono::microseconds(std::stoi(argv[++i]));
         } else {
             printf("Unknown option: %s\n", argv[i]);
             exit(1);
@@ -0,0 +1,58 @@
+// neat_history.cpp
+
+#include "NEAT/history.hpp"
+#include "NEAT/serialize.hpp"
+#include <iostream>
+#include <string>
+
+// Looks back at the generations of a history written by population mode:
+// lists them, rebuilds one, or saves one of its genomes for ai mode
+int main(int argc, char **argv) {
+    if (argc != 2 && argc != 3 && argc != 5) {
+        std::cerr << "Usage: ./neat-history <history> [<index> [<genome id> <genome file>]]\n"
+                  << "Without an index, lists the generations of the history.\n"
+                  << "With one, lists the genomes of the index-th generation, and\n"
+                  << "with a genome id, saves that genome to a file for ai mode.\n";
+        return -1;
+    }
+
+    try {
+        HistoryReader reader(argv[1]);
+        if (argc == 2) {
+            std::cout << "index generation genomes keyframe bytes\n";
+            for (size_t i = 0; i < reader.num_generations(); i++) {
+                const auto &block = reader.block(i);
+                std::cout << i << " " << block.generation << " " << block.num_genomes << " "
+                          << (block.keyframe ? "yes" : "no") << " " << block.size << "\n";
+            }
+            return 0;
+        }
+
+        auto genome_config = std::make_shared<const GenomeConfig>(
+            NeatParams(Config("config.cfg")));
+        vector<Genome> genomes = reader.generation(std::stoul(argv[2]), genome_config);
+        if (argc == 3) {
+            std::cout << "genome parent fitness neurons links\n";
+            for (const auto &genome : genomes) {
+                std::cout << genome.genome_id << " " << genome.parent_id << " "
+                          << genome.fitness() << " " << genome.neurons().size() << " "
+                          << genome.links().size() << "\n";
+            }
+            return 0;
+        }
+
+        int genome_id = std::stoi(argv[3]);
+        for (const auto &genome : genomes) {
+            if (genome.genome_id == genome_id) {
+                save_genome(argv[4], genome);
+                std::cout << "Genome " << genome_id << " saved to " << argv[4] << std::endl;
+                return 0;
+            }
+        }
+        std::cerr << "No genome " << genome_id << " in generation " << argv[2] << std::endl;
+        return 1;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,20 @@
+// neat_worker.cpp
+
+#include "NEAT/distributed.hpp"
+#include "snakeEvaluator.hpp"
+#include <iostream>
+#include <string>
+
+// Evaluation worker: plays the snake episodes of the genomes a master
+// sends. Start one per core, on as many machines as needed.
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: ./neat-worker <master host> <master port>" << std::endl;
+        return -1;
+    }
+
+    return run_worker(argv[1], std::stoi(argv[2]),
+        [](const Genome &genome, const NeatParams &params, uint64_t seed) {
+            return evaluate_genome(genome, params, seed);
+        });
+}
@@ -0,0 +1,79 @@
+// snake_render.cpp
+
+#include "frameWriter.hpp"
+#include "replay.hpp"
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// Offscreen rendering of recorded games to PNG images or Y4M video, for
+// machines without a display
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: ./snake-render <recording> <output> [-options]\n"
+                  << "Output ending in .y4m is a video, anything else is the\n"
+                  << "start of the PNG file names, e.g. frames/snake_\n"
+                  << "Options:\n"
+                  << "  -s <size>     Set the image size (default 800)\n"
+                  << "  -f <fps>      Set the frame rate of the video (default 15)\n"
+                  << "  -j <threads>  Set the number of threads (default one per core)\n"
+                  << "  -a <frame>    Set the first frame (default 0)\n"
+                  << "  -b <frame>    Set the frame after the last (default the end)\n";
+        return -1;
+    }
+
+    int size = 800;
+    int fps = 15;
+    unsigned threads = std::thread::hardware_concurrency();
+    size_t first = 0;
+    size_t last = SIZE_MAX;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        if (option == "-s") {
+            size = std::stoi(argv[i + 1]);
+        } else if (option == "-f") {
+            fps = std::stoi(argv[i + 1]);
+        } else if (option == "-j") {
+            threads = std::stoi(argv[i + 1]);
+        } else if (option == "-a") {
+            first = std::stoul(argv[i + 1]);
+        } else if (option == "-b") {
+            last = std::stoul(argv[i + 1]);
+        } else {
+            std::cerr << "Unknown option: " << option << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        std::ifstream file(argv[1]);
+        if (!file) {
+            throw std::runtime_error(std::string("Could not open ") + argv[1]);
+        }
+        std::vector<GameSnapshot> states = read_replay_kind(file) == "snake-actions"
+            ? replay(read_action_log(file))
+            : read_states(file);
+        if (states.empty()) {
+            throw std::runtime_error("The recording has no frames");
+        }
+        last = std::min(last, states.size());
+
+        // Video frames need an even size
+        size += size % 2;
+        FrameRenderer renderer(size, size, states.front().width, states.front().height);
+        std::string output = argv[2];
+        bool video = output.size() >= 4 && output.compare(output.size() - 4, 4, ".y4m") == 0;
+        if (video) {
+            export_y4m(states, renderer, output, fps, first, last, threads);
+        } else {
+            export_png(states, renderer, output, first, last, threads);
+        }
+        std::cout << "Rendered " << (last > first ? last - first : 0) << " frames to "
+                  << output << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
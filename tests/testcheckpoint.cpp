@@ -0,0 +1,169 @@
+#include "NEAT/checkpoint.hpp"
+#include "testutil.hpp"
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <unistd.h>
+
+using std::cout, std::endl;
+
+static const string PATH = test_dir() + "/testcheckpoint.ckpt";
+static const string BAD_PATH = test_dir() + "/testcheckpoint_bad.ckpt";
+
+static void assert_same(const Genome &a, const Genome &b) {
+    assert(a.genome_id == b.genome_id);
+    assert(a.parent_id == b.parent_id && a.mate_id == b.mate_id);
+    assert(a.fitness() == b.fitness());
+    assert(a.num_hidden() == b.num_hidden());
+    assert(a.next_neuron_id() == b.next_neuron_id());
+    assert(a.full_hash() == b.full_hash());
+    assert(a.neurons().size() == b.neurons().size());
+    assert(a.links().size() == b.links().size());
+    for (size_t i = 0; i < a.links().size(); i++) {
+        assert(a.links()[i].link_id == b.links()[i].link_id);
+        assert(a.is_enabled(i) == b.is_enabled(i));
+    }
+}
+
+static NeatParams test_params() {
+    NeatParams params = snake_params();
+    params.population_size = 60;
+    // Enough removals for tombstones to matter
+    params.neuron_delete_prob = 0.3;
+    params.link_delete_prob = 0.3;
+    return params;
+}
+
+void testRoundTrip() {
+    cout << "Testing checkpoint round trip..." << endl;
+    NeatParams params = test_params();
+    RNG rng(params.seed);
+    Population population(params, rng);
+    population.run(weight_fitness, 4);
+    population.evaluate(weight_fitness);
+
+    PopulationState state = population.state();
+    vector<uint64_t> hashes;
+    for (const auto &genome : state.genomes) {
+        hashes.push_back(genome.full_hash());
+    }
+    // The population evolves on while the state waits to be written
+    population.next_generation();
+    population.run(weight_fitness, 2);
+    write_checkpoint(PATH, state);
+
+    Checkpoint checkpoint(PATH);
+    assert(checkpoint.generation() == 4);
+    assert(checkpoint.num_genomes() == state.genomes.size());
+    PopulationState loaded = checkpoint.load(population.genome_config(), 3);
+    assert(loaded.next_genome_id == state.next_genome_id);
+    assert(loaded.genomes.size() == state.genomes.size());
+    for (size_t i = 0; i < state.genomes.size(); i++) {
+        assert(state.genomes[i].full_hash() == hashes[i]);
+        assert_same(loaded.genomes[i], state.genomes[i]);
+    }
+    assert_same(loaded.best, state.best);
+    assert_same(checkpoint.genome(7, population.genome_config()), state.genomes[7]);
+    cout << "Checkpoint round trip passed!" << endl;
+}
+
+void testResume() {
+    cout << "Testing resumed runs..." << endl;
+    NeatParams params = test_params();
+    RNG rng(params.seed);
+    Population original(params, rng);
+    original.run(weight_fitness, 3);
+    write_checkpoint(PATH, original.state());
+    original.run(weight_fitness, 3);
+
+    Checkpoint checkpoint(PATH);
+    Population resumed(params, checkpoint.load(std::make_shared<const GenomeConfig>(params)));
+    assert(resumed.generation() == 3);
+    resumed.run(weight_fitness, 3);
+    assert(resumed.generation() == original.generation());
+    assert(resumed.genomes().size() == original.genomes().size());
+    for (size_t i = 0; i < original.genomes().size(); i++) {
+        assert_same(resumed.genomes()[i], original.genomes()[i]);
+    }
+    assert_same(resumed.best_genome(), original.best_genome());
+    cout << "Resumed runs passed!" << endl;
+}
+
+void testWriter() {
+    cout << "Testing background checkpoints..." << endl;
+    NeatParams params = test_params();
+    RNG rng(params.seed);
+    Population population(params, rng);
+    {
+        CheckpointWriter writer(PATH);
+        for (int i = 0; i < 5; i++) {
+            population.run(weight_fitness, 1);
+            writer.save(population.state());
+        }
+        writer.wait();
+        // Waiting checkpoints are replaced by newer ones
+        assert(writer.num_written() >= 1 && writer.num_written() <= 5);
+    }
+    assert(Checkpoint(PATH).generation() == 5);
+
+    CheckpointWriter failing("/nonexistent/testcheckpoint.ckpt");
+    failing.save(population.state());
+    bool failed = false;
+    try {
+        failing.wait();
+    } catch (const std::runtime_error &) {
+        failed = true;
+    }
+    assert(failed && failing.num_written() == 0);
+    cout << "Background checkpoints passed!" << endl;
+}
+
+void testMalformed() {
+    cout << "Testing malformed checkpoints..." << endl;
+    auto rejects = [](const string &path, bool missing) {
+        try {
+            Checkpoint checkpoint(path);
+        } catch (const std::invalid_argument &) {
+            return !missing;
+        } catch (const std::runtime_error &) {
+            return missing;
+        }
+        return false;
+    };
+    assert(rejects(test_dir() + "/testcheckpoint_missing.ckpt", true));
+
+    std::ifstream file(PATH, std::ios::binary);
+    string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::ofstream(BAD_PATH, std::ios::binary)
+        << bytes.substr(0, bytes.size() - 1);
+    assert(rejects(BAD_PATH, false));
+    std::ofstream(BAD_PATH, std::ios::binary)
+        << "snake-genome" << bytes.substr(12);
+    assert(rejects(BAD_PATH, false));
+
+    // Another network shape
+    NeatParams params = test_params();
+    params.num_inputs++;
+    Checkpoint checkpoint(PATH);
+    bool rejected = false;
+    try {
+        checkpoint.best(std::make_shared<const GenomeConfig>(params));
+    } catch (const std::invalid_argument &) {
+        rejected = true;
+    }
+    assert(rejected);
+    std::remove(PATH.c_str());
+    std::remove(BAD_PATH.c_str());
+    rmdir(test_dir().c_str());
+    cout << "Malformed checkpoints passed!" << endl;
+}
+
+int main() {
+    testRoundTrip();
+    testResume();
+    testWriter();
+    testMalformed();
+    return 0;
+}
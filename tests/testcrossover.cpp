@@ -1,29 +1,105 @@
 #include "NEAT/genome.hpp"
+#include "testutil.hpp"
+#include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <cassert>
 
 
 void testCrossover() {
-    Config config("config.cfg");
+    NeatParams params = snake_params();
+    RNG rng(params.seed);
     GenomeIndexer indexer;
-    Genome genome1(indexer.next(), config);
-    Genome genome2(indexer.next(), config);
+    Genome genome1(indexer.next(), params);
+    Genome genome2(indexer.next(), params);
 
-    genome1.config_new(config);
-    genome2.config_new(config);
+    genome1.config_new(rng);
+    genome2.config_new(rng);
 
     genome1.print();
     genome2.print();
 
-    Genome child = crossover(genome1, genome2, config, indexer);
+    Genome child = crossover(genome1, genome2, indexer, rng);
 
     child.print();
 
     cout << "Crossover tests passed!" << endl;
 }
 
+void testStructuralSharing() {
+    NeatParams params = snake_params();
+    RNG rng(params.seed);
+    GenomeIndexer indexer;
+    Genome parent(indexer.next(), params);
+    parent.config_new(rng);
+    parent.fitness() = 1.0f;
+
+    // Self crossover takes every gene from the same parent,
+    // so the child shares all of its chunks
+    Genome child = crossover(parent, parent, indexer, rng);
+    assert(child.neurons().shared_chunks() > 0);
+    assert(child.links().shared_chunks() > 0);
+    cout << "Parent footprint: " << parent.memory_footprint()
+         << " bytes, child footprint: " << child.memory_footprint()
+         << " bytes" << endl;
+
+    // Mutating the child never changes the parent
+    vector<float> weights;
+    for (const auto &link : parent.links()) {
+        weights.push_back(link.weight);
+    }
+    for (int i = 0; i < 10; i++) {
+        child.mutate(rng);
+    }
+    for (size_t i = 0; i < weights.size(); i++) {
+        assert(parent.links()[i].weight == weights[i]);
+    }
+
+    cout << "Structural sharing tests passed!" << endl;
+}
+
+void testCowVector() {
+    // Grows from an inline chunk to a table, element by element
+    CowVector<int, 4> a;
+    for (int i = 0; i < 23; i++) {
+        a.push_back(i);
+    }
+    assert(a.size() == 23);
+    for (int i = 0; i < 23; i++) {
+        assert(a[i] == i);
+    }
+    // Random access iterators, for the standard algorithms
+    auto found = std::lower_bound(a.begin(), a.end(), 17);
+    assert(found - a.begin() == 17 && *found == 17 && found[2] == 19);
+    assert(*std::prev(a.end()) == 22 && a.begin() < found);
+
+    // Copies share every chunk until one is written
+    CowVector<int, 4> b = a;
+    assert(a.shared_chunks() == 6 && b.shared_chunks() == 6);
+    b.mut(5) = -1;
+    b.push_back(23);
+    assert(a[5] == 5 && b[5] == -1 && b[23] == 23);
+    assert(a.size() == 23 && b.size() == 24);
+    assert(a.shared_chunks() == 4);
+
+    // Reserved room is allocated exactly, and kept inline while it fits
+    CowVector<int, 16> small;
+    small.reserve(7);
+    for (int i = 0; i < 7; i++) {
+        small.push_back(i);
+    }
+    assert(small.memory_footprint() == 8 + 7 * sizeof(int));
+    CowVector<int, 16> moved = std::move(small);
+    assert(small.empty() && moved.size() == 7 && moved[6] == 6);
+    moved = CowVector<int, 16>();
+    assert(moved.empty());
+    cout << "CowVector passed!" << endl;
+}
+
 int main() {
     testCrossover();
+    testStructuralSharing();
+    testCowVector();
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "NEAT/cutoff.hpp"
+#include "NEAT/population.hpp"
+#include "snakeEvaluator.hpp"
+#include "testutil.hpp"
+#include <iostream>
+#include <cassert>
+
+using std::cout, std::endl;
+
+void testReport() {
+    cout << "Testing survival cutoff reports..." << endl;
+    SurvivalCutoff cutoff;
+    cutoff.reset(3);
+    cutoff.report(1.0f);
+    cutoff.report(5.0f);
+    assert(cutoff.value() == FitnessNotCalculated);
+    cutoff.report(3.0f);
+    assert(cutoff.value() == 1.0f);
+    cutoff.report(0.5f);
+    assert(cutoff.value() == 1.0f);
+    cutoff.report(4.0f);
+    assert(cutoff.value() == 3.0f);
+    cutoff.reset(1);
+    assert(cutoff.value() == FitnessNotCalculated);
+    cutoff.publish(2.0f);
+    assert(cutoff.value() == 2.0f);
+    cout << "Survival cutoff reports passed!" << endl;
+}
+
+static vector<Genome> evolved_genomes(const NeatParams &params) {
+    RNG rng(params.seed);
+    Population population(params, rng);
+    population.run(SnakeFitness(params), 3);
+    return population.genomes();
+}
+
+void testUpperBound() {
+    cout << "Testing episode upper bounds..." << endl;
+    NeatParams params = snake_params();
+    params.population_size = 40;
+    params.max_steps = 1000;
+    for (const Genome &genome : evolved_genomes(params)) {
+        FeedForwardNetwork network(genome);
+        for (uint64_t seed = 0; seed < 3; seed++) {
+            float lowest = std::numeric_limits<float>::max();
+            EpisodeResult result = play_episode(network, params, seed,
+                [&](float bound) { lowest = std::min(lowest, bound); return false; });
+            assert(episode_fitness(result, params) <= lowest);
+            assert(lowest <= max_episode_fitness(params));
+        }
+    }
+    cout << "Episode upper bounds passed!" << endl;
+}
+
+void testEarlyAbort() {
+    cout << "Testing early abort..." << endl;
+    NeatParams params = snake_params();
+    params.population_size = 100;
+    params.max_steps = 2000;
+    vector<Genome> genomes = evolved_genomes(params);
+
+    SurvivalCutoff cutoff;
+    size_t num_survivors = std::ceil(params.survival_threshold * genomes.size());
+    cutoff.reset(num_survivors);
+    vector<float> full(genomes.size()), bounded(genomes.size());
+    double full_steps = 0.0, bounded_steps = 0.0;
+    size_t aborted = 0;
+    for (size_t i = 0; i < genomes.size(); i++) {
+        EvaluationResult result = evaluate_genome(genomes[i], params, i);
+        full[i] = result.fitness;
+        full_steps += result.mean_steps;
+
+        result = evaluate_genome(genomes[i], params, i, &cutoff);
+        bounded[i] = result.fitness;
+        bounded_steps += result.mean_steps;
+        if (result.aborted) {
+            aborted++;
+            // The measured fitness stays below the bound, which the
+            // full evaluation does not exceed, up to float rounding
+            assert(result.fitness <= result.upper_bound);
+            assert(full[i] <= result.upper_bound + 1e-5f);
+            assert(result.fitness < cutoff.value());
+        } else {
+            assert(bounded[i] == full[i]);
+            cutoff.report(result.fitness);
+        }
+    }
+
+    // Aborted genomes were all below the final cutoff
+    vector<float> sorted = full;
+    std::sort(sorted.begin(), sorted.end(), std::greater<float>());
+    assert(cutoff.value() == sorted[num_survivors - 1]);
+    for (size_t i = 0; i < genomes.size(); i++) {
+        if (bounded[i] != full[i]) {
+            assert(full[i] < cutoff.value());
+        }
+    }
+    cout << "Aborted " << aborted << " of " << genomes.size() << " evaluations, "
+         << bounded_steps / full_steps * 100 << "% of the steps" << endl;
+    assert(aborted > 0);
+    assert(bounded_steps < full_steps);
+
+    // Same wiring through a population
+    RNG rng(params.seed);
+    Population population(params, rng);
+    SnakeFitness fitness(params);
+    fitness.abort_below(population.survival_cutoff());
+    population.run(fitness, 3);
+    assert(fitness.num_aborted() > 0);
+    cout << "Early abort passed!" << endl;
+}
+
+void testSteadyStateCutoff() {
+    cout << "Testing steady-state cutoff..." << endl;
+    NeatParams params;
+    params.num_inputs = 2;
+    params.num_outputs = 1;
+    params.population_size = 20;
+    params.survival_threshold = 0.25;
+    RNG rng(params.seed);
+    Population population(params, rng);
+    std::atomic<int> next(0);
+    population.run_steady_state([&](const Genome &) { return (float) next++; }, 40, 1);
+
+    // The fifth best fitness of the population
+    vector<float> fitness;
+    for (const auto &genome : population.genomes()) {
+        fitness.push_back(genome.fitness());
+    }
+    std::sort(fitness.begin(), fitness.end(), std::greater<float>());
+    assert(population.survival_cutoff()->value() == fitness[4]);
+    cout << "Steady-state cutoff passed!" << endl;
+}
+
+int main() {
+    testReport();
+    testUpperBound();
+    testEarlyAbort();
+    testSteadyStateCutoff();
+    return 0;
+}
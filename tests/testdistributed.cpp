@@ -0,0 +1,75 @@
+#include "NEAT/distributed.hpp"
+#include "NEAT/population.hpp"
+#include "snakeEvaluator.hpp"
+#include "testutil.hpp"
+#include <iostream>
+#include <cassert>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using std::cout, std::endl;
+
+// Start a worker process, which evaluates at most max_evaluations genomes
+// before disconnecting
+pid_t start_worker(int port, int max_evaluations) {
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        int evaluations = 0;
+        auto evaluate = [&](const Genome &genome, const NeatParams &params, uint64_t seed) {
+            if (max_evaluations > 0 && evaluations++ >= max_evaluations) {
+                _exit(0);
+            }
+            return evaluate_genome(genome, params, seed);
+        };
+        _exit(run_worker("127.0.0.1", port, evaluate));
+    }
+    return pid;
+}
+
+void testDistributed() {
+    cout << "Testing distributed evaluation..." << endl;
+    NeatParams params = snake_params();
+    params.population_size = 40;
+    params.episodes_per_genome = 2;
+    params.master_port = 0;
+    params.batch_size = 3;
+
+    vector<pid_t> workers;
+    vector<Genome> genomes;
+    {
+        DistributedEvaluator evaluator(params);
+        workers.push_back(start_worker(evaluator.port(), 0));
+        workers.push_back(start_worker(evaluator.port(), 0));
+        // This one is lost during the first generation
+        workers.push_back(start_worker(evaluator.port(), 2));
+
+        RNG rng(params.seed);
+        Population population(params, rng);
+        population.evaluate(evaluator);
+        genomes = population.genomes();
+        population.next_generation();
+        population.run(evaluator, 2);
+    }
+
+    // Same seed, same results as a local evaluation
+    SnakeFitness local(params);
+    vector<Genome> local_genomes = genomes;
+    local(local_genomes.begin(), local_genomes.end());
+    for (size_t i = 0; i < genomes.size(); i++) {
+        assert(genomes[i].fitness() == local_genomes[i].fitness());
+    }
+
+    for (pid_t pid : workers) {
+        int status;
+        waitpid(pid, &status, 0);
+        assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+    cout << "Distributed evaluation passed!" << endl;
+}
+
+int main() {
+    testDistributed();
+
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include "NEAT/evaluation.hpp"
+#include <iostream>
+#include <cassert>
+
+using std::cout, std::endl;
+
+void testSeedSchedule() {
+    cout << "Testing seed schedules..." << endl;
+    NeatParams params;
+    params.seed = 11;
+    SeedSchedule rotating(params), same(params);
+    uint64_t first = rotating.next();
+    assert(same.next() == first);
+    assert(rotating.next() != first);
+    // Not the draws of the population, which uses the same seed
+    assert(first != RNG(params.seed).next());
+    // A resumed run plays the episodes of its generation
+    uint64_t third = rotating.next();
+    SeedSchedule resumed(params);
+    resumed.seek(2);
+    assert(resumed.next() == third);
+
+    params.rotate_seeds = false;
+    SeedSchedule fixed(params);
+    assert(fixed.next() == first);
+    assert(fixed.next() == first);
+
+    // Common seeds give every genome the seed of the generation
+    assert(SeedSchedule::genome_seed(first, 3, params) == first);
+    params.common_seeds = false;
+    uint64_t seed3 = SeedSchedule::genome_seed(first, 3, params);
+    assert(seed3 != first);
+    assert(seed3 != SeedSchedule::genome_seed(first, 4, params));
+    assert(SeedSchedule::episode_seed(seed3, 0) != SeedSchedule::episode_seed(seed3, 1));
+    cout << "Seed schedules passed!" << endl;
+}
+
+void testRankCorrelation() {
+    cout << "Testing rank correlation..." << endl;
+    vector<float> a = {1.0f, 2.0f, 3.0f, 4.0f};
+    vector<float> b = {10.0f, 20.0f, 30.0f, 40.0f};
+    vector<float> reversed = {4.0f, 3.0f, 2.0f, 1.0f};
+    vector<float> constant = {1.0f, 1.0f, 1.0f, 1.0f};
+    assert(rank_correlation(a, b) == 1.0);
+    assert(rank_correlation(a, reversed) == -1.0);
+    assert(rank_correlation(a, constant) == 0.0);
+    cout << "Rank correlation passed!" << endl;
+}
+
+// Fitness of a genome in an episode: its quality, plus the difficulty
+// of the episode, shared by every genome playing it, plus its own luck
+static float play(size_t genome, uint64_t episode_seed) {
+    RNG episode(episode_seed);
+    double difficulty = episode.gaussian(0.0, 2.0);
+    double luck = RNG::stream(episode_seed, genome).gaussian(0.0, 0.5);
+    return genome * 0.05 + difficulty + luck;
+}
+
+// Correlation between the rankings of two generations evaluating the
+// same genomes with different seeds
+static double ranking_stability(const NeatParams &params) {
+    const size_t num_genomes = 200;
+    SeedSchedule seeds(params);
+    vector<vector<float>> fitness(2, vector<float>(num_genomes));
+    for (auto &generation : fitness) {
+        uint64_t seed = seeds.next();
+        for (size_t genome = 0; genome < num_genomes; genome++) {
+            uint64_t genome_seed = SeedSchedule::genome_seed(seed, genome, params);
+            double sum = 0.0;
+            for (int e = 0; e < params.episodes_per_genome; e++) {
+                sum += play(genome, SeedSchedule::episode_seed(genome_seed, e));
+            }
+            generation[genome] = sum / params.episodes_per_genome;
+        }
+    }
+    return rank_correlation(fitness[0], fitness[1]);
+}
+
+void testCommonSeeds() {
+    cout << "Testing common random numbers..." << endl;
+    NeatParams params;
+    params.episodes_per_genome = 2;
+    double common = ranking_stability(params);
+    params.common_seeds = false;
+    params.episodes_per_genome = 8;
+    double independent = ranking_stability(params);
+    cout << "Rank correlation with 2 common episodes " << common
+         << ", with 8 independent episodes " << independent << endl;
+    // A quarter of the episodes ranks the genomes more consistently
+    assert(common > independent);
+    cout << "Common random numbers passed!" << endl;
+}
+
+int main() {
+    testSeedSchedule();
+    testRankCorrelation();
+    testCommonSeeds();
+    return 0;
+}
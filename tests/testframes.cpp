@@ -0,0 +1,174 @@
+#include "frameWriter.hpp"
+#include "replay.hpp"
+#include <iostream>
+#include <cassert>
+#include <fstream>
+#include <sstream>
+
+using std::cout, std::endl;
+
+static uint32_t get32(const vector<uint8_t> &bytes, size_t offset) {
+    return (uint32_t) bytes[offset] << 24 | bytes[offset + 1] << 16
+        | bytes[offset + 2] << 8 | bytes[offset + 3];
+}
+
+// A game of a few steps, as snapshots
+static vector<GameSnapshot> play_game(size_t steps) {
+    ActionLog log{12, 10, false, 5, {}};
+    for (size_t i = 0; i < steps; i++) {
+        log.actions.push_back(static_cast<Action>(i % 7 == 3 ? 1 : 0));
+    }
+    return replay(log);
+}
+
+void testLayout() {
+    cout << "Testing the frame layout..." << endl;
+    GameSnapshot game = play_game(4).back();
+    FrameRenderer renderer(240, 200, game.width, game.height);
+    Framebuffer frame = renderer.make_framebuffer();
+    renderer.draw(game, frame);
+
+    // Centre of a field, one of the stroke between fields
+    auto centre = [&](Coordinates c) {
+        auto position = renderer.to_position(c);
+        return frame.pixel(position[0] + 5, position[1] + 5);
+    };
+    assert(frame.pixel(0, 0) == Palette::BACKGROUND);
+    assert(frame.pixel(24, 20) == Palette::STROKE);
+    assert(centre(game.food) == Palette::FOOD);
+    // The head has the colour of the whole turn of the wheel
+    Rgb head = Palette::color_wheel(Palette::SNAKE, 1.0);
+    assert(centre(game.body.front()) == head);
+    assert(!(centre(game.body.back()) == head));
+    // A free field
+    for (int col = 0; col < game.width; col++) {
+        Coordinates c{0, col};
+        if (!(c == game.food) && std::find(game.body.begin(), game.body.end(), c)
+            == game.body.end()) {
+            assert(centre(c) == Palette::BACKGROUND);
+            break;
+        }
+    }
+    cout << "Frame layout passed!" << endl;
+}
+
+void testPng() {
+    cout << "Testing PNG encoding..." << endl;
+    Framebuffer frame(300, 100);
+    frame.clear(Palette::STROKE);
+    frame.fill_rect(10, 10, 50, 20, Palette::FOOD);
+    vector<uint8_t> png = encode_png(frame);
+
+    assert((vector<uint8_t>(png.begin(), png.begin() + 8)
+        == vector<uint8_t>{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'}));
+    // Walk the chunks, checking their CRCs, and inflate the stored blocks
+    vector<uint8_t> zlib;
+    size_t offset = 8;
+    std::string last;
+    while (offset < png.size()) {
+        uint32_t length = get32(png, offset);
+        std::string type(png.begin() + offset + 4, png.begin() + offset + 8);
+        assert(crc32(&png[offset + 4], length + 4) == get32(png, offset + 8 + length));
+        if (type == "IHDR") {
+            assert(get32(png, offset + 8) == 300 && get32(png, offset + 12) == 100);
+        } else if (type == "IDAT") {
+            zlib.insert(zlib.end(), png.begin() + offset + 8,
+                png.begin() + offset + 8 + length);
+        }
+        last = type;
+        offset += 12 + length;
+    }
+    assert(last == "IEND" && offset == png.size());
+
+    assert(zlib[0] == 0x78 && (zlib[0] * 256 + zlib[1]) % 31 == 0);
+    vector<uint8_t> raw;
+    size_t position = 2;
+    bool final_block = false;
+    while (!final_block) {
+        final_block = zlib[position] & 1;
+        size_t size = zlib[position + 1] | zlib[position + 2] << 8;
+        assert((size ^ (zlib[position + 3] | zlib[position + 4] << 8)) == 0xFFFF);
+        raw.insert(raw.end(), zlib.begin() + position + 5, zlib.begin() + position + 5 + size);
+        position += 5 + size;
+    }
+    assert(get32(zlib, position) == adler32(raw.data(), raw.size()));
+
+    assert(raw.size() == 100 * (1 + 300 * 3));
+    for (int row = 0; row < 100; row++) {
+        assert(raw[row * 901] == 0);
+        assert(std::equal(raw.begin() + row * 901 + 1, raw.begin() + (row + 1) * 901,
+            frame.pixels().begin() + row * 900));
+    }
+    cout << "PNG encoding passed!" << endl;
+}
+
+void testParallelVideo() {
+    cout << "Testing parallel Y4M export..." << endl;
+    vector<GameSnapshot> states = play_game(40);
+    FrameRenderer renderer(64, 64, states.front().width, states.front().height);
+    Y4mFormat format(64, 64, 15);
+
+    auto read = [](const std::string &path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), {});
+    };
+    export_y4m(states, renderer, "/tmp/testframes_1.y4m", 15, 0, states.size(), 1);
+    export_y4m(states, renderer, "/tmp/testframes_4.y4m", 15, 0, states.size(), 4);
+    std::string one = read("/tmp/testframes_1.y4m");
+    std::string four = read("/tmp/testframes_4.y4m");
+    assert(one == four);
+    assert(one.size() == format.frame_offset(states.size()));
+    assert(one.compare(0, 10, "YUV4MPEG2 ") == 0);
+    assert(one.compare(format.frame_offset(7), 6, "FRAME\n") == 0);
+
+    // A range of frames
+    export_y4m(states, renderer, "/tmp/testframes_4.y4m", 15, 10, 20, 3);
+    std::string range = read("/tmp/testframes_4.y4m");
+    assert(range.size() == format.frame_offset(10));
+    assert(range.compare(format.frame_offset(0), format.frame_size(),
+        one, format.frame_offset(10), format.frame_size()) == 0);
+    std::remove("/tmp/testframes_1.y4m");
+    std::remove("/tmp/testframes_4.y4m");
+    cout << "Parallel Y4M export passed!" << endl;
+}
+
+void testRecordings() {
+    cout << "Testing recordings..." << endl;
+    ActionLog log{12, 10, true, 9, {}};
+    for (int i = 0; i < 200; i++) {
+        log.actions.push_back(static_cast<Action>(i % 3));
+    }
+    std::stringstream actions;
+    write_action_log(actions, log);
+    assert(read_replay_kind(actions) == "snake-actions");
+    ActionLog read_log = read_action_log(actions);
+    assert(read_log.seed == 9 && read_log.allow_teleport && read_log.width == 12);
+    assert(read_log.actions == log.actions);
+
+    vector<GameSnapshot> states = replay(log);
+    std::stringstream snapshots;
+    write_states(snapshots, states);
+    assert(read_replay_kind(snapshots) == "snake-states");
+    vector<GameSnapshot> read = read_states(snapshots);
+    assert(read.size() == states.size());
+    for (size_t i = 0; i < states.size(); i++) {
+        assert(read[i].step == states[i].step && read[i].score == states[i].score);
+        assert(read[i].state == states[i].state && read[i].food == states[i].food);
+        assert(read[i].body == states[i].body);
+    }
+
+    std::stringstream junk("snake-genome 1");
+    try {
+        read_replay_kind(junk);
+        assert(false);
+    } catch (const std::runtime_error &) {}
+    cout << "Recordings passed!" << endl;
+}
+
+int main() {
+    testLayout();
+    testPng();
+    testParallelVideo();
+    testRecordings();
+    return 0;
+}
@@ -1,4 +1,6 @@
 #include "NEAT/genes.hpp"
+#include "NEAT/params.hpp"
+#include "testutil.hpp"
 #include <iostream>
 #include <cassert>
 
@@ -15,28 +17,38 @@ void testNeuronGene() {
 
 void testLinkGene() {
     cout << "Testing LinkGene..." << endl;
-    LinkGene link = {{0, 1}, 0.5, true};
+    LinkGene link = {{0, 1}, 0.5};
     assert(link.link_id.input_id == 0);
     assert(link.link_id.output_id == 1);
     assert(link.weight == 0.5);
-    assert(link.is_enabled == true);
+    assert(!link.is_removed());
     cout << "LinkGene passed!" << endl;
 }
 
+void testGeneLayout() {
+    cout << "Testing gene layout..." << endl;
+    assert(sizeof(NeuronGene) == 8);
+    assert(sizeof(LinkGene) == 8);
+    assert(sizeof(Activation) == 1);
+    cout << "Gene layout passed!" << endl;
+}
+
 void testNeuronMutator() {
     cout << "Testing NeuronMutator..." << endl;
-    Config config("config.cfg");
-    NeuronMutator mutator(config);
-    NeuronGene neuron = mutator.new_neuron();
+    NeatParams params = snake_params();
+    RNG rng(params.seed);
+    NeuronMutator mutator(params);
+    NeuronGene neuron = mutator.new_neuron(0, rng);
     assert(neuron.neuron_id == 0);
     cout << "NeuronMutator passed!" << endl;
 }
 
 void testLinkMutator() {
     cout << "Testing LinkMutator..." << endl;
-    Config config("config.cfg");
-    LinkMutator mutator(config);
-    LinkGene link = mutator.new_link(0, 1);
+    NeatParams params = snake_params();
+    RNG rng(params.seed);
+    LinkMutator mutator(params);
+    LinkGene link = mutator.new_link(0, 1, rng);
     assert(link.link_id.input_id == 0);
     assert(link.link_id.output_id == 1);
     cout << "LinkMutator passed!" << endl;
@@ -45,6 +57,7 @@ void testLinkMutator() {
 int main() {
     testNeuronGene();
     testLinkGene();
+    testGeneLayout();
     testNeuronMutator();
     testLinkMutator();
     cout << "All tests passed!" << endl;
@@ -1,4 +1,5 @@
 #include "NEAT/genome.hpp"
+#include "testutil.hpp"
 #include <iostream>
 #include <cassert>
 
@@ -6,10 +7,11 @@ using std::cout, std::endl;
 
 void testGenome() {
     cout << "Testing Genome..." << endl;
-    Config config("config.cfg");
-    Genome genome(0, config);
-    genome.config_new(config);
-    assert((
+    NeatParams params = snake_params();
+    RNG rng(params.seed);
+    Genome genome(0, params);
+    genome.config_new(rng);
+    assert((size_t) (
         genome.num_inputs() +
         genome.num_outputs() +
         genome.num_hidden()) == genome.neurons().size());
@@ -19,16 +21,94 @@ void testGenome() {
     assert(genome.find_neuron(100).has_value());
     cout << "Genome add_neuron passed!" << endl;
 
-    genome.add_link({{100, 0}, 0.5, true});
+    genome.add_link({{100, 0}, 0.5});
     assert(genome.find_link({100, 0}).has_value());
+    assert(genome.is_enabled(*genome.find_link_index({100, 0})));
     cout << "Genome add_link passed!" << endl;
 
+    size_t num_links = genome.links().size();
+    genome.remove_link(*genome.find_link_index({100, 0}));
+    assert(!genome.find_link({100, 0}).has_value());
+    assert(genome.links().size() == num_links);
+    cout << "Genome remove_link passed!" << endl;
+
     assert(genome.fitness() == FitnessNotCalculated);
     cout << "Genome fitness passed!" << endl;
+
+    // Once the 16-bit neuron ids run out, no neuron is added
+    genome.next_neuron_id() = MaxNeuronId + 1;
+    size_t num_neurons = genome.neurons().size();
+    genome.mutate_add_neuron(rng);
+    assert(genome.neurons().size() == num_neurons);
+    cout << "Genome neuron ids passed!" << endl;
+}
+
+void testGenomeFootprint() {
+    cout << "Testing Genome footprint..." << endl;
+    NeatParams params = snake_params();
+    RNG rng(params.seed);
+    GenomeIndexer indexer;
+    Genome genome1(indexer.next(), params);
+    Genome genome2(indexer.next(), genome1.genome_config());
+    genome1.config_new(rng);
+    genome2.config_new(rng);
+    Genome child = crossover(genome1, genome2, indexer, rng);
+
+    // Genomes share their config instead of embedding a copy
+    assert(child.genome_config() == genome1.genome_config());
+
+    cout << "sizeof(Genome): " << sizeof(Genome) << " bytes" << endl;
+    cout << "Genome footprint: " << genome1.memory_footprint()
+         << " bytes (" << genome1.neurons().size() << " neurons, "
+         << genome1.links().size() << " links)" << endl;
+    cout << "Offspring footprint: " << child.memory_footprint()
+         << " bytes" << endl;
+    cout << "Genome footprint passed!" << endl;
+}
+
+void testGenomeHash() {
+    cout << "Testing Genome hashes..." << endl;
+    NeatParams params = snake_params();
+    RNG rng(params.seed);
+    Genome genome(0, params);
+    genome.config_new(rng);
+
+    // Incremental hashes match a full recomputation after mutations
+    for (int i = 0; i < 20; i++) {
+        genome.mutate(rng);
+        uint64_t structure_hash = genome.structure_hash();
+        uint64_t full_hash = genome.full_hash();
+        genome.rehash();
+        assert(genome.structure_hash() == structure_hash);
+        assert(genome.full_hash() == full_hash);
+    }
+
+    // Hashes do not depend on the order genes were added in
+    Genome g1(1, genome.genome_config());
+    Genome g2(2, genome.genome_config());
+    g1.add_neuron({0, 0.5, Activation::SIGMOID});
+    g1.add_neuron({-1, 0.0, Activation::LINEAR});
+    g1.add_link({{-1, 0}, 0.25});
+    g2.add_link({{-1, 0}, 0.25});
+    g2.add_neuron({-1, 0.0, Activation::LINEAR});
+    g2.add_neuron({0, 0.5, Activation::SIGMOID});
+    assert(g1.full_hash() == g2.full_hash());
+
+    // Weights only change the full hash
+    g2.set_link(0, {{-1, 0}, 0.75});
+    assert(g1.structure_hash() == g2.structure_hash());
+    assert(g1.full_hash() != g2.full_hash());
+
+    // Enabled flags are part of the structure
+    g2.set_enabled(0, false);
+    assert(g1.structure_hash() != g2.structure_hash());
+    cout << "Genome hashes passed!" << endl;
 }
 
 int main() {
     testGenome();
+    testGenomeHash();
+    testGenomeFootprint();
     cout << "All tests passed!" << endl;
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "NEAT/history.hpp"
+#include "NEAT/range_coder.hpp"
+#include "NEAT/population.hpp"
+#include "NEAT/serialize.hpp"
+#include "testutil.hpp"
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <unistd.h>
+
+using std::cout, std::endl;
+
+static const string PATH = test_dir() + "/testhistory.hist";
+
+static size_t live_links(const Genome &genome) {
+    size_t count = 0;
+    for (const auto &link : genome.links()) {
+        count += !link.is_removed();
+    }
+    return count;
+}
+
+static void assert_same(const vector<Genome> &rebuilt, const vector<Genome> &written) {
+    assert(rebuilt.size() == written.size());
+    for (size_t i = 0; i < written.size(); i++) {
+        assert(rebuilt[i].genome_id == written[i].genome_id);
+        assert(rebuilt[i].parent_id == written[i].parent_id);
+        assert(rebuilt[i].mate_id == written[i].mate_id);
+        assert(rebuilt[i].fitness() == written[i].fitness());
+        assert(rebuilt[i].num_hidden() == written[i].num_hidden());
+        assert(rebuilt[i].full_hash() == written[i].full_hash());
+        assert(live_links(rebuilt[i]) == live_links(written[i]));
+    }
+}
+
+void testRangeCoder() {
+    cout << "Testing the range coder..." << endl;
+    RNG rng(5);
+    vector<uint8_t> bits, bytes;
+    vector<uint64_t> numbers;
+    for (int i = 0; i < 20000; i++) {
+        bits.push_back(rng.uniform() < 0.05);
+        bytes.push_back(rng.next_int(3) == 0 ? rng.next_int(255) : 0);
+        numbers.push_back(rng.next() >> rng.next_int(63));
+    }
+
+    vector<uint8_t> coded;
+    RangeEncoder<3> encoder(coded);
+    for (size_t i = 0; i < bits.size(); i++) {
+        encoder.put_bit(0, bits[i]);
+        encoder.put_byte(1, bytes[i]);
+        encoder.put_varint(2, numbers[i]);
+    }
+    encoder.finish();
+
+    RangeDecoder<3> decoder(coded.data(), coded.size());
+    for (size_t i = 0; i < bits.size(); i++) {
+        assert(decoder.get_bit(0) == bits[i]);
+        assert(decoder.get_byte(1) == bytes[i]);
+        assert(decoder.get_varint(2) == numbers[i]);
+    }
+
+    // Skewed bits cost a fraction of a bit each
+    vector<uint8_t> skewed;
+    RangeEncoder<1> bit_encoder(skewed);
+    for (uint8_t bit : bits) {
+        bit_encoder.put_bit(0, bit);
+    }
+    bit_encoder.finish();
+    assert(skewed.size() < bits.size() / 8 / 2);
+
+    // Decoding past the end is an error, not a read out of bounds
+    bool rejected = false;
+    try {
+        RangeDecoder<3> truncated(coded.data(), coded.size() / 2);
+        for (size_t i = 0; i < bits.size(); i++) {
+            truncated.get_varint(2);
+        }
+    } catch (const std::invalid_argument &) {
+        rejected = true;
+    }
+    assert(rejected);
+    cout << "Range coder passed!" << endl;
+}
+
+void testHistory() {
+    cout << "Testing the generation history..." << endl;
+    NeatParams params = snake_params();
+    params.population_size = 100;
+    params.neuron_delete_prob = 0.2;
+    params.link_delete_prob = 0.2;
+    RNG rng(params.seed);
+    Population population(params, rng);
+    // Immigrants, whose parents are not in the population
+    params.seed++;
+    RNG other_rng(params.seed);
+    Population other(params, other_rng);
+
+    std::remove(PATH.c_str());
+    vector<vector<Genome>> written;
+    size_t raw_size = 0;
+    {
+        HistoryWriter writer(PATH, *population.genome_config(), 8);
+        for (int generation = 0; generation < 30; generation++) {
+            population.evaluate(weight_fitness);
+            if (generation % 5 == 4) {
+                other.run(weight_fitness, 1);
+                other.evaluate(weight_fitness);
+                population.immigrate(other.top_genomes(5));
+            }
+            writer.append(population.generation(), population.genomes());
+            written.push_back(population.genomes());
+            for (const auto &genome : population.genomes()) {
+                raw_size += encoded_size(genome);
+            }
+            population.next_generation();
+        }
+        assert(writer.num_generations() == 30);
+        cout << "History of " << writer.bytes_written() << " bytes, "
+             << raw_size << " bytes of whole genomes" << endl;
+        assert(writer.bytes_written() * 4 < raw_size);
+    }
+
+    HistoryReader reader(PATH);
+    assert(reader.num_generations() == 30);
+    assert(reader.keyframe_interval() == 8);
+    for (size_t i = 0; i < written.size(); i++) {
+        assert(reader.block(i).generation == i);
+        assert(reader.block(i).keyframe == (i % 8 == 0));
+        assert_same(reader.generation(i, population.genome_config()), written[i]);
+    }
+    cout << "Generation history passed!" << endl;
+}
+
+void testCrash() {
+    cout << "Testing interrupted histories..." << endl;
+    NeatParams params = snake_params();
+    params.population_size = 50;
+    RNG rng(params.seed);
+    Population population(params, rng);
+    auto genome_config = population.genome_config();
+
+    std::remove(PATH.c_str());
+    vector<vector<Genome>> written;
+    {
+        HistoryWriter writer(PATH, *genome_config, 100);
+        for (int generation = 0; generation < 3; generation++) {
+            population.evaluate(weight_fitness);
+            writer.append(population.generation(), population.genomes());
+            written.push_back(population.genomes());
+            population.next_generation();
+        }
+    }
+    // The last generation is cut short
+    HistoryReader whole(PATH);
+    assert(truncate(PATH.c_str(), whole.end() - 3) == 0);
+    assert(HistoryReader(PATH).num_generations() == 2);
+
+    // and dropped by the next writer, which starts with a keyframe
+    {
+        HistoryWriter writer(PATH, *genome_config, 100);
+        assert(writer.num_generations() == 2);
+        writer.append(2, written[2]);
+        population.evaluate(weight_fitness);
+        writer.append(population.generation(), population.genomes());
+        written.push_back(population.genomes());
+    }
+    HistoryReader reader(PATH);
+    assert(reader.num_generations() == 4);
+    assert(reader.block(2).keyframe && !reader.block(3).keyframe);
+    for (size_t i = 0; i < written.size(); i++) {
+        assert_same(reader.generation(i, genome_config), written[i]);
+    }
+
+    // Not a history
+    std::remove(PATH.c_str());
+    bool missing = false;
+    try {
+        HistoryReader none(PATH);
+    } catch (const std::runtime_error &) {
+        missing = true;
+    }
+    assert(missing);
+    save_genome(PATH, written[0][0]);
+    bool rejected = false;
+    try {
+        HistoryWriter junk(PATH, *genome_config);
+    } catch (const std::invalid_argument &) {
+        rejected = true;
+    }
+    assert(rejected);
+    std::remove(PATH.c_str());
+    rmdir(test_dir().c_str());
+    cout << "Interrupted histories passed!" << endl;
+}
+
+int main() {
+    testRangeCoder();
+    testHistory();
+    testCrash();
+    return 0;
+}
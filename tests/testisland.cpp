@@ -0,0 +1,80 @@
+#include "NEAT/island.hpp"
+#include "testutil.hpp"
+#include <iostream>
+#include <cassert>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using std::cout, std::endl;
+
+void testSharedRings() {
+    cout << "Testing shared rings..." << endl;
+    SharedRings rings(1, 4, 64);
+    vector<uint8_t> message;
+    assert(!rings.pop(0, message));
+    assert(!rings.push(0, vector<uint8_t>(65)));
+
+    // A child process fills the ring, the parent reads it
+    pid_t pid = fork();
+    if (pid == 0) {
+        for (uint8_t i = 0; i < 4; i++) {
+            rings.push(0, {i, i, i});
+        }
+        _exit(rings.push(0, {4}) ? 1 : 0);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    for (uint8_t i = 0; i < 4; i++) {
+        assert(rings.pop(0, message));
+        assert(message == vector<uint8_t>({i, i, i}));
+    }
+    assert(!rings.pop(0, message));
+    cout << "Shared rings passed!" << endl;
+}
+
+void testTopology() {
+    cout << "Testing migration topology..." << endl;
+    assert(migration_targets(MigrationTopology::RING, 3, 4) == vector<int>({0}));
+    assert(migration_sources(MigrationTopology::RING, 0, 4) == vector<int>({3}));
+    assert(migration_targets(MigrationTopology::FULL, 1, 3) == vector<int>({0, 2}));
+    assert(migration_targets(MigrationTopology::RING, 0, 1).empty());
+    cout << "Migration topology passed!" << endl;
+}
+
+void compute_fitness(
+    vector<Genome>::iterator begin,
+    vector<Genome>::iterator end) {
+    for (auto it = begin; it != end; it++) {
+        // Reward large weights, so there is something to evolve
+        float fitness = 0.0f;
+        for (const auto &link : it->links()) {
+            fitness += link.is_removed() ? 0.0f : link.weight;
+        }
+        it->fitness() = fitness;
+    }
+}
+
+void testIslands() {
+    cout << "Testing islands..." << endl;
+    NeatParams params = snake_params();
+    params.population_size = 30;
+    params.max_generations = 6;
+    params.num_islands = 3;
+    params.migration_interval = 2;
+    params.migration_topology = MigrationTopology::FULL;
+
+    Genome best = run_islands(params, compute_fitness);
+    assert(best.fitness() != FitnessNotCalculated);
+    assert(!best.neurons().empty());
+    cout << "Best fitness: " << best.fitness() << endl;
+    cout << "Islands passed!" << endl;
+}
+
+int main() {
+    testSharedRings();
+    testTopology();
+    testIslands();
+
+    return 0;
+}
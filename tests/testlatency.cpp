@@ -0,0 +1,100 @@
+#include "latencyHistogram.hpp"
+#include "snakeEvaluator.hpp"
+#include "NEAT/population.hpp"
+#include "testutil.hpp"
+#include <iostream>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+using std::cout, std::endl;
+
+// Count the allocations of the whole program
+static size_t num_allocations = 0;
+
+void *operator new(size_t size) {
+    num_allocations++;
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    std::free(p);
+}
+
+void testPercentiles() {
+    cout << "Testing latency percentiles..." << endl;
+    LatencyHistogram histogram;
+    assert(histogram.percentile(50) == 0);
+    // 1..1000 us
+    for (int us = 1; us <= 1000; us++) {
+        histogram.record(std::chrono::microseconds(us));
+    }
+    assert(histogram.count() == 1000);
+    assert(histogram.max() == 1000000);
+    for (double p : {1.0, 50.0, 90.0, 99.0}) {
+        double exact = p * 10000;
+        double estimate = histogram.percentile(p);
+        assert(estimate >= exact && estimate <= exact * 1.125);
+    }
+    assert(histogram.percentile(100) == 1000000);
+
+    // Short durations are exact, long ones go to the last bucket
+    LatencyHistogram small;
+    small.record(std::chrono::nanoseconds(3));
+    assert(small.percentile(50) == 3);
+    small.record(std::chrono::hours(10));
+    assert(small.percentile(100) == small.max());
+    cout << "Latency percentiles passed!" << endl;
+}
+
+void testPolicy() {
+    cout << "Testing the network policy..." << endl;
+    NeatParams params = snake_params();
+    params.population_size = 30;
+    params.max_steps = 500;
+    RNG rng(params.seed);
+    Population population(params, rng);
+    population.run(SnakeFitness(params), 3);
+    const Genome &genome = population.best_genome();
+
+    // Plays the same game as the evaluation
+    FeedForwardNetwork network(genome);
+    EpisodeResult expected = play_episode(network, params, 11);
+    NetworkPolicy policy(genome);
+    SnakeEngine engine{params.board_width, params.board_height, params.allow_teleport, 11};
+    int steps = 0, hungry = 0;
+    GameState state = GameState::Running;
+    LatencyHistogram latency;
+    size_t allocations = 0;
+    while (state == GameState::Running && steps < params.max_steps
+        && hungry < params.hunger_steps) {
+        int score = engine._score();
+        size_t before = num_allocations;
+        auto start = std::chrono::steady_clock::now();
+        Action action = policy(engine);
+        latency.record(std::chrono::steady_clock::now() - start);
+        allocations += num_allocations - before;
+        state = engine.process(action);
+        steps++;
+        hungry = engine._score() > score ? 0 : hungry + 1;
+    }
+    assert(engine._score() == expected.score);
+    assert(steps == expected.steps);
+    // Choosing an action never allocates
+    assert(allocations == 0);
+    cout << "Inference latency: " << latency.summary() << endl;
+    cout << "Network policy passed!" << endl;
+}
+
+int main() {
+    testPercentiles();
+    testPolicy();
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include "lookahead.hpp"
+#include "NEAT/population.hpp"
+#include "testutil.hpp"
+#include <iostream>
+#include <cassert>
+
+using std::cout, std::endl;
+
+static bool same_game(const SnakeEngine &a, const SnakeEngine &b) {
+    const SnakeBody &body_a = a._snake().body, &body_b = b._snake().body;
+    return body_a.size() == body_b.size()
+        && std::equal(body_a.begin(), body_a.end(), body_b.begin())
+        && a._snake().grow == b._snake().grow && a._food() == b._food()
+        && a._score() == b._score() && a._direction() == b._direction();
+}
+
+void testSaveRestore() {
+    cout << "Testing engine save and restore..." << endl;
+    RNG rng(3);
+    for (uint64_t seed = 0; seed < 20; seed++) {
+        SnakeEngine engine{8, 8, true, seed};
+        GameState state = GameState::Running;
+        while (state == GameState::Running) {
+            // Wander off for a while, then come back
+            SnakeEngine copy = engine;
+            SnakeEngine::State saved = engine.save_state();
+            int wander = rng.next_int(64);
+            for (int i = 0; i < wander; i++) {
+                if (engine.process(static_cast<Action>(rng.next_int(2))) != GameState::Running) {
+                    break;
+                }
+            }
+            engine.restore_state(saved);
+            assert(same_game(engine, copy));
+
+            // And the restored game goes on like the copy
+            Action action = static_cast<Action>(rng.next_int(2));
+            state = engine.process(action);
+            assert(copy.process(action) == state);
+            assert(state != GameState::Running || same_game(engine, copy));
+        }
+    }
+    cout << "Engine save and restore passed!" << endl;
+}
+
+static Genome trained_genome() {
+    NeatParams params = snake_params();
+    params.population_size = 50;
+    params.max_steps = 500;
+    RNG rng(params.seed);
+    Population population(params, rng);
+    population.run(SnakeFitness(params), 5);
+    return population.best_genome();
+}
+
+void testSearch() {
+    cout << "Testing lookahead search..." << endl;
+    Genome genome = trained_genome();
+    LookaheadParams params;
+    params.depth = 3;
+    params.max_nodes = 20000;
+    // Never hit, so the search only depends on the node budget
+    params.time_budget = std::chrono::seconds(10);
+    params.board_width = 12;
+    params.board_height = 12;
+    params.num_threads = 1;
+    LookaheadSearch single(genome, params);
+    // Shown another game before each tick, so it copies the game every time
+    LookaheadSearch copying(genome, params);
+    SnakeEngine decoy{12, 12, false, 99};
+    params.num_threads = 3;
+    LookaheadSearch parallel(genome, params);
+    NetworkPolicy policy(genome);
+
+    int searched_score = 0, network_score = 0;
+    for (uint64_t seed = 0; seed < 4; seed++) {
+        SnakeEngine engine{12, 12, false, seed};
+        GameState state = GameState::Running;
+        for (int step = 0; step < 300 && state == GameState::Running; step++) {
+            Action action = single.choose(engine);
+            // The same action, whatever the number of threads
+            assert(parallel.choose(engine) == action);
+            assert(single.last_depth() == parallel.last_depth());
+            // Following the game is the same as copying it
+            copying.choose(decoy);
+            assert(copying.choose(engine) == action);
+
+            // Never a move that ends the game when another does not
+            bool safe_exists = false;
+            for (int a = 0; a < SnakeOutputs; a++) {
+                SnakeEngine copy = engine;
+                safe_exists |= copy.process(static_cast<Action>(a)) != GameState::GameOver;
+            }
+            state = engine.process(action);
+            assert(state != GameState::GameOver || !safe_exists);
+        }
+        searched_score += engine._score();
+
+        SnakeEngine alone{12, 12, false, seed};
+        state = GameState::Running;
+        for (int step = 0; step < 300 && state == GameState::Running; step++) {
+            state = alone.process(policy(alone));
+        }
+        network_score += alone._score();
+    }
+    cout << "Score with search " << searched_score << ", network alone "
+         << network_score << endl;
+
+    // Lines longer than the board has cells cannot be restored
+    params.board_width = 4;
+    params.board_height = 4;
+    bool rejected = false;
+    try {
+        LookaheadSearch small(genome, params);
+    } catch (const std::invalid_argument &) {
+        rejected = true;
+    }
+    assert(rejected);
+    // Nor can boards other than the one searched be searched
+    rejected = false;
+    try {
+        SnakeEngine larger{13, 12, false, 0};
+        single.choose(larger);
+    } catch (const std::invalid_argument &) {
+        rejected = true;
+    }
+    assert(rejected);
+    cout << "Lookahead search passed!" << endl;
+}
+
+int main() {
+    testSaveRestore();
+    testSearch();
+    return 0;
+}
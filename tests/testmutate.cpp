@@ -1,15 +1,17 @@
 #include "NEAT/genome.hpp"
+#include "testutil.hpp"
 #include <iostream>
 #include <cassert>
 
 void testMutation() {
-    Config config("config.cfg");
-    Genome genome(0, config);
-    genome.config_new(config);
+    NeatParams params = snake_params();
+    RNG rng(params.seed);
+    Genome genome(0, params);
+    genome.config_new(rng);
 
     genome.print();
 
-    genome.mutate(config);
+    genome.mutate(rng);
 
     genome.print();
 
@@ -0,0 +1,65 @@
+#include "NEAT/network.hpp"
+#include "testutil.hpp"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+
+using std::cout, std::endl;
+
+static NeatParams small_params() {
+    NeatParams params;
+    params.num_inputs = 2;
+    params.num_outputs = 2;
+    params.num_hidden = 0;
+    return params;
+}
+
+void testLinear() {
+    cout << "Testing network activation..." << endl;
+    Genome genome(0, small_params());
+    genome.add_neuron({-1, 0.0f, Activation::LINEAR});
+    genome.add_neuron({-2, 0.0f, Activation::LINEAR});
+    genome.add_neuron({0, 0.5f, Activation::LINEAR});
+    genome.add_neuron({1, 0.0f, Activation::RELU});
+    genome.add_neuron({2, 0.0f, Activation::LINEAR});
+    // Hidden neuron 2 doubles input 1, output 0 adds input 2
+    genome.add_link({{-1, 2}, 2.0f});
+    genome.add_link({{2, 0}, 1.0f});
+    genome.add_link({{-2, 0}, 1.0f});
+    genome.add_link({{-2, 1}, -1.0f});
+    // Disabled links are left out
+    genome.add_link({{-1, 1}, 100.0f}, false);
+
+    FeedForwardNetwork network(genome);
+    float inputs[2] = {1.0f, 3.0f}, outputs[2];
+    network.activate(inputs, outputs);
+    assert(std::fabs(outputs[0] - 5.5f) < 1e-6f);
+    assert(outputs[1] == 0.0f);
+    cout << "Network activation passed!" << endl;
+}
+
+void testSoftmax() {
+    cout << "Testing softmax outputs..." << endl;
+    NeatParams params = snake_params();
+    RNG rng(params.seed);
+    Genome genome(0, params);
+    genome.config_new(rng);
+
+    FeedForwardNetwork network(genome);
+    vector<float> inputs(params.num_inputs, 1.0f), outputs(params.num_outputs);
+    network.activate(inputs.data(), outputs.data());
+    float total = 0.0f;
+    for (float output : outputs) {
+        assert(output >= 0.0f && output <= 1.0f);
+        total += output;
+    }
+    assert(std::fabs(total - 1.0f) < 1e-5f);
+    cout << "Softmax outputs passed!" << endl;
+}
+
+int main() {
+    testLinear();
+    testSoftmax();
+
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include "NEAT/novelty.hpp"
+#include "NEAT/population.hpp"
+#include "snakeEvaluator.hpp"
+#include "rng.hpp"
+#include "testutil.hpp"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+
+using std::cout, std::endl;
+
+// k nearest distances by scanning every point
+static vector<float> brute_force(const vector<float> &points, size_t dim,
+    const float *query, size_t k, size_t skip) {
+    vector<float> distances;
+    for (size_t i = 0; i < points.size() / dim; i++) {
+        if (i == skip) {
+            continue;
+        }
+        float sum = 0.0f;
+        for (size_t j = 0; j < dim; j++) {
+            float d = query[j] - points[i * dim + j];
+            sum += d * d;
+        }
+        distances.push_back(std::sqrt(sum));
+    }
+    std::sort(distances.begin(), distances.end());
+    distances.resize(std::min(k, distances.size()));
+    return distances;
+}
+
+void testNearest() {
+    cout << "Testing vantage-point tree queries..." << endl;
+    RNG rng(5);
+    for (size_t dim : {1, 3, 16}) {
+        vector<float> points(2000 * dim);
+        rng.fill_uniform(points.data(), points.size());
+        VPTree tree(points.data(), 2000, dim);
+        for (size_t q = 0; q < 50; q++) {
+            size_t k = 1 + q % 20;
+            vector<float> query(dim);
+            rng.fill_uniform(query.data(), dim);
+            vector<float> expected = brute_force(points, dim, query.data(), k, SIZE_MAX);
+            vector<float> found = tree.nearest(query.data(), k);
+            assert(found.size() == k);
+            for (size_t i = 0; i < k; i++) {
+                assert(std::fabs(found[i] - expected[i]) < 1e-5f);
+            }
+
+            // Leaving out a point of the tree
+            found = tree.nearest(&points[q * dim], k, q);
+            expected = brute_force(points, dim, &points[q * dim], k, q);
+            for (size_t i = 0; i < k; i++) {
+                assert(std::fabs(found[i] - expected[i]) < 1e-5f);
+            }
+        }
+    }
+
+    // Fewer points than neighbours
+    float few[2] = {0.0f, 3.0f};
+    VPTree small(few, 2, 1);
+    assert((small.nearest(few, 5) == vector<float>{0.0f, 3.0f}));
+    assert((small.nearest(few, 5, 0) == vector<float>{3.0f}));
+    cout << "Vantage-point tree queries passed!" << endl;
+}
+
+void testNovelty() {
+    cout << "Testing novelty..." << endl;
+    NoveltyArchive archive(2, 2);
+    // A cluster and an outlier
+    vector<float> behaviours = {0.0f, 0.0f, 0.1f, 0.0f, 0.0f, 0.1f, 5.0f, 5.0f};
+    vector<float> novelty = archive.novelty(behaviours);
+    assert(std::max_element(novelty.begin(), novelty.end()) - novelty.begin() == 3);
+
+    // Once archived, a behaviour is no longer novel
+    archive.add(&behaviours[6]);
+    archive.add(&behaviours[6]);
+    assert(archive.size() == 2);
+    vector<float> again = archive.novelty({5.0f, 5.0f});
+    assert(again[0] == 0.0f);
+    cout << "Novelty passed!" << endl;
+}
+
+void testSnakeNovelty() {
+    cout << "Testing snake novelty fitness..." << endl;
+    NeatParams params = snake_params();
+    params.population_size = 50;
+    params.max_steps = 1000;
+
+    RNG rng(params.seed);
+    Population population(params, rng);
+    SnakeNoveltyFitness fitness(params);
+    population.run(fitness, 3);
+
+    const size_t dim = params.novelty_grid * params.novelty_grid;
+    assert(fitness.novelty_archive().dim() == dim);
+    assert(fitness.novelty_archive().size() == 3 * (size_t) params.novelty_archive_add);
+    const vector<float> &behaviours = fitness.behaviours();
+    for (size_t i = 0; i < behaviours.size() / dim; i++) {
+        float total = 0.0f;
+        for (size_t j = 0; j < dim; j++) {
+            assert(behaviours[i * dim + j] >= 0.0f);
+            total += behaviours[i * dim + j];
+        }
+        // Genomes that die on their first step never visit a cell
+        assert(total == 0.0f || std::fabs(total - 1.0f) < 1e-4f);
+    }
+    cout << "Snake novelty fitness passed!" << endl;
+}
+
+void testThreadedNovelty() {
+    cout << "Testing threaded snake novelty fitness..." << endl;
+    NeatParams params = snake_params();
+    params.population_size = 40;
+    params.max_steps = 500;
+
+    RNG rng(params.seed);
+    Population population(params, rng);
+    vector<Genome> serial = population.genomes();
+    vector<Genome> threaded = serial;
+    SnakeNoveltyFitness one(params), four(params, 4);
+    for (int generation = 0; generation < 2; generation++) {
+        one(serial.begin(), serial.end());
+        four(threaded.begin(), threaded.end());
+        assert(four.results().size() == threaded.size());
+        for (size_t i = 0; i < serial.size(); i++) {
+            assert(serial[i].fitness() == threaded[i].fitness());
+            assert(four.results()[i].fitness == threaded[i].fitness());
+            assert(one.results()[i].mean_steps == four.results()[i].mean_steps);
+        }
+        assert(one.behaviours() == four.behaviours());
+    }
+    assert(one.novelty_archive().size() == four.novelty_archive().size());
+    cout << "Threaded snake novelty fitness passed!" << endl;
+}
+
+void testLargeArchive() {
+    cout << "Testing novelty of a large archive..." << endl;
+    const size_t dim = 16, num_archived = 100000;
+    RNG rng(9);
+    NoveltyArchive archive(dim, 15);
+    vector<float> behaviour(dim);
+    for (size_t i = 0; i < num_archived; i++) {
+        rng.fill_uniform(behaviour.data(), dim);
+        // Behaviours are shares of the steps, mostly in a few cells
+        for (auto &share : behaviour) {
+            share = share * share * share * share;
+        }
+        archive.add(behaviour.data());
+    }
+    vector<float> generation(150 * dim);
+    rng.fill_uniform(generation.data(), generation.size());
+    vector<float> novelty = archive.novelty(generation);
+    assert(novelty.size() == 150);
+    for (float n : novelty) {
+        assert(n > 0.0f);
+    }
+    cout << "Novelty of a large archive passed!" << endl;
+}
+
+int main() {
+    testNearest();
+    testNovelty();
+    testSnakeNovelty();
+    testThreadedNovelty();
+    testLargeArchive();
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include "NEAT/params.hpp"
+#include "testutil.hpp"
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <stdexcept>
+#include <unistd.h>
+
+using std::cout, std::endl;
+
+// Config with no file behind it, filled by the tests
+static Config empty_config() {
+    return Config();
+}
+
+static bool rejects(const Config &config) {
+    try {
+        NeatParams params(config);
+    } catch (const std::invalid_argument &e) {
+        cout << "Rejected: " << e.what() << endl;
+        return true;
+    }
+    return false;
+}
+
+void testLoad() {
+    cout << "Testing NeatParams loading..." << endl;
+    const string path = test_dir() + "/testparams.cfg";
+    Config written = empty_config();
+    written.setInt("NEAT", "population_size", 40);
+    written.setInt("DefaultGenome", "num_inputs", 4);
+    written.setDouble("DefaultGenome", "neuron_delete_prob", 0.25);
+    assert(written.save(path));
+
+    Config config(path);
+    NeatParams params(config);
+    assert(params.population_size == 40);
+    assert(params.num_inputs == 4);
+    assert(params.neuron_delete_prob == 0.25);
+    assert(params.bias_max_value == NeatParams().bias_max_value);
+    std::remove(path.c_str());
+
+    // A missing file is an error, rather than a run on the defaults
+    bool failed = false;
+    try {
+        Config missing(path);
+    } catch (const std::runtime_error &) {
+        failed = true;
+    }
+    assert(failed);
+    rmdir(test_dir().c_str());
+    cout << "NeatParams loading passed!" << endl;
+}
+
+void testDefaults() {
+    cout << "Testing NeatParams defaults..." << endl;
+    Config config = empty_config();
+    config.setInt("NEAT", "population_size", 10);
+    NeatParams params(config);
+    assert(params.population_size == 10);
+    assert(params.max_generations == NeatParams().max_generations);
+    assert(params.activation == Activation::SIGMOID);
+    cout << "NeatParams defaults passed!" << endl;
+}
+
+void testValidation() {
+    cout << "Testing NeatParams validation..." << endl;
+    Config unknown = empty_config();
+    unknown.setDouble("DefaultGenome", "bias_max", 30.0);
+    assert(rejects(unknown));
+
+    Config not_a_number = empty_config();
+    not_a_number.setString("NEAT", "population_size", "150x");
+    assert(rejects(not_a_number));
+
+    Config out_of_range = empty_config();
+    out_of_range.setDouble("DefaultGenome", "link_add_prob", 1.5);
+    assert(rejects(out_of_range));
+
+    Config not_an_integer = empty_config();
+    not_an_integer.setDouble("DefaultGenome", "num_inputs", 2.5);
+    assert(rejects(not_an_integer));
+
+    Config inverted = empty_config();
+    inverted.setDouble("DefaultGenome", "weight_min_value", 1.0);
+    inverted.setDouble("DefaultGenome", "weight_max_value", -1.0);
+    assert(rejects(inverted));
+
+    Config seed = empty_config();
+    seed.setString("NEAT", "seed", "18446744073709551615");
+    assert(NeatParams(seed).seed == UINT64_MAX);
+    cout << "NeatParams validation passed!" << endl;
+}
+
+int main() {
+    testLoad();
+    testDefaults();
+    testValidation();
+
+    return 0;
+}
@@ -1,10 +1,12 @@
 #include "NEAT/population.hpp"
+#include "testutil.hpp"
 #include <iostream>
 #include <cassert>
+#include <atomic>
 
 using std::cout, std::endl;
 
-float testFitness(const Genome& genome) {
+float testFitness(const Genome&) {
     return 0.0f;
 }
 
@@ -17,17 +19,131 @@ void compute_fitness(
 }
 
 void testPopulation() {
-    Config config("config.cfg");
     RNG rng;
-    Population population(config, rng);
+    Population population(snake_params(), rng);
 
     population.run(compute_fitness, 5);
 
     cout << "Population tests passed!" << endl;
 }
 
+static size_t num_evaluated = 0;
+
+void testDuplicates() {
+    NeatParams params = snake_params();
+    params.deduplicate_evaluations = true;
+    RNG rng;
+    PopulationState state = Population(params, rng).state();
+
+    // A copy of the first genome, and a genome whose weight only differs
+    // from it below the hash resolution
+    Genome &original = state.genomes[0];
+    original.set_link(0, {original.links()[0].link_id, 0.5f});
+    Genome copy = original;
+    copy.genome_id = state.next_genome_id++;
+    Genome close = original;
+    close.genome_id = state.next_genome_id++;
+    close.set_link(0, {original.links()[0].link_id, 0.5f + HashResolution / 8});
+    assert(copy.same_genes(original));
+    assert(close.full_hash() == original.full_hash() && !close.same_genes(original));
+    state.genomes[1] = copy;
+    state.genomes[2] = close;
+    Population population(params, state);
+
+    auto clusters = population.duplicate_clusters();
+    size_t num_duplicates = 0;
+    bool found = false;
+    for (const auto &cluster : clusters) {
+        assert(cluster.size() > 1);
+        num_duplicates += cluster.size() - 1;
+        if (cluster[0] == 0) {
+            assert(cluster.size() == 2 && cluster[1] == 1);
+            found = true;
+        }
+    }
+    assert(found);
+    cout << clusters.size() << " duplicate clusters" << endl;
+
+    // Duplicates are not evaluated, and get the fitness of their original
+    size_t num_genomes = population.genomes().size();
+    auto sum_weights = [](vector<Genome>::iterator begin, vector<Genome>::iterator end) {
+        num_evaluated += end - begin;
+        for (auto it = begin; it != end; it++) {
+            float sum = 0.0f;
+            for (const auto &link : it->links()) {
+                sum += link.weight;
+            }
+            it->fitness() = sum;
+        }
+    };
+    population.evaluate(sum_weights);
+    assert(num_evaluated == num_genomes - num_duplicates);
+    auto fitness_of = [&](int genome_id) {
+        for (const auto &genome : population.genomes()) {
+            if (genome.genome_id == genome_id) {
+                return genome.fitness();
+            }
+        }
+        assert(false);
+        return 0.0f;
+    };
+    assert(fitness_of(copy.genome_id) == fitness_of(original.genome_id));
+    assert(fitness_of(close.genome_id) != fitness_of(original.genome_id));
+
+    cout << "Duplicate tests passed!" << endl;
+}
+
+void testReproducibility() {
+    // Two runs from the same seed evolve the same genomes
+    NeatParams params = snake_params();
+    RNG rng1(params.seed), rng2(params.seed);
+    Population population1(params, rng1);
+    Population population2(params, rng2);
+    population1.run(compute_fitness, 3);
+    population2.run(compute_fitness, 3);
+
+    const auto &genomes1 = population1.genomes();
+    const auto &genomes2 = population2.genomes();
+    assert(genomes1.size() == genomes2.size());
+    for (size_t i = 0; i < genomes1.size(); i++) {
+        assert(genomes1[i].full_hash() == genomes2[i].full_hash());
+    }
+
+    cout << "Reproducibility tests passed!" << endl;
+}
+
+void testSteadyState() {
+    NeatParams params = snake_params();
+    RNG rng(params.seed);
+    Population population(params, rng);
+    size_t population_size = population.genomes().size();
+
+    // Evaluation time varies a lot between genomes
+    std::atomic<size_t> evaluations{0};
+    auto evaluate = [&](const Genome &genome) {
+        evaluations++;
+        volatile uint64_t work = 0;
+        for (uint64_t i = 0; i < genome.full_hash() % 100000; i++) {
+            work = work + i;
+        }
+        return (float) genome.links().size();
+    };
+    population.run_steady_state(evaluate, 3 * population_size, 4);
+
+    assert(evaluations == 3 * population_size);
+    assert(population.genomes().size() == population_size);
+    for (const auto &genome : population.genomes()) {
+        assert(genome.fitness() != FitnessNotCalculated);
+    }
+
+    cout << "Steady-state tests passed!" << endl;
+}
+
 int main() {
     testPopulation();
+    testReproducibility();
+    testDuplicates();
+    testSteadyState();
 
     return 0;
 }
\ No newline at end of file
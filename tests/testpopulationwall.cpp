@@ -0,0 +1,99 @@
+#include "populationWall.hpp"
+#include "snakeEvaluator.hpp"
+#include "NEAT/population.hpp"
+#include "testutil.hpp"
+#include <iostream>
+#include <cassert>
+#include <chrono>
+
+using std::cout, std::endl;
+
+void testRequests() {
+    cout << "Testing wall requests..." << endl;
+    PopulationWall wall(10);
+    SnakeEngine engine{10, 10, false, 1};
+
+    // Without a request, games are not copied
+    wall.offer(0, engine, 1);
+    assert(!wall.update(0));
+    assert(wall.snapshot(0).body.empty());
+
+    // Requests take turns over the tiles
+    assert(wall.request(4) == 4);
+    assert(wall.request(4) == 4);
+    assert(wall.request(4) == 2);
+    assert(wall.request(4) == 0);
+
+    for (size_t tile = 0; tile < wall.size(); tile++) {
+        wall.offer(tile, engine, tile + 1);
+        // One frame per request
+        wall.offer(tile, engine, 100);
+    }
+    for (size_t tile = 0; tile < wall.size(); tile++) {
+        assert(wall.update(tile));
+        assert(wall.snapshot(tile).step == tile + 1);
+        assert(wall.snapshot(tile).body.size() == engine._snake().body.size());
+        assert(wall.snapshot(tile).width == 10);
+    }
+    assert(wall.request(4) == 4);
+    cout << "Wall requests passed!" << endl;
+}
+
+void testTraining() {
+    cout << "Testing a watched evaluation..." << endl;
+    NeatParams params = snake_params();
+    params.population_size = 256;
+    params.max_steps = 2000;
+
+    RNG rng(params.seed);
+    Population population(params, rng);
+    population.run(SnakeFitness(params), 5);
+    vector<Genome> genomes = population.genomes();
+    vector<Genome> watched_genomes = genomes;
+
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    SnakeFitness(params, 4)(genomes.begin(), genomes.end());
+    std::chrono::duration<double> unwatched = Clock::now() - start;
+
+    // A window drawing much faster than a screen would
+    auto wall = std::make_shared<PopulationWall>(genomes.size());
+    std::atomic<bool> done{false};
+    size_t frames = 0;
+    std::thread window([&]() {
+        while (!done.load()) {
+            wall->request(16);
+            for (size_t tile = 0; tile < wall->size(); tile++) {
+                if (wall->update(tile)) {
+                    const GameSnapshot &game = wall->snapshot(tile);
+                    assert(game.width == params.board_width);
+                    assert(!game.body.empty());
+                    frames++;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    SnakeFitness watched(params, 4);
+    watched.watch(wall);
+    start = Clock::now();
+    watched(watched_genomes.begin(), watched_genomes.end());
+    std::chrono::duration<double> with_wall = Clock::now() - start;
+    done = true;
+    window.join();
+
+    // Watching does not change the evaluation
+    for (size_t i = 0; i < genomes.size(); i++) {
+        assert(genomes[i].fitness() == watched_genomes[i].fitness());
+    }
+    assert(frames > 0);
+    cout << "Evaluated in " << unwatched.count() << "s, watched in "
+         << with_wall.count() << "s, " << frames << " frames" << endl;
+    cout << "Watched evaluation passed!" << endl;
+}
+
+int main() {
+    testRequests();
+    testTraining();
+    return 0;
+}
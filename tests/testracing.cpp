@@ -0,0 +1,139 @@
+#include "NEAT/racing.hpp"
+#include "NEAT/population.hpp"
+#include "snakeEvaluator.hpp"
+#include "rng.hpp"
+#include "testutil.hpp"
+#include <iostream>
+#include <cassert>
+#include <numeric>
+
+using std::cout, std::endl;
+
+// Indices of the n highest values
+static vector<size_t> top(const vector<float> &values, size_t n) {
+    vector<size_t> indices(values.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    std::partial_sort(indices.begin(), indices.begin() + n, indices.end(),
+        [&](size_t a, size_t b) { return values[a] > values[b]; });
+    indices.resize(n);
+    std::sort(indices.begin(), indices.end());
+    return indices;
+}
+
+void testElimination() {
+    cout << "Testing race elimination..." << endl;
+    Race race(4, 2, 1.96);
+    // One sample gives no confidence interval
+    for (size_t genome = 0; genome < 4; genome++) {
+        race.record(genome, genome);
+    }
+    assert(race.eliminate() == 0);
+    // Without noise, everything below the two best goes
+    for (size_t genome = 0; genome < 4; genome++) {
+        race.record(genome, genome);
+    }
+    assert(race.eliminate() == 2);
+    assert((race.contenders() == vector<size_t>{2, 3}));
+    assert(race.mean(3) == 3.0);
+    assert(race.episodes(3) == 2);
+
+    // A survivor whose mean drops in later rounds still ranks above the
+    // eliminated genomes, which keep their order among themselves
+    Race late(3, 1, 1.96);
+    for (size_t genome = 0; genome < 3; genome++) {
+        late.record(genome, 5.0 * genome);
+        late.record(genome, 5.0 * genome);
+    }
+    assert(late.eliminate() == 2);
+    for (int episode = 0; episode < 4; episode++) {
+        late.record(2, 0.0);
+    }
+    assert(late.mean(2) < late.mean(1));
+    vector<float> fitness = late.fitness();
+    assert(fitness[0] < fitness[1] && fitness[1] < fitness[2]);
+    assert(fitness[0] == 0.0f && fitness[2] == (float) late.mean(2));
+    cout << "Race elimination passed!" << endl;
+}
+
+void testNoisyRace() {
+    cout << "Testing racing on noisy genomes..." << endl;
+    NeatParams params;
+    params.survival_threshold = 0.2;
+    params.racing_min_episodes = 2;
+    params.racing_max_episodes = 16;
+    params.racing_z = 1.96;
+
+    // Genome g has mean fitness g / 2 and unit noise
+    const size_t num_genomes = 100;
+    auto play = [](size_t genome, int episode) {
+        return genome * 0.5 + RNG::stream(7, genome, episode).gaussian(0.0, 1.0);
+    };
+
+    RacingStats stats;
+    vector<float> raced = race(num_genomes, play, params, &stats);
+
+    vector<float> full(num_genomes);
+    for (size_t genome = 0; genome < num_genomes; genome++) {
+        double sum = 0.0;
+        for (int episode = 0; episode < params.racing_max_episodes; episode++) {
+            sum += play(genome, episode);
+        }
+        full[genome] = sum / params.racing_max_episodes;
+    }
+
+    // Same survivors as playing every episode, for a fraction of the episodes
+    assert(top(raced, 20) == top(full, 20));
+    assert(stats.full_episodes == num_genomes * 16);
+    assert(stats.episodes * 2 < stats.full_episodes);
+    assert(stats.eliminated >= num_genomes - 20);
+    cout << "Raced " << stats.episodes << " of " << stats.full_episodes
+         << " episodes in " << stats.rounds << " rounds" << endl;
+    cout << "Racing on noisy genomes passed!" << endl;
+}
+
+void testSnakeRacing() {
+    cout << "Testing snake racing fitness..." << endl;
+    NeatParams params = snake_params();
+    params.population_size = 30;
+    params.racing_min_episodes = 2;
+    params.racing_max_episodes = 8;
+
+    RNG rng(params.seed);
+    Population population(params, rng);
+    population.evaluate(SnakeFitness(params));
+    population.next_generation();
+    vector<Genome> serial = population.genomes(), parallel = serial;
+
+    // Every genome gets a fitness, the same on any number of threads
+    SnakeRacingFitness one_thread(params), four_threads(params, 4);
+    one_thread(serial.begin(), serial.end());
+    four_threads(parallel.begin(), parallel.end());
+    for (size_t i = 0; i < serial.size(); i++) {
+        assert(serial[i].fitness() != FitnessNotCalculated);
+        assert(serial[i].fitness() == parallel[i].fitness());
+    }
+    const RacingStats &stats = four_threads.stats();
+    assert(stats.full_episodes == serial.size() * 8);
+    assert(stats.episodes >= serial.size() * 2 && stats.episodes <= stats.full_episodes);
+
+    // Genomes the snake cannot play are rejected, as by SnakeFitness
+    params.num_inputs = 5;
+    auto genome_config = std::make_shared<const GenomeConfig>(params);
+    vector<Genome> wrong{Genome(0, genome_config)};
+    wrong[0].config_new(rng);
+    bool rejected = false;
+    try {
+        four_threads(wrong.begin(), wrong.end());
+    } catch (const std::invalid_argument &) {
+        rejected = true;
+    }
+    assert(rejected);
+    cout << "Snake racing fitness passed!" << endl;
+}
+
+int main() {
+    testElimination();
+    testNoisyRace();
+    testSnakeRacing();
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include "rng.hpp"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+
+using std::cout, std::endl;
+
+void testSeeding() {
+    cout << "Testing RNG seeding..." << endl;
+    RNG a(42), b(42), c(43);
+    for (int i = 0; i < 100; i++) {
+        uint64_t x = a.next();
+        assert(x == b.next());
+        assert(x != c.next());
+    }
+    cout << "RNG seeding passed!" << endl;
+}
+
+void testStreams() {
+    cout << "Testing RNG streams..." << endl;
+    RNG s1 = RNG::stream(42, 0), s2 = RNG::stream(42, 0);
+    RNG s3 = RNG::stream(42, 1), s4 = RNG::stream(42, 0, 1);
+    uint64_t x = s1.next();
+    assert(x == s2.next());
+    assert(x != s3.next());
+    assert(x != s4.next());
+
+    RNG jumped(42);
+    jumped.jump();
+    assert(jumped.next() != RNG(42).next());
+    cout << "RNG streams passed!" << endl;
+}
+
+void testRanges() {
+    cout << "Testing RNG ranges..." << endl;
+    RNG rng(7);
+    for (int i = 0; i < 10000; i++) {
+        int n = rng.next_int(5, -3);
+        assert(n >= -3 && n <= 5);
+        double u = rng.uniform();
+        assert(u >= 0.0 && u < 1.0);
+    }
+    cout << "RNG ranges passed!" << endl;
+}
+
+void testBulkSampling() {
+    cout << "Testing RNG bulk sampling..." << endl;
+    RNG rng(11);
+    const size_t n = 100001;
+    vector<float> values(n);
+
+    rng.fill_uniform(values.data(), n, -2.0f, 2.0f);
+    double sum = 0.0;
+    for (float v : values) {
+        assert(v >= -2.0f && v < 2.0f);
+        sum += v;
+    }
+    assert(std::abs(sum / n) < 0.05);
+
+    rng.fill_gaussian(values.data(), n, 1.0f, 2.0f);
+    double mean = 0.0, var = 0.0;
+    for (float v : values) {
+        mean += v;
+    }
+    mean /= n;
+    for (float v : values) {
+        var += (v - mean) * (v - mean);
+    }
+    var /= n;
+    assert(std::abs(mean - 1.0) < 0.05);
+    assert(std::abs(std::sqrt(var) - 2.0) < 0.05);
+
+    vector<uint8_t> mask(n);
+    rng.fill_bernoulli_mask(mask.data(), n, 0.3);
+    size_t ones = 0;
+    for (uint8_t m : mask) {
+        ones += m;
+    }
+    assert(std::abs((double) ones / n - 0.3) < 0.01);
+    cout << "RNG bulk sampling passed!" << endl;
+}
+
+int main() {
+    testSeeding();
+    testStreams();
+    testRanges();
+    testBulkSampling();
+    cout << "All tests passed!" << endl;
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include "NEAT/selection.hpp"
+#include "NEAT/population.hpp"
+#include "testutil.hpp"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+
+using std::cout, std::endl;
+
+// Share of draws of each candidate
+static vector<double> frequencies(const ParentSelector &selector, size_t n, int draws) {
+    RNG rng(3);
+    vector<double> counts(n, 0.0);
+    for (int i = 0; i < draws; i++) {
+        counts[selector.choose(rng)]++;
+    }
+    for (auto &count : counts) {
+        count /= draws;
+    }
+    return counts;
+}
+
+void testAliasTable() {
+    cout << "Testing alias table..." << endl;
+    vector<double> weights = {1.0, 0.0, 3.0, 4.0, 2.0};
+    AliasTable table(weights);
+    RNG rng(1);
+    vector<int> counts(weights.size(), 0);
+    const int draws = 200000;
+    for (int i = 0; i < draws; i++) {
+        counts[table.sample(rng)]++;
+    }
+    assert(counts[1] == 0);
+    for (size_t i = 0; i < weights.size(); i++) {
+        assert(std::fabs(counts[i] / (double) draws - weights[i] / 10.0) < 0.01);
+    }
+
+    bool threw = false;
+    try {
+        AliasTable empty(vector<double>{0.0, 0.0});
+    } catch (const std::invalid_argument &) {
+        threw = true;
+    }
+    assert(threw);
+    cout << "Alias table passed!" << endl;
+}
+
+void testMethods() {
+    cout << "Testing selection methods..." << endl;
+    vector<float> fitness = {-1.0f, 1.0f, 3.0f, 1.0f};
+    NeatParams params;
+
+    params.selection = SelectionMethod::UNIFORM;
+    for (double f : frequencies(ParentSelector(fitness, params), 4, 100000)) {
+        assert(std::fabs(f - 0.25) < 0.01);
+    }
+
+    // Weights are fitness above the worst, plus 1% of the spread:
+    // 0.04, 2.04, 4.04, 2.04
+    params.selection = SelectionMethod::PROPORTIONAL;
+    vector<double> f = frequencies(ParentSelector(fitness, params), 4, 100000);
+    assert(f[0] > 0.0 && f[0] < 0.01);
+    assert(std::fabs(f[1] - 0.25) < 0.01 && std::fabs(f[2] - 0.5) < 0.01);
+
+    // Ranks 1, 2.5, 4, 2.5
+    params.selection = SelectionMethod::RANK;
+    f = frequencies(ParentSelector(fitness, params), 4, 100000);
+    assert(std::fabs(f[0] - 0.1) < 0.01 && std::fabs(f[1] - 0.25) < 0.01);
+    assert(std::fabs(f[2] - 0.4) < 0.01 && std::fabs(f[3] - 0.25) < 0.01);
+
+    // The best of 2 draws is the best candidate with 1 - (3/4)^2
+    params.selection = SelectionMethod::TOURNAMENT;
+    params.tournament_size = 2;
+    f = frequencies(ParentSelector(fitness, params), 4, 100000);
+    assert(std::fabs(f[2] - 7.0 / 16) < 0.01);
+    assert(std::fabs(f[0] - 1.0 / 16) < 0.01);
+
+    // Equal fitness falls back to uniform
+    params.selection = SelectionMethod::PROPORTIONAL;
+    for (double share : frequencies(ParentSelector({2.0f, 2.0f}, params), 2, 100000)) {
+        assert(std::fabs(share - 0.5) < 0.01);
+    }
+    cout << "Selection methods passed!" << endl;
+}
+
+void testLargePopulation() {
+    cout << "Testing selection from a million candidates..." << endl;
+    const size_t n = 1000000;
+    vector<float> fitness(n);
+    RNG rng(8);
+    rng.fill_uniform(fitness.data(), n, 0.0f, 10.0f);
+    NeatParams params;
+    params.selection = SelectionMethod::PROPORTIONAL;
+    ParentSelector selector(fitness, params);
+    double mean = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        mean += fitness[selector.choose(rng)];
+    }
+    // Drawn in proportion to fitness, uniform fitness averages 2/3 of the top
+    mean /= n;
+    assert(std::fabs(mean - 20.0 / 3) < 0.05);
+    cout << "Selection from a million candidates passed!" << endl;
+}
+
+void testPopulation() {
+    cout << "Testing population with tournament selection..." << endl;
+    NeatParams params = snake_params();
+    params.selection = SelectionMethod::TOURNAMENT;
+    RNG rng(params.seed);
+    Population population(params, rng);
+    population.run([](vector<Genome>::iterator begin, vector<Genome>::iterator end) {
+        for (auto it = begin; it != end; it++) {
+            it->fitness() = it->num_hidden() + 1;
+        }
+    }, 3);
+    assert(population.best_genome().fitness() > 0);
+    cout << "Population with tournament selection passed!" << endl;
+}
+
+int main() {
+    testAliasTable();
+    testMethods();
+    testLargePopulation();
+    testPopulation();
+    return 0;
+}
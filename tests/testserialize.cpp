@@ -0,0 +1,85 @@
+#include "NEAT/serialize.hpp"
+#include "testutil.hpp"
+#include <iostream>
+#include <cassert>
+#include <stdexcept>
+#include <cstdio>
+
+using std::cout, std::endl;
+
+void testRoundTrip() {
+    cout << "Testing genome encoding..." << endl;
+    NeatParams params = snake_params();
+    RNG rng(params.seed);
+    Genome genome(7, params);
+    genome.config_new(rng);
+    for (int i = 0; i < 20; i++) {
+        genome.mutate(rng);
+    }
+    genome.fitness() = 12.5f;
+
+    vector<uint8_t> buffer;
+    encode_genome(genome, buffer);
+    assert(buffer.size() == encoded_size(genome));
+
+    Genome decoded(-1, genome.genome_config());
+    size_t used = decode_genome(buffer.data(), buffer.size(),
+        genome.genome_config(), decoded);
+    assert(used == buffer.size());
+    assert(decoded.genome_id == 7);
+    assert(decoded.fitness() == 12.5f);
+    assert(decoded.num_hidden() == genome.num_hidden());
+    assert(decoded.full_hash() == genome.full_hash());
+    cout << "Genome encoding passed!" << endl;
+}
+
+void testTruncated() {
+    cout << "Testing truncated encoding..." << endl;
+    NeatParams params = snake_params();
+    RNG rng(params.seed);
+    Genome genome(0, params);
+    genome.config_new(rng);
+
+    vector<uint8_t> buffer;
+    encode_genome(genome, buffer);
+    bool rejected = false;
+    try {
+        decode_genome(buffer.data(), buffer.size() - 1, genome.genome_config(), genome);
+    } catch (const std::invalid_argument &) {
+        rejected = true;
+    }
+    assert(rejected);
+    cout << "Truncated encoding passed!" << endl;
+}
+
+void testFile() {
+    cout << "Testing genome files..." << endl;
+    NeatParams params = snake_params();
+    RNG rng(params.seed);
+    Genome genome(3, params);
+    genome.config_new(rng);
+    genome.mutate(rng);
+
+    save_genome("/tmp/testserialize.genome", genome);
+    Genome loaded = load_genome("/tmp/testserialize.genome", genome.genome_config());
+    assert(loaded.genome_id == 3);
+    assert(loaded.full_hash() == genome.full_hash());
+    std::remove("/tmp/testserialize.genome");
+
+    bool missing = false;
+    try {
+        load_genome("/tmp/testserialize.genome", genome.genome_config());
+    } catch (const std::runtime_error &) {
+        missing = true;
+    }
+    assert(missing);
+    cout << "Genome files passed!" << endl;
+}
+
+int main() {
+    testRoundTrip();
+    testTruncated();
+    testFile();
+
+    return 0;
+}
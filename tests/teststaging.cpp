@@ -0,0 +1,122 @@
+#include "NEAT/staging.hpp"
+#include "NEAT/population.hpp"
+#include "snakeEvaluator.hpp"
+#include "testutil.hpp"
+#include <iostream>
+#include <cassert>
+
+using std::cout, std::endl;
+
+void testCutoff() {
+    cout << "Testing screening cutoff..." << endl;
+    NeatParams params;
+    params.survival_threshold = 0.2;
+    params.screening_percentile = 0.5;
+    vector<float> screening = {0, 9, 1, 8, 2, 7, 3, 6, 4, 5};
+    vector<bool> passed = screening_cutoff(screening, params);
+    for (size_t i = 0; i < screening.size(); i++) {
+        assert(passed[i] == (screening[i] >= 5));
+    }
+
+    // Ties with the cutoff pass
+    vector<float> ties = {0, 1, 1, 1, 2};
+    params.screening_percentile = 0.4;
+    assert((screening_cutoff(ties, params) == vector<bool>{false, true, true, true, true}));
+
+    // The survivors of selection always pass
+    params.screening_percentile = 1.0;
+    passed = screening_cutoff(screening, params);
+    assert(std::count(passed.begin(), passed.end(), true) == 2);
+    assert(passed[1] && passed[3]);
+
+    // No genomes, nothing played
+    StagingStats stats;
+    auto never = [](size_t) -> StageResult { assert(false); return {0.0f, 0}; };
+    assert(staged(0, never, never, params, &stats).empty());
+    assert(stats.screened_out == 0 && stats.steps_saved == 0);
+    cout << "Screening cutoff passed!" << endl;
+}
+
+void testRankScreenedOut() {
+    cout << "Testing ranking of screened out genomes..." << endl;
+    vector<float> fitness = {3.0f, 0.0f, 5.0f, 0.0f};
+    vector<float> screening = {10.0f, 4.0f, 12.0f, 2.0f};
+    vector<bool> passed = {true, false, true, false};
+    rank_screened_out(fitness, screening, passed);
+    assert(fitness[0] == 3.0f && fitness[2] == 5.0f);
+    assert(fitness[1] == 2.0f);
+    assert(fitness[3] == 0.0f);
+    cout << "Ranking of screened out genomes passed!" << endl;
+}
+
+void testSnakeStaged() {
+    cout << "Testing staged snake evaluation..." << endl;
+    NeatParams params = snake_params();
+    params.population_size = 60;
+    params.max_steps = 2000;
+    params.board_width = 30;
+    params.board_height = 30;
+
+    RNG rng(params.seed);
+    Population population(params, rng);
+    population.run(SnakeFitness(params), 3);
+    vector<Genome> genomes = population.genomes(), parallel = genomes;
+
+    SnakeStagedFitness staged_fitness(params);
+    staged_fitness(genomes.begin(), genomes.end());
+    const StagingStats &stats = staged_fitness.stats();
+    assert(stats.screened_out > 0);
+    assert(stats.screened_out <= genomes.size() * params.screening_percentile);
+
+    // The same on any number of threads, with a result for every genome,
+    // the screened out ones counting as aborted
+    SnakeStagedFitness four_threads(params, 4);
+    four_threads(parallel.begin(), parallel.end());
+    assert(four_threads.stats().full_steps == stats.full_steps);
+    assert(four_threads.results().size() == genomes.size());
+    size_t num_aborted = 0;
+    for (size_t i = 0; i < genomes.size(); i++) {
+        assert(parallel[i].fitness() == genomes[i].fitness());
+        assert(four_threads.results()[i].fitness == genomes[i].fitness());
+        num_aborted += four_threads.results()[i].aborted;
+    }
+    assert(num_aborted == stats.screened_out);
+
+    // Every genome that passed ranks above every genome screened out,
+    // and has the fitness of a full evaluation
+    SnakeFitness full_fitness(params);
+    vector<Genome> full = genomes;
+    full_fitness(full.begin(), full.end());
+    uint64_t full_steps = 0;
+    SeedSchedule seeds(params);
+    uint64_t seed = seeds.next();
+    float lowest_passed = std::numeric_limits<float>::max();
+    for (size_t i = 0; i < genomes.size(); i++) {
+        EvaluationResult result = evaluate_genome(full[i],
+            params, SeedSchedule::genome_seed(seed, i, params));
+        full_steps += std::llround(result.mean_steps * params.episodes_per_genome);
+        if (genomes[i].fitness() == full[i].fitness()) {
+            lowest_passed = std::min(lowest_passed, genomes[i].fitness());
+        }
+    }
+    size_t below = 0;
+    for (const Genome &genome : genomes) {
+        below += genome.fitness() < lowest_passed;
+    }
+    assert(below == stats.screened_out);
+
+    cout << "Screening " << stats.screening_steps << " steps, full "
+         << stats.full_steps << " steps, against " << full_steps
+         << " steps without screening (estimated saving " << stats.steps_saved
+         << ")" << endl;
+    assert(stats.screening_steps + stats.full_steps < full_steps);
+    assert(stats.steps_saved > 0);
+    cout << "Staged snake evaluation passed!" << endl;
+}
+
+int main() {
+    testCutoff();
+    testRankScreenedOut();
+    testSnakeStaged();
+    return 0;
+}
@@ -0,0 +1,197 @@
+#include "NEAT/stats.hpp"
+#include "NEAT/spsc_queue.hpp"
+#include "testutil.hpp"
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+
+using std::cout, std::endl;
+
+static const string CSV_PATH = test_dir() + "/teststats.csv";
+static const string BINARY_PATH = test_dir() + "/teststats.stats";
+
+static GenerationStats make_stats(uint64_t generation) {
+    GenerationStats stats{};
+    stats.generation = generation;
+    stats.num_genomes = 150;
+    stats.num_evaluations = 150;
+    stats.num_aborted = generation % 7;
+    stats.fitness = {0.5f, 1.0f, 1.5f + generation, 2.0f, 10.0f, 1.75f};
+    stats.links.max = generation * 0.25f;
+    stats.episode_steps.median = 100.0f + generation;
+    stats.evaluations_per_second = 1234.5 + generation;
+    stats.evaluate_seconds = 0.125;
+    stats.reproduce_seconds = 1e-3 * generation;
+    stats.save_seconds = 2e-4;
+    return stats;
+}
+
+void testQueue() {
+    cout << "Testing the lock-free queue..." << endl;
+    SpscQueue<uint64_t, 8> queue;
+    uint64_t value;
+    assert(!queue.try_pop(value));
+    for (uint64_t i = 0; i < 8; i++) {
+        assert(queue.try_push(i));
+    }
+    assert(!queue.try_push(8));
+    assert(queue.try_pop(value) && value == 0);
+    assert(queue.try_push(8));
+
+    // Every value arrives once, in order, across threads
+    SpscQueue<uint64_t, 64> shared;
+    const uint64_t count = 100000;
+    std::thread producer([&]() {
+        for (uint64_t i = 0; i < count; i++) {
+            while (!shared.try_push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    for (uint64_t expected = 0; expected < count;) {
+        if (shared.try_pop(value)) {
+            assert(value == expected);
+            expected++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    assert(!shared.try_pop(value));
+    cout << "Lock-free queue passed!" << endl;
+}
+
+void testMeasure() {
+    cout << "Testing generation stats..." << endl;
+    vector<float> values;
+    for (int i = 101; i >= 1; i--) {
+        values.push_back(i);
+    }
+    Distribution d = describe(values);
+    assert(d.min == 1 && d.p25 == 26 && d.median == 51 && d.p75 == 76 && d.max == 101);
+    assert(d.mean == 51);
+    d = describe({});
+    assert(d.min == 0 && d.max == 0 && d.mean == 0);
+
+    NeatParams params = snake_params();
+    auto genome_config = std::make_shared<const GenomeConfig>(params);
+    RNG rng(params.seed);
+    vector<Genome> genomes;
+    vector<EvaluationResult> results;
+    for (int i = 0; i < 4; i++) {
+        genomes.emplace_back(i, genome_config);
+        genomes.back().config_new(rng);
+        genomes.back().fitness() = i;
+        results.push_back({(float) i, 0.0f, 10.0f * i, i == 3});
+    }
+    genomes[0].add_neuron({1000, 0.5, Activation::SIGMOID});
+    genomes[1].add_neuron({1000, 0.5, Activation::SIGMOID});
+    // Removed neurons are not counted
+    genomes[1].remove_neuron(genomes[1].neurons().size() - 1);
+
+    GenerationStats stats = measure_generation(7, genomes, results, 0.5);
+    assert(stats.generation == 7);
+    assert(stats.num_genomes == 4 && stats.num_evaluations == 4);
+    assert(stats.num_aborted == 1);
+    assert(stats.fitness.min == 0 && stats.fitness.max == 3 && stats.fitness.mean == 1.5f);
+    // Aborted evaluations leave the episode lengths out
+    assert(stats.episode_steps.max == 20);
+    assert(stats.neurons.max == stats.neurons.min + 1);
+    assert(stats.evaluations_per_second == 8.0);
+    assert(stats.reproduce_seconds == 0.0 && stats.save_seconds == 0.0);
+    cout << "Generation stats passed!" << endl;
+}
+
+void testLogger() {
+    cout << "Testing the stats logger..." << endl;
+    const auto &columns = stats_columns();
+    const int num_rows = 300;
+    size_t dropped;
+    {
+        StatsLogger logger(CSV_PATH, BINARY_PATH);
+        for (int i = 0; i < num_rows; i++) {
+            logger.log(make_stats(i));
+            if (i % 50 == 49) {
+                // At least one row group per 50 rows, and never enough
+                // queued for any to be dropped
+                logger.flush();
+            }
+        }
+        dropped = logger.num_dropped();
+        assert(logger.ok());
+    }
+    assert(dropped == 0);
+
+    // One CSV line per generation, after the column names
+    std::ifstream csv(CSV_PATH);
+    string line;
+    std::getline(csv, line);
+    assert(line.rfind("generation,num_genomes,num_evaluations,num_aborted,fitness_min,", 0) == 0);
+    int lines = 0;
+    while (std::getline(csv, line)) {
+        lines++;
+    }
+    assert(lines == num_rows);
+
+    StatsTable table = read_stats(BINARY_PATH);
+    assert(table.names.size() == columns.size());
+    for (size_t c = 0; c < columns.size(); c++) {
+        assert(table.names[c] == columns[c].name);
+        assert(table.columns[c].size() == (size_t) num_rows);
+        for (int r = 0; r < num_rows; r++) {
+            assert(table.columns[c][r] == columns[c].value(make_stats(r)));
+        }
+    }
+    assert(table.column("fitness_median")[10] == 11.5);
+    assert(table.column("reproduce_seconds")[20] == 1e-3 * 20);
+
+    // A row group cut short by a crash is left out
+    std::streamoff size = std::ifstream(BINARY_PATH, std::ios::ate | std::ios::binary).tellg();
+    assert(truncate(BINARY_PATH.c_str(), size - 5) == 0);
+    StatsTable cut = read_stats(BINARY_PATH);
+    assert(!cut.columns[0].empty() && cut.columns[0].size() < (size_t) num_rows);
+
+    // Logging never waits: records the writer cannot keep up with are
+    // dropped and counted, see testQueue() for the queue filling up
+    const size_t num_logged = 10000;
+    size_t logged = 0;
+    {
+        StatsLogger logger("", BINARY_PATH);
+        for (size_t i = 0; i < num_logged; i++) {
+            logged += logger.log(make_stats(i));
+        }
+        dropped = logger.num_dropped();
+    }
+    assert(logged + dropped == num_logged);
+    StatsTable partial = read_stats(BINARY_PATH);
+    assert(partial.columns[0].size() == logged);
+
+    bool rejected = false;
+    try {
+        read_stats(CSV_PATH);
+    } catch (const std::invalid_argument &) {
+        rejected = true;
+    }
+    assert(rejected);
+    bool failed = false;
+    try {
+        StatsLogger logger("/nonexistent/stats.csv", "");
+    } catch (const std::runtime_error &) {
+        failed = true;
+    }
+    assert(failed);
+    std::remove(CSV_PATH.c_str());
+    std::remove(BINARY_PATH.c_str());
+    rmdir(test_dir().c_str());
+    cout << "Stats logger passed!" << endl;
+}
+
+int main() {
+    testQueue();
+    testMeasure();
+    testLogger();
+    return 0;
+}
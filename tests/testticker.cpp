@@ -0,0 +1,56 @@
+#include "ticker.hpp"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+
+using std::cout, std::endl;
+
+void testAdvance() {
+    cout << "Testing fixed timestep..." << endl;
+    Ticker ticker(10.0);
+    // Fractions of a step carry over
+    assert(ticker.advance(Ticker::Seconds(0.05)) == 0);
+    assert(ticker.advance(Ticker::Seconds(0.06)) == 1);
+    assert(ticker.advance(Ticker::Seconds(0.2)) == 2);
+    // A long stall only owes MAX_BACKLOG worth of steps
+    assert(ticker.advance(Ticker::Seconds(10.0)) == 2);
+    cout << "Fixed timestep passed!" << endl;
+}
+
+void testFastForward() {
+    cout << "Testing fast-forward..." << endl;
+    Ticker ticker(15.0, 60.0);
+    assert(ticker.frame_duration().count() == 1.0 / 15.0);
+    ticker.setSpeed(100.0);
+    // 1500 steps per second, drawn 60 times per second
+    assert(ticker.frame_duration().count() == 1.0 / 60.0);
+    assert(ticker.advance(Ticker::Seconds(1.0 / 60.0)) == 25);
+    ticker.setSpeed(1e6);
+    assert(ticker.getSpeed() == Ticker::MAX_SPEED);
+    ticker.setSpeed(0.1);
+    assert(ticker.getSpeed() == Ticker::MIN_SPEED);
+    cout << "Fast-forward passed!" << endl;
+}
+
+void testWait() {
+    cout << "Testing paced waiting..." << endl;
+    Ticker ticker(100.0, 100.0);
+    auto start = Ticker::Clock::now();
+    int steps = 0;
+    for (int frame = 0; frame < 20; frame++) {
+        steps += ticker.wait();
+    }
+    double elapsed = Ticker::Seconds(Ticker::Clock::now() - start).count();
+    // 20 frames of 10ms, slept rather than spun, and one step per 10ms
+    // of the 19 intervals between them
+    assert(elapsed >= 0.18);
+    assert(std::abs(steps - elapsed * 100) <= 2);
+    cout << "Paced waiting passed!" << endl;
+}
+
+int main() {
+    testAdvance();
+    testFastForward();
+    testWait();
+    return 0;
+}
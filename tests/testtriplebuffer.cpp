@@ -0,0 +1,81 @@
+#include "tripleBuffer.hpp"
+#include "gameSnapshot.hpp"
+#include <iostream>
+#include <cassert>
+#include <thread>
+
+using std::cout, std::endl;
+
+void testHandOver() {
+    cout << "Testing triple buffer hand-over..." << endl;
+    TripleBuffer<int> buffer;
+    // Nothing published yet
+    assert(!buffer.update());
+
+    buffer.write_buffer() = 1;
+    buffer.publish();
+    assert(buffer.update());
+    assert(buffer.read_buffer() == 1);
+    // The reader keeps its slot until something new comes
+    assert(!buffer.update());
+    assert(buffer.read_buffer() == 1);
+
+    // Only the latest of several values is taken
+    for (int value = 2; value <= 5; value++) {
+        buffer.write_buffer() = value;
+        buffer.publish();
+        assert(buffer.read_buffer() == 1);
+    }
+    assert(buffer.update());
+    assert(buffer.read_buffer() == 5);
+    cout << "Triple buffer hand-over passed!" << endl;
+}
+
+void testSnapshots() {
+    cout << "Testing snapshots across threads..." << endl;
+    TripleBuffer<GameSnapshot> buffer;
+    const uint64_t last_step = 200000;
+
+    // The writer plays a game, and writes the step into every piece of
+    // the snapshot, so a torn read would show mismatched values
+    std::thread writer([&]() {
+        SnakeEngine engine{10, 10, true, 1};
+        for (uint64_t step = 1; step <= last_step; step++) {
+            if (engine.process(Action::DoNothing) != GameState::Running) {
+                engine = SnakeEngine{10, 10, true, step};
+            }
+            GameSnapshot &snapshot = buffer.write_buffer();
+            snapshot.capture(engine, GameState::Running, step);
+            snapshot.score = static_cast<int>(step);
+            snapshot.body.assign(1 + step % 7, {static_cast<int>(step), 0});
+            buffer.publish();
+        }
+    });
+
+    uint64_t seen = 0;
+    size_t updates = 0;
+    while (seen < last_step) {
+        if (!buffer.update()) {
+            continue;
+        }
+        const GameSnapshot &snapshot = buffer.read_buffer();
+        assert(snapshot.step > seen);
+        assert(snapshot.score == static_cast<int>(snapshot.step));
+        assert(snapshot.body.size() == 1 + snapshot.step % 7);
+        for (const Coordinates &piece : snapshot.body) {
+            assert(piece.row == static_cast<int>(snapshot.step));
+        }
+        seen = snapshot.step;
+        updates++;
+    }
+    writer.join();
+    assert(updates > 0);
+    cout << "Read " << updates << " of " << last_step << " snapshots" << endl;
+    cout << "Snapshots across threads passed!" << endl;
+}
+
+int main() {
+    testHandOver();
+    testSnapshots();
+    return 0;
+}
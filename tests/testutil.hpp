@@ -0,0 +1,50 @@
+// testutil.hpp
+
+#ifndef TESTUTIL_HPP
+#define TESTUTIL_HPP
+
+#include <cassert>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "NEAT/genome.hpp"
+#include "NEAT/params.hpp"
+
+// Helpers shared by the tests
+
+// The parameters of config.cfg, set in code so that the tests run from
+// any directory
+inline NeatParams snake_params() {
+    NeatParams params;
+    params.seed = 1;
+    params.num_inputs = 4;
+    return params;
+}
+
+// A directory of its own for the files of a test, so parallel runs do
+// not share them. The test removes it once it is empty.
+inline const std::string &test_dir() {
+    static const std::string dir = []() {
+        const char *tmp = std::getenv("TMPDIR");
+        std::string pattern = std::string(tmp && *tmp ? tmp : "/tmp") + "/neattest.XXXXXX";
+        char *dir = mkdtemp(&pattern[0]);
+        assert(dir != nullptr);
+        return pattern;
+    }();
+    return dir;
+}
+
+// Deterministic fitness, the sum of the enabled weights, so runs can be
+// compared
+inline void weight_fitness(std::vector<Genome>::iterator begin,
+    std::vector<Genome>::iterator end) {
+    for (auto it = begin; it != end; it++) {
+        float sum = 0.0f;
+        for (size_t i = 0; i < it->links().size(); i++) {
+            sum += it->is_enabled(i) ? it->links()[i].weight : 0.0f;
+        }
+        it->fitness() = sum;
+    }
+}
+
+#endif // TESTUTIL_HPP